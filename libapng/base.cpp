@@ -33,9 +33,7 @@ quint32 Base::convert(const QByteArray& rba) const
 
 quint32 Base::crc(const Chunk& rChunk) const
 {
-  QByteArray ba = rChunk.m_baName;
-  ba.append(rChunk.m_baContent);
-  return m_crc.calculate(ba);
+  return m_crc.update(m_crc.update(0U, rChunk.m_baName), rChunk.m_baContent);
 }
 
 std::optional<Chunk> Base::readChunk(const QByteArray& rba, quint32& riOffset)
@@ -65,28 +63,139 @@ std::optional<Chunk> Base::readChunk(const QByteArray& rba, quint32& riOffset)
   chunk.m_baContent = rba.mid(riOffset + 8, chunk.m_uiLength);
   chunk.m_baCRC     = rba.mid(riOffset + 8 + chunk.m_uiLength, 4);
 
-  auto eVal = validity(chunk.m_baName);
+  if (verifyChunk(chunk, riOffset) == false)
+    return {};
+
+  return chunk;
+}
+
+std::optional<Chunk> Base::readChunk(ChunkStream& rStream, quint32& riOffset)
+{
+  if (rStream.atEnd() == true) {
+    return {};
+  }
+
+  char acLength[4];
+  if (rStream.read(acLength, 4) == false) {
+    m_info.setError(Info::ParseError::epeInvalidSize,
+                    QString("Invalid chunk size at %1").arg(riOffset), riOffset);
+
+    return {};
+  }
+
+  Chunk chunk;
+  chunk.m_uiLength = convert(QByteArray::fromRawData(acLength, 4));
+
+  // reject the lengths, which can not possibly be satisfied, before allocating anything
+  qint64 iRemaining = rStream.remaining();
+  if ((chunk.m_uiLength > m_cuiMaxChunkLength) ||
+      ((iRemaining >= 0) && (quint64(chunk.m_uiLength) + 8U > quint64(iRemaining)))) {
+    m_info.setError(Info::ParseError::epeInvalidSize,
+                    QString("Invalid chunk size at %1").arg(riOffset), riOffset);
+
+    return {};
+  }
+
+  if ((rStream.read(chunk.m_baName, 4) == false) ||
+      (rStream.read(chunk.m_baContent, chunk.m_uiLength) == false) ||
+      (rStream.read(chunk.m_baCRC, 4) == false)) {
+    m_info.setError(Info::ParseError::epeInvalidSize,
+                    QString("Invalid chunk size at %1").arg(riOffset), riOffset);
+
+    return {};
+  }
+
+  if (verifyChunk(chunk, riOffset) == false)
+    return {};
+
+  return chunk;
+}
+
+std::optional<ChunkView> Base::readChunk(const MappedFile& rMap, quint32& riOffset)
+{
+  if (riOffset >= rMap.size()) {
+    return {};
+  }
+
+  if (quint64(riOffset) + 4U > rMap.size()) {
+    m_info.setError(Info::ParseError::epeInvalidSize,
+                    QString("Invalid chunk size at %1").arg(riOffset), riOffset);
+
+    return {};
+  }
+
+  ChunkView view;
+  view.m_uiLength = convert(rMap.bytes(riOffset, 4));
+
+  if (quint64(riOffset) + view.m_uiLength + 12U > rMap.size()) {
+    m_info.setError(Info::ParseError::epeInvalidSize,
+                    QString("Invalid chunk size at %1").arg(riOffset), riOffset);
+
+    return {};
+  }
+
+  auto baName     = rMap.bytes(riOffset + 4, 4);
+  view.m_uiName   = convert(baName);
+  view.m_uiOffset = riOffset + 8;
+
+  auto eVal = validity(baName);
   if (eVal == ChunkName::ecnInvalid) {
     m_info.setError(Info::ParseError::epeChunkName,
-                    QString("Invalid chunk name \"%1\" at %2").arg(chunk.m_baName).arg(riOffset),
+                    QString("Invalid chunk name \"%1\" at %2").arg(QString(baName)).arg(riOffset),
                     riOffset);
     return {};
   } else if (eVal == ChunkName::ecnAPNG) {
     m_info.setType(Info::Type::etAPNG);
   }
 
-  riOffset += chunk.size();
-  if (convert(crc(chunk)) != chunk.m_baCRC) {
+  // name and payload are adjacent in the file, so the CRC is calculated directly from the mapping
+  auto uiCRC = m_crc.calculate(rMap.bytes(riOffset + 4, view.m_uiLength + 4));
+  riOffset += view.size();
+  if (uiCRC != convert(rMap.bytes(view.m_uiOffset + view.m_uiLength, 4))) {
     m_info.setError(
       Info::ParseError::epeCRC,
-      QString("Invalid CRC value for chunk \"%1\" at %2").arg(chunk.m_baName).arg(riOffset),
+      QString("Invalid CRC value for chunk \"%1\" at %2").arg(QString(baName)).arg(riOffset),
       riOffset);
     return {};
   }
 
+  return view;
+}
+
+Chunk Base::toChunk(const MappedFile& rMap, const ChunkView& rView) const
+{
+  Chunk chunk;
+  chunk.m_uiLength  = rView.m_uiLength;
+  chunk.m_baName    = convert(rView.m_uiName);
+  chunk.m_baContent = QByteArray(rMap.payload(rView).constData(), rView.m_uiLength);
+  chunk.m_baCRC     = QByteArray(rMap.bytes(rView.m_uiOffset + rView.m_uiLength, 4).constData(), 4);
   return chunk;
 }
 
+bool Base::verifyChunk(const Chunk& rChunk, quint32& riOffset)
+{
+  auto eVal = validity(rChunk.m_baName);
+  if (eVal == ChunkName::ecnInvalid) {
+    m_info.setError(Info::ParseError::epeChunkName,
+                    QString("Invalid chunk name \"%1\" at %2").arg(rChunk.m_baName).arg(riOffset),
+                    riOffset);
+    return false;
+  } else if (eVal == ChunkName::ecnAPNG) {
+    m_info.setType(Info::Type::etAPNG);
+  }
+
+  riOffset += rChunk.size();
+  if (convert(crc(rChunk)) != rChunk.m_baCRC) {
+    m_info.setError(
+      Info::ParseError::epeCRC,
+      QString("Invalid CRC value for chunk \"%1\" at %2").arg(rChunk.m_baName).arg(riOffset),
+      riOffset);
+    return false;
+  }
+
+  return true;
+}
+
 void Base::writeChunk(QByteArray& rba, const Chunk& rChunk, bool bCalcCRC) const
 {
   QByteArray baCRC = (bCalcCRC == true ? convert(crc(rChunk)) : rChunk.m_baCRC);
@@ -116,8 +225,18 @@ Chunk Base::actl(quint32 iCount, quint32 iRepeat) const
   return chunk;
 }
 
-Chunk Base::fctl(int i, int iW, int iH, int iFPS, int iX, int iY, int iDispose, int iBlend) const
+Chunk Base::fctl(int i, int iW, int iH, int iFPS, int iX, int iY, int iDispose, int iBlend,
+                 int iFrames) const
 {
+  // the long runs of folded frames would overflow the 16-bit numerator in [ms], so they are timed
+  // in frame periods instead
+  int iDelayNum = iFrames * (1000 / iFPS);
+  int iDelayDen = 1000;
+  if (iDelayNum > 0xFFFF) {
+    iDelayNum = iFrames;
+    iDelayDen = iFPS;
+  }
+
   Chunk chunk;
   chunk.m_baName    = m_cbaFCTL;
   chunk.m_baContent = convert(i >= 0 ? 2 * i + 1 : 0);
@@ -125,8 +244,8 @@ Chunk Base::fctl(int i, int iW, int iH, int iFPS, int iX, int iY, int iDispose,
   chunk.m_baContent.append(convert(iH));
   chunk.m_baContent.append(convert(iX));
   chunk.m_baContent.append(convert(iY));
-  chunk.m_baContent.append(convert(1000 / iFPS).right(2));
-  chunk.m_baContent.append(convert(1000).right(2));
+  chunk.m_baContent.append(convert(iDelayNum).right(2));
+  chunk.m_baContent.append(convert(iDelayDen).right(2));
   chunk.m_baContent.append(convert(iDispose).right(1));
   chunk.m_baContent.append(convert(iBlend).right(1));
 
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "chunkstream.h"
 #include "crc.h"
 #include "info.h"
+#include "mappedfile.h"
 
 #include <optional>
 
@@ -36,6 +38,23 @@ struct Chunk {
      */
     quint32 size() const { return 4 + m_baName.size() + m_baContent.size() + m_baCRC.size(); }
 };
+
+/**
+ * @brief The ChunkView struct This struct describes a chunk inside a memory-mapped file. Unlike
+ * Chunk, it does not hold any of the chunk bytes, only their position in the mapping
+ */
+struct ChunkView {
+    quint32 m_uiOffset;
+    quint32 m_uiLength;
+    quint32 m_uiName;
+
+    /**
+     * @brief size Returns the size of the whole chunk, including length, name and CRC
+     * @return chunk size in [bytes]
+     */
+    quint32 size() const { return 12 + m_uiLength; }
+};
+
 /**
  * @brief The BasePNG class This class contains some basic PNG definitions
  */
@@ -74,6 +93,35 @@ protected:
    * @return read chunk data or an empty value, if the chunk could not be read
    */
     std::optional<Chunk> readChunk(const QByteArray& rba, quint32 &riOffset);
+    /**
+     * @brief readChunk Reads the next chunk of data from the stream
+     * @param rStream Stream to read from
+     * @param riOffset Reference to the offset variable, which denotes the position of the chunk in
+     * the stream. It is advanced past the chunk after a successful read
+     * @return read chunk data or an empty value, if the chunk could not be read
+     */
+    std::optional<Chunk> readChunk(ChunkStream& rStream, quint32& riOffset);
+    /**
+     * @brief readChunk Reads the chunk at the given offset of the mapped file without copying it
+     * @param rMap Reference to the mapped file
+     * @param riOffset Reference to the offset variable, which denotes the start of reading
+     * @return view of the read chunk or an empty value, if the chunk could not be read
+     */
+    std::optional<ChunkView> readChunk(const MappedFile& rMap, quint32& riOffset);
+    /**
+     * @brief toChunk Copies the chunk, described by the view, out of the mapped file
+     * @param rMap Reference to the mapped file
+     * @param rView Reference to the chunk view
+     * @return Chunk with its own copy of the data
+     */
+    Chunk toChunk(const MappedFile& rMap, const ChunkView& rView) const;
+    /**
+     * @brief verifyChunk Checks the chunk name and CRC and advances the offset past the chunk
+     * @param rChunk Reference to the chunk to verify
+     * @param riOffset Reference to the offset variable, which denotes the start of the chunk
+     * @return true, if the chunk is valid and false otherwise
+     */
+    bool verifyChunk(const Chunk& rChunk, quint32& riOffset);
     /**
      * @brief writeChunk Appends the chunk into
      * @param rba Byte array, where the chunk will be appended to
@@ -105,9 +153,11 @@ protected:
      * @param iY Vertical offset in pixels
      * @param iDispose Dispose method indicator. Possible values are 0, 1 and 2
      * @param iBlend Blend method indicator. Possible values are 0 and 1
+     * @param iFrames Number of frame periods, which the frame is shown for
      * @return FCTL chunk
      */
-    Chunk fctl(int i, int iW, int iH, int iFPS, int iX, int iY, int iDispose = 0, int iBlend = 0) const;
+    Chunk fctl(int i, int iW, int iH, int iFPS, int iX, int iY, int iDispose = 0, int iBlend = 0,
+               int iFrames = 1) const;
     /**
      * @brief iend Returns the IEND chunk
      * @return IEND chunk
@@ -138,8 +188,17 @@ protected:
     const QByteArray m_cbaFCTL = QByteArray::fromHex("6663544C");
     const QByteArray m_cbaFDAT = QByteArray::fromHex("66644154");
     const QByteArray m_cbaIEND = QByteArray::fromHex("49454E44");
+    const QByteArray m_cbaPLTE = QByteArray::fromHex("504C5445");
+    const QByteArray m_cbaTRNS = QByteArray::fromHex("74524E53");
+
+    const quint32 m_cuiIDAT = 0x49444154U;
+    const quint32 m_cuiFDAT = 0x66644154U;
 
     const quint32 m_cuiLibPngLimit = 8192U;
+    /**
+     * @brief m_cuiMaxChunkLength Maximal chunk length allowed by the PNG specification
+     */
+    const quint32 m_cuiMaxChunkLength = 0x7FFFFFFFU;
 
     /**
      * @brief m_qslValidChunks Set of valid PNG chunk (except IDAT) names obtained from
@@ -148,7 +207,7 @@ protected:
     const QSet<QByteArray> m_csetValidPngChunks = {
         m_cbaIHDR,                       // IHDR
         m_cbaIDAT,                       // IDAT
-        QByteArray::fromHex("504C5445"), // PLTE
+        m_cbaPLTE,                       // PLTE
         m_cbaIEND,                       // IEND
         QByteArray::fromHex("624B4744"), // bKGD
         QByteArray::fromHex("6348524D"), // cHRM
@@ -158,7 +217,7 @@ protected:
         QByteArray::fromHex("73424954"), // sBIT
         m_cbaTEXT,                       // tEXt
         QByteArray::fromHex("74494D45"), // tIME
-        QByteArray::fromHex("74524E53"), // tRNS
+        m_cbaTRNS,                       // tRNS
         QByteArray::fromHex("7A545874")  // zTXt
     };
     /**
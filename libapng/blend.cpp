@@ -0,0 +1,472 @@
+#include "blend.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LIBAPNG_BLEND_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LIBAPNG_TARGET_SSE2
+#define LIBAPNG_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define LIBAPNG_TARGET_SSE2 __attribute__((target("sse2")))
+#define LIBAPNG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LIBAPNG_BLEND_NEON
+#include <arm_neon.h>
+#endif
+
+namespace png {
+
+namespace {
+
+/*
+ * All the implementations evaluate the formula of the APNG specification for non-premultiplied
+ * pixels with the maximal sample value M (255 or 65535):
+ *
+ *   u = Sa * M, v = (M - Sa) * Da, al = u + v
+ *   C = (Sc * u + Dc * v) / al, A = al / M
+ *
+ * with integer division. The vectorized implementations divide in floating point, where all the
+ * operands are exact integers, and then correct the truncated quotient by its remainder, so they
+ * give exactly the same results as the integer division.
+ */
+
+void overScalar8(const QRgb* pSrc, QRgb* pDst, int iCount)
+{
+  for (int i = 0; i < iCount; ++i) {
+    quint32 uiSA = qAlpha(pSrc[i]);
+    if (uiSA == 255U) {
+      pDst[i] = pSrc[i];
+    } else if (uiSA != 0U) {
+      quint32 uiDA = qAlpha(pDst[i]);
+      if (uiDA == 0U) {
+        pDst[i] = pSrc[i];
+      } else {
+        quint32 u  = uiSA * 255U;
+        quint32 v  = (255U - uiSA) * uiDA;
+        quint32 al = u + v;
+        pDst[i]    = qRgba((qRed(pSrc[i]) * u + qRed(pDst[i]) * v) / al,
+                        (qGreen(pSrc[i]) * u + qGreen(pDst[i]) * v) / al,
+                        (qBlue(pSrc[i]) * u + qBlue(pDst[i]) * v) / al, al / 255U);
+      }
+    }
+  }
+}
+
+void overScalar16(const QRgba64* pSrc, QRgba64* pDst, int iCount)
+{
+  for (int i = 0; i < iCount; ++i) {
+    quint64 uiSA = pSrc[i].alpha();
+    if (uiSA == 65535U) {
+      pDst[i] = pSrc[i];
+    } else if (uiSA != 0U) {
+      quint64 uiDA = pDst[i].alpha();
+      if (uiDA == 0U) {
+        pDst[i] = pSrc[i];
+      } else {
+        quint64 u  = uiSA * 65535U;
+        quint64 v  = (65535U - uiSA) * uiDA;
+        quint64 al = u + v;
+        pDst[i]    = QRgba64::fromRgba64(quint16((pSrc[i].red() * u + pDst[i].red() * v) / al),
+                                         quint16((pSrc[i].green() * u + pDst[i].green() * v) / al),
+                                         quint16((pSrc[i].blue() * u + pDst[i].blue() * v) / al),
+                                         quint16(al / 65535U));
+      }
+    }
+  }
+}
+
+#if defined(LIBAPNG_BLEND_X86)
+
+/**
+ * @brief divSse2 Divides the exact integers smaller than 2^24 with truncation
+ */
+LIBAPNG_TARGET_SSE2 inline __m128 divSse2(__m128 n, __m128 d)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  __m128 q = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_div_ps(n, d)));
+  __m128 r = _mm_sub_ps(n, _mm_mul_ps(q, d));
+  q        = _mm_sub_ps(q, _mm_and_ps(_mm_cmplt_ps(r, _mm_setzero_ps()), one));
+  return _mm_add_ps(q, _mm_and_ps(_mm_cmpge_ps(r, d), one));
+}
+
+/**
+ * @brief channelSse2 Blends one channel of four pixels, given in the lowest byte of each lane
+ */
+LIBAPNG_TARGET_SSE2 inline __m128i channelSse2(__m128i s, __m128i d, __m128 u, __m128 v, __m128 al)
+{
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  __m128 n = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(s, mask)), u),
+                        _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(d, mask)), v));
+  return _mm_cvttps_epi32(divSse2(n, al));
+}
+
+LIBAPNG_TARGET_SSE2 void overSse2(const QRgb* pSrc, QRgb* pDst, int iCount)
+{
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  const __m128 f255  = _mm_set1_ps(255.0f);
+  int i              = 0;
+  for (; i + 4 <= iCount; i += 4) {
+    __m128i s      = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+    __m128i sa     = _mm_srli_epi32(s, 24);
+    __m128i opaque = _mm_cmpeq_epi32(sa, mask);
+    if (_mm_movemask_epi8(opaque) == 0xFFFF) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), s);
+      continue;
+    }
+
+    __m128i clear = _mm_cmpeq_epi32(sa, _mm_setzero_si128());
+    if (_mm_movemask_epi8(clear) == 0xFFFF)
+      continue;
+
+    __m128i d  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDst + i));
+    __m128i da = _mm_srli_epi32(d, 24);
+    __m128 fsa = _mm_cvtepi32_ps(sa);
+    __m128 u   = _mm_mul_ps(fsa, f255);
+    __m128 v   = _mm_mul_ps(_mm_sub_ps(f255, fsa), _mm_cvtepi32_ps(da));
+    __m128 al  = _mm_add_ps(u, v);
+    // the lanes, which are not blended, must not divide by zero
+    __m128 div = _mm_max_ps(al, _mm_set1_ps(1.0f));
+
+    __m128i res = _mm_slli_epi32(_mm_cvttps_epi32(divSse2(al, f255)), 24);
+    res = _mm_or_si128(res, _mm_slli_epi32(channelSse2(_mm_srli_epi32(s, 16), _mm_srli_epi32(d, 16),
+                                                       u, v, div), 16));
+    res = _mm_or_si128(res, _mm_slli_epi32(channelSse2(_mm_srli_epi32(s, 8), _mm_srli_epi32(d, 8),
+                                                       u, v, div), 8));
+    res = _mm_or_si128(res, channelSse2(s, d, u, v, div));
+
+    __m128i src = _mm_or_si128(opaque, _mm_cmpeq_epi32(da, _mm_setzero_si128()));
+    res         = _mm_or_si128(_mm_and_si128(src, s), _mm_andnot_si128(src, res));
+    res         = _mm_or_si128(_mm_and_si128(clear, d), _mm_andnot_si128(clear, res));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), res);
+  }
+
+  overScalar8(pSrc + i, pDst + i, iCount - i);
+}
+
+/**
+ * @brief divAvx2 Divides the exact integers smaller than 2^24 with truncation
+ */
+LIBAPNG_TARGET_AVX2 inline __m256 divAvx2(__m256 n, __m256 d)
+{
+  const __m256 one = _mm256_set1_ps(1.0f);
+  __m256 q = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_div_ps(n, d)));
+  __m256 r = _mm256_sub_ps(n, _mm256_mul_ps(q, d));
+  q        = _mm256_sub_ps(q, _mm256_and_ps(_mm256_cmp_ps(r, _mm256_setzero_ps(), _CMP_LT_OQ), one));
+  return _mm256_add_ps(q, _mm256_and_ps(_mm256_cmp_ps(r, d, _CMP_GE_OQ), one));
+}
+
+/**
+ * @brief channelAvx2 Blends one channel of eight pixels, given in the lowest byte of each lane
+ */
+LIBAPNG_TARGET_AVX2 inline __m256i channelAvx2(__m256i s, __m256i d, __m256 u, __m256 v,
+                                               __m256 al)
+{
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  __m256 n = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(s, mask)), u),
+                           _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(d, mask)), v));
+  return _mm256_cvttps_epi32(divAvx2(n, al));
+}
+
+LIBAPNG_TARGET_AVX2 void overAvx2(const QRgb* pSrc, QRgb* pDst, int iCount)
+{
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  const __m256 f255  = _mm256_set1_ps(255.0f);
+  int i              = 0;
+  for (; i + 8 <= iCount; i += 8) {
+    __m256i s      = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i));
+    __m256i sa     = _mm256_srli_epi32(s, 24);
+    __m256i opaque = _mm256_cmpeq_epi32(sa, mask);
+    if (_mm256_movemask_epi8(opaque) == -1) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), s);
+      continue;
+    }
+
+    __m256i clear = _mm256_cmpeq_epi32(sa, _mm256_setzero_si256());
+    if (_mm256_movemask_epi8(clear) == -1)
+      continue;
+
+    __m256i d  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pDst + i));
+    __m256i da = _mm256_srli_epi32(d, 24);
+    __m256 fsa = _mm256_cvtepi32_ps(sa);
+    __m256 u   = _mm256_mul_ps(fsa, f255);
+    __m256 v   = _mm256_mul_ps(_mm256_sub_ps(f255, fsa), _mm256_cvtepi32_ps(da));
+    __m256 al  = _mm256_add_ps(u, v);
+    // the lanes, which are not blended, must not divide by zero
+    __m256 div = _mm256_max_ps(al, _mm256_set1_ps(1.0f));
+
+    __m256i res = _mm256_slli_epi32(_mm256_cvttps_epi32(divAvx2(al, f255)), 24);
+    res = _mm256_or_si256(res, _mm256_slli_epi32(channelAvx2(_mm256_srli_epi32(s, 16),
+                                                             _mm256_srli_epi32(d, 16), u, v, div),
+                                                 16));
+    res = _mm256_or_si256(res, _mm256_slli_epi32(channelAvx2(_mm256_srli_epi32(s, 8),
+                                                             _mm256_srli_epi32(d, 8), u, v, div),
+                                                 8));
+    res = _mm256_or_si256(res, channelAvx2(s, d, u, v, div));
+
+    __m256i src = _mm256_or_si256(opaque, _mm256_cmpeq_epi32(da, _mm256_setzero_si256()));
+    res         = _mm256_blendv_epi8(res, s, src);
+    res         = _mm256_blendv_epi8(res, d, clear);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), res);
+  }
+
+  overSse2(pSrc + i, pDst + i, iCount - i);
+}
+
+/**
+ * @brief divAvx2 Divides the exact integers smaller than 2^53 with truncation
+ */
+LIBAPNG_TARGET_AVX2 inline __m256d divAvx2(__m256d n, __m256d d)
+{
+  const __m256d one = _mm256_set1_pd(1.0);
+  __m256d q = _mm256_round_pd(_mm256_div_pd(n, d), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __m256d r = _mm256_sub_pd(n, _mm256_mul_pd(q, d));
+  q = _mm256_sub_pd(q, _mm256_and_pd(_mm256_cmp_pd(r, _mm256_setzero_pd(), _CMP_LT_OQ), one));
+  return _mm256_add_pd(q, _mm256_and_pd(_mm256_cmp_pd(r, d, _CMP_GE_OQ), one));
+}
+
+LIBAPNG_TARGET_AVX2 void overAvx2(const QRgba64* pSrc, QRgba64* pDst, int iCount)
+{
+  // the pixels are blended one at a time, with the four channels side by side
+  for (int i = 0; i < iCount; ++i) {
+    quint64 uiSA = pSrc[i].alpha();
+    quint64 uiDA = pDst[i].alpha();
+    if ((uiSA == 65535U) || ((uiSA != 0U) && (uiDA == 0U))) {
+      pDst[i] = pSrc[i];
+      continue;
+    }
+    if (uiSA == 0U)
+      continue;
+
+    quint64 al = uiSA * 65535U + (65535U - uiSA) * uiDA;
+    __m256d u  = _mm256_set1_pd(double(uiSA * 65535U));
+    __m256d v  = _mm256_set1_pd(double((65535U - uiSA) * uiDA));
+    __m256d d  = _mm256_set1_pd(double(al));
+
+    __m128i s32 = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc + i)));
+    __m128i d32 = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pDst + i)));
+    __m256d n   = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(s32), u),
+                                _mm256_mul_pd(_mm256_cvtepi32_pd(d32), v));
+    __m128i q   = _mm256_cvttpd_epi32(divAvx2(n, d));
+    q           = _mm_insert_epi32(q, int(al / 65535U), 3);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + i), _mm_packus_epi32(q, q));
+  }
+}
+
+bool hasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+  return true;
+#elif defined(_MSC_VER)
+  int aiInfo[4];
+  __cpuid(aiInfo, 1);
+  return (aiInfo[3] & (1 << 26)) != 0;
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    return false;
+  return (edx & (1U << 26)) != 0;
+#endif
+}
+
+bool hasAvx2()
+{
+  unsigned int ebx = 0;
+  unsigned int ecx = 0;
+#if defined(_MSC_VER)
+  int aiInfo[4];
+  __cpuid(aiInfo, 1);
+  ecx = unsigned(aiInfo[2]);
+  if ((ecx & (1U << 27)) == 0)
+    return false;
+  __cpuidex(aiInfo, 7, 0);
+  ebx = unsigned(aiInfo[1]);
+  quint64 uiXCR0 = _xgetbv(0);
+#else
+  unsigned int eax, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    return false;
+  // bit 27: OSXSAVE, needed to query the register state saved by the OS
+  if ((ecx & (1U << 27)) == 0)
+    return false;
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0)
+    return false;
+  quint32 uiLo, uiHi;
+  __asm__("xgetbv" : "=a"(uiLo), "=d"(uiHi) : "c"(0));
+  quint64 uiXCR0 = (quint64(uiHi) << 32) | uiLo;
+#endif
+  // bit 5: AVX2, and the OS has to save the SSE and AVX registers
+  return ((ebx & (1U << 5)) != 0) && ((uiXCR0 & 6U) == 6U);
+}
+
+#elif defined(LIBAPNG_BLEND_NEON)
+
+/**
+ * @brief divNeon Divides the exact integers smaller than 2^24 with truncation
+ */
+inline float32x4_t divNeon(float32x4_t n, float32x4_t d)
+{
+  const uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.0f));
+  float32x4_t q        = vcvtq_f32_u32(vcvtq_u32_f32(vdivq_f32(n, d)));
+  float32x4_t r        = vsubq_f32(n, vmulq_f32(q, d));
+  q = vsubq_f32(q, vreinterpretq_f32_u32(vandq_u32(vcltq_f32(r, vdupq_n_f32(0.0f)), one)));
+  return vaddq_f32(q, vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(r, d), one)));
+}
+
+/**
+ * @brief channelNeon Blends one channel of four pixels, given in the lowest byte of each lane
+ */
+inline uint32x4_t channelNeon(uint32x4_t s, uint32x4_t d, float32x4_t u, float32x4_t v,
+                              float32x4_t al)
+{
+  const uint32x4_t mask = vdupq_n_u32(0xFF);
+  float32x4_t n = vaddq_f32(vmulq_f32(vcvtq_f32_u32(vandq_u32(s, mask)), u),
+                            vmulq_f32(vcvtq_f32_u32(vandq_u32(d, mask)), v));
+  return vcvtq_u32_f32(divNeon(n, al));
+}
+
+void overNeon(const QRgb* pSrc, QRgb* pDst, int iCount)
+{
+  const uint32x4_t mask = vdupq_n_u32(0xFF);
+  const float32x4_t f255 = vdupq_n_f32(255.0f);
+  int i = 0;
+  for (; i + 4 <= iCount; i += 4) {
+    uint32x4_t s      = vld1q_u32(reinterpret_cast<const uint32_t*>(pSrc + i));
+    uint32x4_t sa     = vshrq_n_u32(s, 24);
+    uint32x4_t opaque = vceqq_u32(sa, mask);
+    if (vminvq_u32(opaque) == 0xFFFFFFFFU) {
+      vst1q_u32(reinterpret_cast<uint32_t*>(pDst + i), s);
+      continue;
+    }
+
+    if (vmaxvq_u32(sa) == 0U)
+      continue;
+
+    uint32x4_t clear = vceqq_u32(sa, vdupq_n_u32(0));
+    uint32x4_t d     = vld1q_u32(reinterpret_cast<const uint32_t*>(pDst + i));
+    uint32x4_t da    = vshrq_n_u32(d, 24);
+    float32x4_t fsa  = vcvtq_f32_u32(sa);
+    float32x4_t u    = vmulq_f32(fsa, f255);
+    float32x4_t v    = vmulq_f32(vsubq_f32(f255, fsa), vcvtq_f32_u32(da));
+    float32x4_t al   = vaddq_f32(u, v);
+    // the lanes, which are not blended, must not divide by zero
+    float32x4_t div = vmaxq_f32(al, vdupq_n_f32(1.0f));
+
+    uint32x4_t res = vshlq_n_u32(vcvtq_u32_f32(divNeon(al, f255)), 24);
+    res = vorrq_u32(res, vshlq_n_u32(channelNeon(vshrq_n_u32(s, 16), vshrq_n_u32(d, 16), u, v,
+                                                 div), 16));
+    res = vorrq_u32(res, vshlq_n_u32(channelNeon(vshrq_n_u32(s, 8), vshrq_n_u32(d, 8), u, v,
+                                                 div), 8));
+    res = vorrq_u32(res, channelNeon(s, d, u, v, div));
+
+    uint32x4_t src = vorrq_u32(opaque, vceqq_u32(da, vdupq_n_u32(0)));
+    res            = vbslq_u32(src, s, res);
+    res            = vbslq_u32(clear, d, res);
+    vst1q_u32(reinterpret_cast<uint32_t*>(pDst + i), res);
+  }
+
+  overScalar8(pSrc + i, pDst + i, iCount - i);
+}
+
+/**
+ * @brief divNeon Divides the exact integers smaller than 2^53 with truncation
+ */
+inline float64x2_t divNeon(float64x2_t n, float64x2_t d)
+{
+  const uint64x2_t one = vreinterpretq_u64_f64(vdupq_n_f64(1.0));
+  float64x2_t q        = vcvtq_f64_u64(vcvtq_u64_f64(vdivq_f64(n, d)));
+  float64x2_t r        = vsubq_f64(n, vmulq_f64(q, d));
+  q = vsubq_f64(q, vreinterpretq_f64_u64(vandq_u64(vcltq_f64(r, vdupq_n_f64(0.0)), one)));
+  return vaddq_f64(q, vreinterpretq_f64_u64(vandq_u64(vcgeq_f64(r, d), one)));
+}
+
+void overNeon(const QRgba64* pSrc, QRgba64* pDst, int iCount)
+{
+  // the pixels are blended one at a time, with the four channels side by side
+  for (int i = 0; i < iCount; ++i) {
+    quint64 uiSA = pSrc[i].alpha();
+    quint64 uiDA = pDst[i].alpha();
+    if ((uiSA == 65535U) || ((uiSA != 0U) && (uiDA == 0U))) {
+      pDst[i] = pSrc[i];
+      continue;
+    }
+    if (uiSA == 0U)
+      continue;
+
+    quint64 al    = uiSA * 65535U + (65535U - uiSA) * uiDA;
+    float64x2_t u = vdupq_n_f64(double(uiSA * 65535U));
+    float64x2_t v = vdupq_n_f64(double((65535U - uiSA) * uiDA));
+    float64x2_t d = vdupq_n_f64(double(al));
+
+    uint32x4_t s32 = vmovl_u16(vld1_u16(reinterpret_cast<const uint16_t*>(pSrc + i)));
+    uint32x4_t d32 = vmovl_u16(vld1_u16(reinterpret_cast<const uint16_t*>(pDst + i)));
+    float64x2_t rg = vaddq_f64(vmulq_f64(vcvtq_f64_u64(vmovl_u32(vget_low_u32(s32))), u),
+                               vmulq_f64(vcvtq_f64_u64(vmovl_u32(vget_low_u32(d32))), v));
+    float64x2_t ba = vaddq_f64(vmulq_f64(vcvtq_f64_u64(vmovl_u32(vget_high_u32(s32))), u),
+                               vmulq_f64(vcvtq_f64_u64(vmovl_u32(vget_high_u32(d32))), v));
+    uint32x4_t q   = vcombine_u32(vmovn_u64(vcvtq_u64_f64(divNeon(rg, d))),
+                                vmovn_u64(vcvtq_u64_f64(divNeon(ba, d))));
+    q              = vsetq_lane_u32(quint32(al / 65535U), q, 3);
+    vst1_u16(reinterpret_cast<uint16_t*>(pDst + i), vmovn_u32(q));
+  }
+}
+
+#endif
+
+} // namespace
+
+Blend::Blend()
+{
+  m_pfnOver8   = &overScalar8;
+  m_pfnOver16  = &overScalar16;
+  m_eAlgorithm = Algorithm::eaScalar;
+#if defined(LIBAPNG_BLEND_X86)
+  if (hasAvx2() == true) {
+    m_pfnOver8   = &overAvx2;
+    m_pfnOver16  = &overAvx2;
+    m_eAlgorithm = Algorithm::eaAvx2;
+  } else if (hasSse2() == true) {
+    // blending 16-bit pixels one by one with SSE2 does not pay off, so it stays scalar
+    m_pfnOver8   = &overSse2;
+    m_eAlgorithm = Algorithm::eaSse2;
+  }
+#elif defined(LIBAPNG_BLEND_NEON)
+  // NEON is a mandatory part of ARMv8
+  m_pfnOver8   = &overNeon;
+  m_pfnOver16  = &overNeon;
+  m_eAlgorithm = Algorithm::eaNeon;
+#endif
+}
+
+void Blend::clear(QImage& rImg, const QRect& rRect)
+{
+  // the C library already fills and copies memory with the widest vector instructions available
+  int iPixel = rImg.depth() / 8;
+  for (int y = rRect.top(); y <= rRect.bottom(); ++y)
+    std::memset(rImg.scanLine(y) + rRect.x() * iPixel, 0, size_t(rRect.width() * iPixel));
+}
+
+void Blend::copy(const QImage& rSrc, QImage& rDst, const QRect& rRect)
+{
+  int iPixel = rSrc.depth() / 8;
+  for (int y = rRect.top(); y <= rRect.bottom(); ++y) {
+    std::memcpy(rDst.scanLine(y) + rRect.x() * iPixel, rSrc.constScanLine(y) + rRect.x() * iPixel,
+                size_t(rRect.width() * iPixel));
+  }
+}
+
+void Blend::reference(const QRgb* pSrc, QRgb* pDst, int iCount)
+{
+  overScalar8(pSrc, pDst, iCount);
+}
+
+void Blend::reference(const QRgba64* pSrc, QRgba64* pDst, int iCount)
+{
+  overScalar16(pSrc, pDst, iCount);
+}
+
+} // namespace png
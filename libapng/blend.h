@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QImage>
+#include <QRect>
+#include <QtGlobal>
+
+namespace png {
+
+/**
+ * @brief The Blend class This class contains the pixel kernels used to compose the animation
+ * frames: the APNG_BLEND_OP_OVER blending of non-premultiplied 8-bit and 16-bit pixels and the
+ * clearing and copying of rectangular regions. The fastest blending implementation supported by
+ * the CPU is selected at runtime: AVX2 or SSE2 (8-bit pixels only) on x86, NEON on ARMv8 and a
+ * portable scalar implementation everywhere else. All of them give exactly the same results.
+ */
+class __declspec(dllexport) Blend
+{
+public:
+  /**
+   * @brief The Algorithm enum Denotes the implementation used by the object
+   */
+  enum class Algorithm {
+    eaScalar,
+    eaSse2,
+    eaAvx2,
+    eaNeon
+  };
+
+  /**
+   * @brief Blend Default constructor. Selects the implementation for the current CPU
+   */
+  Blend();
+  /**
+   * @brief over Blends the 8-bit pixels over the destination pixels
+   * @param pSrc Pointer to the source pixels in QImage::Format_ARGB32
+   * @param pDst Pointer to the destination pixels in QImage::Format_ARGB32
+   * @param iCount Number of pixels
+   */
+  void over(const QRgb* pSrc, QRgb* pDst, int iCount) const { m_pfnOver8(pSrc, pDst, iCount); }
+  /**
+   * @brief over Blends the 16-bit pixels over the destination pixels
+   * @param pSrc Pointer to the source pixels in QImage::Format_RGBA64
+   * @param pDst Pointer to the destination pixels in QImage::Format_RGBA64
+   * @param iCount Number of pixels
+   */
+  void over(const QRgba64* pSrc, QRgba64* pDst, int iCount) const
+  {
+    m_pfnOver16(pSrc, pDst, iCount);
+  }
+  /**
+   * @brief algorithm Returns the implementation selected for the current CPU
+   * @return Selected implementation
+   */
+  Algorithm algorithm() const { return m_eAlgorithm; }
+  /**
+   * @brief clear Sets all the bytes of the region to 0, which is transparent black in all the
+   * supported formats
+   * @param rImg Reference to the image
+   * @param rRect Reference to the region, which has to lie within the image
+   */
+  static void clear(QImage& rImg, const QRect& rRect);
+  /**
+   * @brief copy Copies the region between two images of the same size and format
+   * @param rSrc Reference to the source image
+   * @param rDst Reference to the destination image
+   * @param rRect Reference to the region, which has to lie within both images
+   */
+  static void copy(const QImage& rSrc, QImage& rDst, const QRect& rRect);
+  /**
+   * @brief reference Blends the 8-bit pixels with the portable implementation, regardless of the
+   * CPU. Useful to verify the accelerated implementations
+   * @param pSrc Pointer to the source pixels
+   * @param pDst Pointer to the destination pixels
+   * @param iCount Number of pixels
+   */
+  static void reference(const QRgb* pSrc, QRgb* pDst, int iCount);
+  /**
+   * @brief reference Blends the 16-bit pixels with the portable implementation, regardless of the
+   * CPU. Useful to verify the accelerated implementations
+   * @param pSrc Pointer to the source pixels
+   * @param pDst Pointer to the destination pixels
+   * @param iCount Number of pixels
+   */
+  static void reference(const QRgba64* pSrc, QRgba64* pDst, int iCount);
+
+private:
+  void (*m_pfnOver8)(const QRgb*, QRgb*, int);
+  void (*m_pfnOver16)(const QRgba64*, QRgba64*, int);
+  Algorithm m_eAlgorithm;
+};
+
+} // namespace png
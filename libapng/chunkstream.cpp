@@ -0,0 +1,84 @@
+#include "chunkstream.h"
+
+#include <QIODevice>
+
+#include <cstring>
+
+namespace png {
+
+ChunkStream::ChunkStream(QIODevice* pDevice, quint32 uiBufferSize)
+  : m_pDevice(pDevice), m_uiStart(0U), m_uiEnd(0U), m_uiPos(0U)
+{
+  m_baBuffer.resize(uiBufferSize);
+}
+
+bool ChunkStream::read(char* pData, quint32 uiSize)
+{
+  while (uiSize > 0U) {
+    if (m_uiStart == m_uiEnd) {
+      // large reads bypass the buffer, so that the payload is copied only once
+      if (uiSize >= quint32(m_baBuffer.size())) {
+        qint64 iRead = pull(pData, uiSize);
+        if (iRead <= 0)
+          return false;
+
+        pData   += iRead;
+        uiSize  -= quint32(iRead);
+        m_uiPos += quint64(iRead);
+        continue;
+      }
+
+      if (fill() == false)
+        return false;
+    }
+
+    quint32 uiCopy = qMin(uiSize, m_uiEnd - m_uiStart);
+    std::memcpy(pData, m_baBuffer.constData() + m_uiStart, uiCopy);
+    pData     += uiCopy;
+    uiSize    -= uiCopy;
+    m_uiStart += uiCopy;
+    m_uiPos   += uiCopy;
+  }
+
+  return true;
+}
+
+bool ChunkStream::read(QByteArray& rba, quint32 uiSize)
+{
+  rba.resize(uiSize);
+  return read(rba.data(), uiSize);
+}
+
+bool ChunkStream::atEnd()
+{
+  return (m_uiStart == m_uiEnd) && (fill() == false);
+}
+
+qint64 ChunkStream::remaining() const
+{
+  if (m_pDevice->isSequential() == true)
+    return -1;
+
+  return m_pDevice->size() - m_pDevice->pos() + (m_uiEnd - m_uiStart);
+}
+
+bool ChunkStream::fill()
+{
+  qint64 iRead = pull(m_baBuffer.data(), m_baBuffer.size());
+  m_uiStart    = 0U;
+  m_uiEnd      = (iRead > 0 ? quint32(iRead) : 0U);
+  return m_uiEnd > 0U;
+}
+
+qint64 ChunkStream::pull(char* pData, qint64 iSize)
+{
+  qint64 iRead = m_pDevice->read(pData, iSize);
+  // sequential devices (sockets, processes) may simply have no data available yet
+  while ((iRead == 0) && (m_pDevice->isSequential() == true) &&
+         (m_pDevice->waitForReadyRead(m_ciTimeout) == true)) {
+    iRead = m_pDevice->read(pData, iSize);
+  }
+  return iRead;
+}
+
+} // namespace png
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+
+class QIODevice;
+
+namespace png {
+
+/**
+ * @brief The ChunkStream class This class is a pull-based reader over any QIODevice. It reads the
+ * device through a small, fixed-size buffer, so that the PNG chunks can be parsed one at a time
+ * without holding the whole file in memory.
+ */
+class __declspec(dllexport) ChunkStream
+{
+public:
+  /**
+   * @brief ChunkStream Constructor
+   * @param pDevice Pointer to the device to read from. The device should already be open for
+   * reading and has to outlive this object
+   * @param uiBufferSize Size of the internal read buffer in [bytes]
+   */
+  explicit ChunkStream(QIODevice* pDevice, quint32 uiBufferSize = 65536U);
+  /**
+   * @brief read Reads exactly uiSize bytes from the stream
+   * @param pData Pointer to the destination buffer
+   * @param uiSize Number of bytes to read
+   * @return true, if all the requested bytes were read and false, if the stream ended before that
+   */
+  bool read(char* pData, quint32 uiSize);
+  /**
+   * @brief read Reads exactly uiSize bytes from the stream
+   * @param rba Reference to the byte array, which will be resized to uiSize and filled
+   * @param uiSize Number of bytes to read
+   * @return true, if all the requested bytes were read and false otherwise
+   */
+  bool read(QByteArray& rba, quint32 uiSize);
+  /**
+   * @brief atEnd Returns true, if there is no more data to read
+   * @return true, if there is no more data to read and false otherwise
+   */
+  bool atEnd();
+  /**
+   * @brief pos Returns the number of bytes consumed from the stream so far
+   * @return number of consumed bytes
+   */
+  quint64 pos() const { return m_uiPos; }
+  /**
+   * @brief remaining Returns the number of bytes left in the stream, if it is known
+   * @return number of bytes left or -1, if the device is sequential and the size is unknown
+   */
+  qint64 remaining() const;
+  /**
+   * @brief device Returns the underlying device
+   * @return Pointer to the underlying device
+   */
+  QIODevice* device() const { return m_pDevice; }
+
+private:
+  /**
+   * @brief fill Refills the internal buffer from the device
+   * @return true, if at least one byte was read and false otherwise
+   */
+  bool fill();
+  /**
+   * @brief pull Reads up to iSize bytes from the device, waiting for the sequential devices to
+   * deliver more data
+   * @param pData Pointer to the destination buffer
+   * @param iSize Maximal number of bytes to read
+   * @return number of bytes read or a value <= 0, if no more data is available
+   */
+  qint64 pull(char* pData, qint64 iSize);
+
+private:
+  QIODevice* m_pDevice;
+  QByteArray m_baBuffer;
+  quint32 m_uiStart;
+  quint32 m_uiEnd;
+  quint64 m_uiPos;
+
+  const int m_ciTimeout = 30000;
+};
+
+} // namespace png
@@ -0,0 +1,118 @@
+#include "compositor.h"
+
+#include <cstring>
+
+namespace png {
+
+Compositor::Compositor() : m_uiDispose(FrameControl::edoNone), m_bFirst(true) {}
+
+bool Compositor::reset(const QSize& rSize, QImage::Format eFormat)
+{
+  if ((eFormat != QImage::Format_ARGB32) && (eFormat != QImage::Format_RGBA64))
+    return false;
+
+  if ((m_imgCanvas.size() != rSize) || (m_imgCanvas.format() != eFormat)) {
+    m_imgCanvas = QImage(rSize, eFormat);
+    // the buffer for the restored regions is only allocated, when it is needed
+    m_imgSaved = QImage();
+  }
+
+  if (m_imgCanvas.isNull() == true)
+    return false;
+
+  rewind();
+  return true;
+}
+
+void Compositor::rewind()
+{
+  // the canvas starts fully transparent black
+  if (m_imgCanvas.isNull() == false)
+    std::memset(m_imgCanvas.bits(), 0, size_t(m_imgCanvas.sizeInBytes()));
+  m_rectDispose = QRect();
+  m_uiDispose   = FrameControl::edoNone;
+  m_bFirst      = true;
+}
+
+bool Compositor::restore(const QImage& rCanvas)
+{
+  if ((rCanvas.size() != m_imgCanvas.size()) || (rCanvas.format() != m_imgCanvas.format()) ||
+      (m_imgCanvas.isNull() == true))
+    return false;
+
+  // the content is copied into the existing canvas, so that no new canvas is allocated
+  Blend::copy(rCanvas, m_imgCanvas, m_imgCanvas.rect());
+  m_rectDispose = QRect();
+  m_uiDispose   = FrameControl::edoNone;
+  m_bFirst      = false;
+  return true;
+}
+
+bool Compositor::compose(const QImage& rFrame, const FrameControl& rControl)
+{
+  if (m_imgCanvas.isNull() == true)
+    return false;
+
+  dispose();
+
+  // the regions reaching out of the canvas are clipped instead of rejected
+  QRect rect;
+  if ((rControl.m_uiX < quint32(m_imgCanvas.width())) &&
+      (rControl.m_uiY < quint32(m_imgCanvas.height()))) {
+    int iX = int(rControl.m_uiX);
+    int iY = int(rControl.m_uiY);
+    rect   = QRect(iX, iY, int(qMin<quint32>(rControl.m_uiWidth, m_imgCanvas.width() - iX)),
+                 int(qMin<quint32>(rControl.m_uiHeight, m_imgCanvas.height() - iY)));
+  }
+
+  m_rectDispose = rect;
+  m_uiDispose   = rControl.m_uiDispose;
+  // there is nothing to go back to before the first frame, so the region is cleared instead
+  if ((m_bFirst == true) && (m_uiDispose == FrameControl::edoPrevious))
+    m_uiDispose = FrameControl::edoBackground;
+  m_bFirst = false;
+
+  if (m_uiDispose == FrameControl::edoPrevious) {
+    if (m_imgSaved.isNull() == true)
+      m_imgSaved = QImage(m_imgCanvas.size(), m_imgCanvas.format());
+    Blend::copy(m_imgCanvas, m_imgSaved, rect);
+  }
+
+  if ((rFrame.isNull() == true) || (rect.isEmpty() == true))
+    return false;
+
+  QImage img = (rFrame.format() == m_imgCanvas.format() ? rFrame
+                                                        : rFrame.convertToFormat(m_imgCanvas.format()));
+  int iWidth  = qMin(rect.width(), img.width());
+  int iHeight = qMin(rect.height(), img.height());
+  bool bWide  = (m_imgCanvas.format() == QImage::Format_RGBA64);
+  int iPixel  = (bWide == true ? 8 : 4);
+
+  for (int y = 0; y < iHeight; ++y) {
+    const uchar* pSrc = img.constScanLine(y);
+    uchar* pDst       = m_imgCanvas.scanLine(rect.y() + y) + rect.x() * iPixel;
+    if (rControl.m_uiBlend == FrameControl::eboSource)
+      std::memcpy(pDst, pSrc, size_t(iWidth * iPixel));
+    else if (bWide == true)
+      m_blend.over(reinterpret_cast<const QRgba64*>(pSrc), reinterpret_cast<QRgba64*>(pDst), iWidth);
+    else
+      m_blend.over(reinterpret_cast<const QRgb*>(pSrc), reinterpret_cast<QRgb*>(pDst), iWidth);
+  }
+
+  return true;
+}
+
+void Compositor::dispose()
+{
+  if (m_rectDispose.isEmpty() == true)
+    return;
+
+  if (m_uiDispose == FrameControl::edoBackground)
+    Blend::clear(m_imgCanvas, m_rectDispose);
+  else if (m_uiDispose == FrameControl::edoPrevious)
+    Blend::copy(m_imgSaved, m_imgCanvas, m_rectDispose);
+
+  m_rectDispose = QRect();
+}
+
+} // namespace png
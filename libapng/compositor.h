@@ -0,0 +1,81 @@
+#pragma once
+
+#include "blend.h"
+#include "framecontrol.h"
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+namespace png {
+
+/**
+ * @brief The Compositor class This class renders the animation frames into one persistent canvas
+ * the way the APNG specification describes it: every frame is placed at its offset, blended with
+ * the canvas by its blend operation and its region is disposed of by its dispose operation before
+ * the next frame is rendered. The canvas and the buffer, which keeps the region restored by the
+ * APNG_DISPOSE_OP_PREVIOUS operation, are allocated once, so playing the animation does not
+ * allocate any memory per frame.
+ */
+class __declspec(dllexport) Compositor
+{
+public:
+  /**
+   * @brief Compositor Default constructor
+   */
+  Compositor();
+  /**
+   * @brief reset Clears the canvas and prepares it for the first frame of the animation
+   * @param rSize Reference to the canvas size
+   * @param eFormat Canvas format. Only QImage::Format_ARGB32 and QImage::Format_RGBA64 are supported
+   * @return true, if the canvas was prepared and false otherwise
+   */
+  bool reset(const QSize& rSize, QImage::Format eFormat = QImage::Format_ARGB32);
+  /**
+   * @brief rewind Clears the canvas and prepares it for the first frame of the animation again,
+   * keeping its size and format
+   */
+  void rewind();
+  /**
+   * @brief compose Disposes of the previous frame and renders the given frame into the canvas
+   * @param rFrame Reference to the decoded frame. It is converted to the canvas format, if needed
+   * @param rControl Reference to the frame control of the frame
+   * @return true, if the frame was rendered and false otherwise
+   */
+  bool compose(const QImage& rFrame, const FrameControl& rControl);
+  /**
+   * @brief restore Replaces the canvas content with the given image, which has to be the canvas
+   * saved by the flush and canvas methods. The next rendered frame continues from it
+   * @param rCanvas Reference to the saved canvas of the same size and format
+   * @return true, if the canvas was restored and false otherwise
+   */
+  bool restore(const QImage& rCanvas);
+  /**
+   * @brief flush Applies the dispose operation of the last rendered frame right away, so that the
+   * canvas holds the background of the next frame. The compose method does this on its own
+   */
+  void flush() { dispose(); }
+  /**
+   * @brief canvas Returns the canvas with all the frames rendered so far. The returned image shares
+   * the data with the canvas, so it should not be kept while further frames are rendered, unless
+   * a copy is wanted
+   * @return Canvas
+   */
+  const QImage& canvas() const { return m_imgCanvas; }
+
+private:
+  /**
+   * @brief dispose Applies the dispose operation of the last rendered frame
+   */
+  void dispose();
+
+private:
+  Blend m_blend;
+  QImage m_imgCanvas;
+  QImage m_imgSaved;
+  QRect m_rectDispose;
+  quint8 m_uiDispose;
+  bool m_bFirst;
+};
+
+} // namespace png
@@ -0,0 +1,226 @@
+#include "compression.h"
+
+#include <cstring>
+
+/*
+ * The backend is selected by libapng.pro. zlib-ng is used through its native API, whose functions
+ * and stream type only differ from zlib by the zng_ prefix.
+ */
+#if defined(LIBAPNG_LIBDEFLATE)
+#include <libdeflate.h>
+#elif defined(LIBAPNG_ZLIB_NG)
+#include <zlib-ng.h>
+#define ZLIB(name) zng_##name
+using ZStream = zng_stream;
+#else
+#include <zlib.h>
+#define ZLIB(name) name
+using ZStream = z_stream;
+#endif
+
+namespace png {
+
+namespace {
+
+/**
+ * @brief cuiAdlerBase Largest prime below 65536, the modulus of the Adler-32 sums
+ */
+const quint32 cuiAdlerBase = 65521U;
+
+#if !defined(LIBAPNG_LIBDEFLATE)
+int zlibStrategy(EncoderOptions::Strategy eStrategy)
+{
+  switch (eStrategy) {
+  case EncoderOptions::Strategy::esFiltered:
+    return Z_FILTERED;
+  case EncoderOptions::Strategy::esRle:
+    return Z_RLE;
+  case EncoderOptions::Strategy::esHuffmanOnly:
+    return Z_HUFFMAN_ONLY;
+  default:
+    return Z_DEFAULT_STRATEGY;
+  }
+}
+#endif
+
+} // namespace
+
+Compression::Backend Compression::backend() const
+{
+#if defined(LIBAPNG_LIBDEFLATE)
+  return Backend::ebLibdeflate;
+#elif defined(LIBAPNG_ZLIB_NG)
+  return Backend::ebZlibNg;
+#else
+  return Backend::ebZlib;
+#endif
+}
+
+bool Compression::supportsBlocks() const
+{
+  return backend() != Backend::ebLibdeflate;
+}
+
+#if defined(LIBAPNG_LIBDEFLATE)
+
+bool Compression::deflate(const QByteArray& rbaRaw, QByteArray& rbaOut, int iLevel,
+                          EncoderOptions::Strategy) const
+{
+  // level 0 is not supported by the older releases, the strategies have no equivalent
+  auto pCompressor = libdeflate_alloc_compressor(qBound(1, iLevel, 9));
+  if (pCompressor == nullptr)
+    return false;
+
+  rbaOut.resize(int(libdeflate_zlib_compress_bound(pCompressor, size_t(rbaRaw.size()))));
+  size_t uiSize = libdeflate_zlib_compress(pCompressor, rbaRaw.constData(), size_t(rbaRaw.size()),
+                                           rbaOut.data(), size_t(rbaOut.size()));
+  libdeflate_free_compressor(pCompressor);
+  rbaOut.resize(int(uiSize));
+  return uiSize > 0U;
+}
+
+bool Compression::deflateBlock(const uchar*, quint32, const uchar*, quint32, bool, int,
+                               EncoderOptions::Strategy, QByteArray&) const
+{
+  return false;
+}
+
+bool Compression::inflate(const QVector<QByteArray>& rvData, QByteArray& rbaRaw) const
+{
+  // libdeflate only takes the whole stream at once
+  QByteArray baData;
+  if (rvData.count() == 1) {
+    baData = rvData.first();
+  } else {
+    for (const auto& rba : rvData)
+      baData.append(rba);
+  }
+
+  auto pDecompressor = libdeflate_alloc_decompressor();
+  if (pDecompressor == nullptr)
+    return false;
+
+  // unlike zlib, libdeflate needs the stream to be complete, including the checksum
+  size_t uiSize = 0U;
+  auto eResult  = libdeflate_zlib_decompress(pDecompressor, baData.constData(),
+                                             size_t(baData.size()), rbaRaw.data(),
+                                             size_t(rbaRaw.size()), &uiSize);
+  libdeflate_free_decompressor(pDecompressor);
+  return (eResult == LIBDEFLATE_SUCCESS) && (uiSize == size_t(rbaRaw.size()));
+}
+
+quint32 Compression::adler32(quint32 uiAdler, const uchar* pData, quint32 uiLen) const
+{
+  return quint32(libdeflate_adler32(uiAdler, pData, uiLen));
+}
+
+#else
+
+bool Compression::deflate(const QByteArray& rbaRaw, QByteArray& rbaOut, int iLevel,
+                          EncoderOptions::Strategy eStrategy) const
+{
+  ZStream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (::ZLIB(deflateInit2)(&zs, qBound(0, iLevel, 9), Z_DEFLATED, 15, 8,
+                         zlibStrategy(eStrategy)) != Z_OK)
+    return false;
+
+  rbaOut.resize(int(::ZLIB(deflateBound)(&zs, quint32(rbaRaw.size()))));
+  zs.next_in   = reinterpret_cast<uchar*>(const_cast<char*>(rbaRaw.constData()));
+  zs.avail_in  = quint32(rbaRaw.size());
+  zs.next_out  = reinterpret_cast<uchar*>(rbaOut.data());
+  zs.avail_out = quint32(rbaOut.size());
+
+  int iResult = ::ZLIB(deflate)(&zs, Z_FINISH);
+  rbaOut.resize(int(zs.total_out));
+  ::ZLIB(deflateEnd)(&zs);
+  return iResult == Z_STREAM_END;
+}
+
+bool Compression::deflateBlock(const uchar* pDict, quint32 uiDictLen, const uchar* pIn,
+                               quint32 uiLen, bool bLast, int iLevel,
+                               EncoderOptions::Strategy eStrategy, QByteArray& rbaOut) const
+{
+  ZStream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (::ZLIB(deflateInit2)(&zs, qBound(0, iLevel, 9), Z_DEFLATED, -15, 8,
+                         zlibStrategy(eStrategy)) != Z_OK)
+    return false;
+
+  if ((uiDictLen > 0U) && (::ZLIB(deflateSetDictionary)(&zs, pDict, uiDictLen) != Z_OK)) {
+    ::ZLIB(deflateEnd)(&zs);
+    return false;
+  }
+
+  // the sync flush appends an empty stored block, which the bound does not account for
+  rbaOut.resize(int(::ZLIB(deflateBound)(&zs, uiLen)) + 16);
+  zs.next_in   = const_cast<uchar*>(pIn);
+  zs.avail_in  = uiLen;
+  zs.next_out  = reinterpret_cast<uchar*>(rbaOut.data());
+  zs.avail_out = quint32(rbaOut.size());
+
+  int iResult = ::ZLIB(deflate)(&zs, bLast == true ? Z_FINISH : Z_SYNC_FLUSH);
+  rbaOut.resize(int(zs.total_out));
+  ::ZLIB(deflateEnd)(&zs);
+  if (bLast == true)
+    return iResult == Z_STREAM_END;
+
+  // the flush is only complete, if some output space was left
+  return (iResult == Z_OK) && (zs.avail_in == 0U) && (zs.avail_out > 0U);
+}
+
+bool Compression::inflate(const QVector<QByteArray>& rvData, QByteArray& rbaRaw) const
+{
+  ZStream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (::ZLIB(inflateInit)(&zs) != Z_OK)
+    return false;
+
+  zs.next_out  = reinterpret_cast<uchar*>(rbaRaw.data());
+  zs.avail_out = quint32(rbaRaw.size());
+
+  int iResult = Z_OK;
+  for (const auto& rba : rvData) {
+    zs.next_in  = reinterpret_cast<uchar*>(const_cast<char*>(rba.constData()));
+    zs.avail_in = quint32(rba.size());
+    while ((zs.avail_in > 0U) && (zs.avail_out > 0U) && (iResult == Z_OK))
+      iResult = ::ZLIB(inflate)(&zs, Z_NO_FLUSH);
+
+    // anything after the expected amount of data is ignored
+    if ((iResult != Z_OK) || (zs.avail_out == 0U))
+      break;
+  }
+
+  bool bComplete = (zs.avail_out == 0U) && ((iResult == Z_OK) || (iResult == Z_STREAM_END));
+  ::ZLIB(inflateEnd)(&zs);
+  return bComplete;
+}
+
+quint32 Compression::adler32(quint32 uiAdler, const uchar* pData, quint32 uiLen) const
+{
+  return quint32(::ZLIB(adler32)(uiAdler, pData, uiLen));
+}
+
+#endif
+
+quint32 Compression::adler32Combine(quint32 uiAdler1, quint32 uiAdler2, quint32 uiLen2) const
+{
+  // the same arithmetic as adler32_combine of zlib, which libdeflate does not provide
+  quint32 uiRem  = uiLen2 % cuiAdlerBase;
+  quint32 uiSum1 = uiAdler1 & 0xFFFFU;
+  quint32 uiSum2 = quint32((quint64(uiRem) * uiSum1) % cuiAdlerBase);
+  uiSum1 += (uiAdler2 & 0xFFFFU) + cuiAdlerBase - 1U;
+  uiSum2 += (uiAdler1 >> 16) + (uiAdler2 >> 16) + cuiAdlerBase - uiRem;
+  if (uiSum1 >= cuiAdlerBase)
+    uiSum1 -= cuiAdlerBase;
+  if (uiSum1 >= cuiAdlerBase)
+    uiSum1 -= cuiAdlerBase;
+  if (uiSum2 >= 2U * cuiAdlerBase)
+    uiSum2 -= 2U * cuiAdlerBase;
+  if (uiSum2 >= cuiAdlerBase)
+    uiSum2 -= cuiAdlerBase;
+
+  return uiSum1 | (uiSum2 << 16);
+}
+
+} // namespace png
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "encoderoptions.h"
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+namespace png {
+
+/**
+ * @brief The Compression class This class wraps the deflate implementation used to compress and
+ * decompress the image data. The backend is chosen when the library is built: libdeflate or
+ * zlib-ng, if either of them is installed, and the system zlib otherwise. All the methods are
+ * thread safe, since no state is kept between the calls.
+ */
+class __declspec(dllexport) Compression
+{
+public:
+  /**
+   * @brief The Backend enum Denotes the deflate implementation the library was built with
+   */
+  enum class Backend {
+    ebZlib,
+    ebZlibNg,
+    ebLibdeflate
+  };
+
+  /**
+   * @brief backend Returns the deflate implementation the library was built with
+   * @return Backend in use
+   */
+  Backend backend() const;
+  /**
+   * @brief supportsBlocks Indicates, whether the backend can prime a raw deflate stream with a
+   * dictionary and end it by a sync flush, which the deflateBlock method needs. libdeflate can not
+   * @return true, if the deflateBlock method is supported and false otherwise
+   */
+  bool supportsBlocks() const;
+  /**
+   * @brief deflate Compresses the data into a zlib stream
+   * @param rbaRaw Reference to the data to compress
+   * @param rbaOut Reference to the output buffer
+   * @param iLevel Compression level from 0 to 9
+   * @param eStrategy Compression strategy, which is ignored by libdeflate
+   * @return true on success and false otherwise
+   */
+  bool deflate(const QByteArray& rbaRaw, QByteArray& rbaOut, int iLevel,
+               EncoderOptions::Strategy eStrategy) const;
+  /**
+   * @brief deflateBlock Compresses the data into a raw deflate stream without the zlib header and
+   * checksum. All the blocks, but the last one, end with a sync flush, which leaves the stream on a
+   * byte boundary without marking its final deflate block, so the blocks can be concatenated
+   * @param pDict Pointer to the data preceding the block, which primes the compression
+   * @param uiDictLen Size of the preceding data in [bytes], at most 32 KiB are used
+   * @param pIn Pointer to the data to compress
+   * @param uiLen Size of the data to compress in [bytes]
+   * @param bLast Indicates, whether this is the last block of the stream
+   * @param iLevel Compression level from 0 to 9
+   * @param eStrategy Compression strategy
+   * @param rbaOut Reference to the output buffer
+   * @return true on success and false otherwise, or if the backend does not support blocks
+   */
+  bool deflateBlock(const uchar* pDict, quint32 uiDictLen, const uchar* pIn, quint32 uiLen,
+                    bool bLast, int iLevel, EncoderOptions::Strategy eStrategy,
+                    QByteArray& rbaOut) const;
+  /**
+   * @brief inflate Decompresses the zlib stream
+   * @param rvData Reference to the zlib stream, possibly split into several pieces
+   * @param rbaRaw Reference to the output buffer, which has to be sized to the expected size
+   * @return true, if exactly the expected amount of data was inflated and false otherwise
+   */
+  bool inflate(const QVector<QByteArray>& rvData, QByteArray& rbaRaw) const;
+  /**
+   * @brief adler32 Continues the Adler-32 calculation with more data. The calculation is started
+   * with the state 1
+   * @param uiAdler Adler-32 of the preceding data
+   * @param pData Pointer to the data
+   * @param uiLen Number of bytes
+   * @return Adler-32 of the preceding data, followed by the given data
+   */
+  quint32 adler32(quint32 uiAdler, const uchar* pData, quint32 uiLen) const;
+  /**
+   * @brief adler32Combine Calculates the Adler-32 of two concatenated blocks from the Adler-32 of
+   * each block, without touching the data
+   * @param uiAdler1 Adler-32 of the first block
+   * @param uiAdler2 Adler-32 of the second block
+   * @param uiLen2 Length of the second block in [bytes]
+   * @return Adler-32 of the first block, followed by the second block
+   */
+  quint32 adler32Combine(quint32 uiAdler1, quint32 uiAdler2, quint32 uiLen2) const;
+};
+
+} // namespace png
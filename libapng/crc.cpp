@@ -1,30 +1,408 @@
 #include "crc.h"
 
 #include <QByteArray>
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LIBAPNG_CRC_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LIBAPNG_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#define LIBAPNG_TARGET_CLMUL __attribute__((target("sse4.1,pclmul")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LIBAPNG_CRC_ARM
+#include <arm_acle.h>
+#if defined(_MSC_VER)
+#include <windows.h>
+#define LIBAPNG_TARGET_CRC
+#else
+#define LIBAPNG_TARGET_CRC __attribute__((target("+crc")))
+#endif
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+
 namespace png {
 
-CRC::CRC()
-{
-  for (quint32 i = 0; i < 256; i++) {
-    quint32 crc = i;
-    for (quint32 j = 0; j < 8; j++) {
-      if (crc & 1) {
-        crc = (crc >> 1) ^ 0xEDB88320;
-      } else {
-        crc >>= 1;
+namespace {
+
+/**
+ * @brief The Tables struct Lookup tables for the slicing-by-8 algorithm. Table 0 is the classic
+ * byte-at-a-time table, table k advances the CRC of a byte by k more zero bytes
+ */
+struct Tables {
+  quint32 m_aTable[8][256];
+  quint32 m_aX2n[32];
+
+  Tables()
+  {
+    for (quint32 i = 0; i < 256; i++) {
+      quint32 crc = i;
+      for (quint32 j = 0; j < 8; j++) {
+        if (crc & 1) {
+          crc = (crc >> 1) ^ 0xEDB88320;
+        } else {
+          crc >>= 1;
+        }
       }
+      m_aTable[0][i] = crc;
+    }
+
+    for (quint32 i = 0; i < 256; i++) {
+      for (int k = 1; k < 8; k++) {
+        quint32 crc    = m_aTable[k - 1][i];
+        m_aTable[k][i] = (crc >> 8) ^ m_aTable[0][crc & 0xFF];
+      }
+    }
+
+    // x^(2^n) modulo the polynomial, starting with x^1
+    quint32 p = 1U << 30;
+    m_aX2n[0] = p;
+    for (int n = 1; n < 32; n++) {
+      p         = multiply(p, p);
+      m_aX2n[n] = p;
     }
-    m_crcTable[i] = crc;
   }
+
+  /**
+   * @brief multiply Multiplies two polynomials modulo the CRC polynomial. Both polynomials and the
+   * result are stored in the reflected bit order, used by the CRC itself
+   * @param a First polynomial
+   * @param b Second polynomial
+   * @return Product modulo the CRC polynomial
+   */
+  static quint32 multiply(quint32 a, quint32 b)
+  {
+    quint32 m = 1U << 31;
+    quint32 p = 0U;
+    for (;;) {
+      if (a & m) {
+        p ^= b;
+        if ((a & (m - 1)) == 0)
+          break;
+      }
+      m >>= 1;
+      b = (b & 1) ? (b >> 1) ^ 0xEDB88320 : b >> 1;
+    }
+    return p;
+  }
+
+  /**
+   * @brief power Returns x^(n * 2^k) modulo the CRC polynomial
+   * @param n Exponent
+   * @param k Additional power of two
+   * @return x^(n * 2^k) modulo the CRC polynomial
+   */
+  quint32 power(quint64 n, unsigned k) const
+  {
+    quint32 p = 1U << 31;
+    while (n != 0) {
+      if (n & 1)
+        p = multiply(m_aX2n[k & 31], p);
+      n >>= 1;
+      k++;
+    }
+    return p;
+  }
+};
+
+const Tables& tables()
+{
+  static const Tables s_tables;
+  return s_tables;
 }
 
-quint32 CRC::calculate(const QByteArray& rba) const
+/**
+ * @brief updateSlicing Portable implementation, which processes 8 bytes per iteration
+ * @param uiCrc Inverted CRC state
+ * @param p Pointer to the data
+ * @param n Number of bytes
+ * @return Updated inverted CRC state
+ */
+quint32 updateSlicing(quint32 uiCrc, const uchar* p, size_t n)
+{
+  const auto& t = tables().m_aTable;
+
+  while ((n > 0) && ((reinterpret_cast<quintptr>(p) & 7) != 0)) {
+    uiCrc = (uiCrc >> 8) ^ t[0][(uiCrc ^ *p++) & 0xFF];
+    --n;
+  }
+
+  while (n >= 8) {
+    // assemble the words byte by byte, so that the result does not depend on endianness
+    quint32 uiLo = uiCrc ^ (quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) |
+                            (quint32(p[3]) << 24));
+    quint32 uiHi = quint32(p[4]) | (quint32(p[5]) << 8) | (quint32(p[6]) << 16) |
+                   (quint32(p[7]) << 24);
+    uiCrc = t[7][uiLo & 0xFF] ^ t[6][(uiLo >> 8) & 0xFF] ^ t[5][(uiLo >> 16) & 0xFF] ^
+            t[4][uiLo >> 24] ^ t[3][uiHi & 0xFF] ^ t[2][(uiHi >> 8) & 0xFF] ^
+            t[1][(uiHi >> 16) & 0xFF] ^ t[0][uiHi >> 24];
+    p += 8;
+    n -= 8;
+  }
+
+  while (n > 0) {
+    uiCrc = (uiCrc >> 8) ^ t[0][(uiCrc ^ *p++) & 0xFF];
+    --n;
+  }
+
+  return uiCrc;
+}
+
+#if defined(LIBAPNG_CRC_X86)
+
+/**
+ * @brief foldClmul Folds blocks of 16 bytes with carry-less multiplication, following "Fast CRC
+ * Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Gopal et al., Intel, 2009)
+ * @param uiCrc Inverted CRC state
+ * @param p Pointer to the data
+ * @param n Number of bytes. Has to be a multiple of 16 and at least 64
+ * @return Updated inverted CRC state
+ */
+LIBAPNG_TARGET_CLMUL quint32 foldClmul(quint32 uiCrc, const uchar* p, size_t n)
+{
+  alignas(16) static const quint64 s_k1k2[] = {0x0154442bd4ULL, 0x01c6e41596ULL};
+  alignas(16) static const quint64 s_k3k4[] = {0x01751997d0ULL, 0x00ccaa009eULL};
+  alignas(16) static const quint64 s_k5k0[] = {0x0163cd6124ULL, 0x0000000000ULL};
+  alignas(16) static const quint64 s_poly[] = {0x01db710641ULL, 0x01f7011641ULL};
+
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+  x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+  x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+  x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+  x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(int(uiCrc)));
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(s_k1k2));
+
+  p += 64;
+  n -= 64;
+
+  // fold four lanes of 16 bytes in parallel
+  while (n >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+    y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+    y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+    y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+    y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+    p += 64;
+    n -= 64;
+  }
+
+  // fold the four lanes into one
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(s_k3k4));
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  // fold the remaining blocks of 16 bytes
+  while (n >= 16) {
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    p += 16;
+    n -= 16;
+  }
+
+  // fold 128 bits to 64 bits
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+
+  x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s_k5k0));
+
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction to 32 bits
+  x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(s_poly));
+
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return quint32(_mm_extract_epi32(x1, 1));
+}
+
+quint32 updateClmul(quint32 uiCrc, const uchar* p, size_t n)
 {
-  quint32 crc = 0xFFFFFFFF;
-  for (unsigned char byte : rba) {
-    crc = (crc >> 8) ^ m_crcTable[(crc & 0xFF) ^ byte];
+  if (n >= 64) {
+    size_t nFold = n & ~size_t(15);
+    uiCrc        = foldClmul(uiCrc, p, nFold);
+    p += nFold;
+    n -= nFold;
   }
-  return crc ^ 0xFFFFFFFF;
+
+  return updateSlicing(uiCrc, p, n);
+}
+
+bool hasClmul()
+{
+  unsigned int ecx = 0;
+#if defined(_MSC_VER)
+  int aiInfo[4];
+  __cpuid(aiInfo, 1);
+  ecx = unsigned(aiInfo[2]);
+#else
+  unsigned int eax, ebx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    return false;
+#endif
+  // bit 1: PCLMULQDQ, bit 19: SSE4.1
+  return ((ecx & (1U << 1)) != 0) && ((ecx & (1U << 19)) != 0);
+}
+
+#elif defined(LIBAPNG_CRC_ARM)
+
+/**
+ * @brief updateArm Uses the ARMv8 CRC32 instructions, which implement the PNG polynomial directly
+ * @param uiCrc Inverted CRC state
+ * @param p Pointer to the data
+ * @param n Number of bytes
+ * @return Updated inverted CRC state
+ */
+LIBAPNG_TARGET_CRC quint32 updateArm(quint32 uiCrc, const uchar* p, size_t n)
+{
+  while ((n > 0) && ((reinterpret_cast<quintptr>(p) & 7) != 0)) {
+    uiCrc = __crc32b(uiCrc, *p++);
+    --n;
+  }
+
+  while (n >= 32) {
+    quint64 a[4];
+    std::memcpy(a, p, sizeof(a));
+    uiCrc = __crc32d(uiCrc, a[0]);
+    uiCrc = __crc32d(uiCrc, a[1]);
+    uiCrc = __crc32d(uiCrc, a[2]);
+    uiCrc = __crc32d(uiCrc, a[3]);
+    p += 32;
+    n -= 32;
+  }
+
+  while (n >= 8) {
+    quint64 a;
+    std::memcpy(&a, p, sizeof(a));
+    uiCrc = __crc32d(uiCrc, a);
+    p += 8;
+    n -= 8;
+  }
+
+  while (n > 0) {
+    uiCrc = __crc32b(uiCrc, *p++);
+    --n;
+  }
+
+  return uiCrc;
+}
+
+bool hasArmCrc()
+{
+#if defined(__ARM_FEATURE_CRC32) || defined(__APPLE__)
+  return true;
+#elif defined(_MSC_VER)
+  return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__linux__) && defined(HWCAP_CRC32)
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+  return false;
+#endif
+}
+
+#endif
+
+} // namespace
+
+CRC::CRC()
+{
+  // make sure the tables are built before the first (possibly concurrent) use
+  tables();
+
+  m_pfnUpdate  = &updateSlicing;
+  m_eAlgorithm = Algorithm::eaSlicing;
+#if defined(LIBAPNG_CRC_X86)
+  if (hasClmul() == true) {
+    m_pfnUpdate  = &updateClmul;
+    m_eAlgorithm = Algorithm::eaClmul;
+  }
+#elif defined(LIBAPNG_CRC_ARM)
+  if (hasArmCrc() == true) {
+    m_pfnUpdate  = &updateArm;
+    m_eAlgorithm = Algorithm::eaArmCrc;
+  }
+#endif
+}
+
+quint32 CRC::calculate(const QByteArray& rba) const
+{
+  return update(0U, rba);
+}
+
+quint32 CRC::update(quint32 uiState, const char* pData, qsizetype iLen) const
+{
+  if (iLen <= 0)
+    return uiState;
+
+  return ~m_pfnUpdate(~uiState, reinterpret_cast<const uchar*>(pData), size_t(iLen));
+}
+
+quint32 CRC::update(quint32 uiState, const QByteArray& rba) const
+{
+  return update(uiState, rba.constData(), rba.size());
+}
+
+quint32 CRC::combine(quint32 uiCrc1, quint32 uiCrc2, qint64 iLen2) const
+{
+  if (iLen2 <= 0)
+    return uiCrc1 ^ uiCrc2;
+
+  // shifting the first CRC over len2 bytes equals multiplying it by x^(8 * len2)
+  return Tables::multiply(tables().power(quint64(iLen2), 3), uiCrc1) ^ uiCrc2;
+}
+
+quint32 CRC::reference(quint32 uiState, const char* pData, qsizetype iLen)
+{
+  if (iLen <= 0)
+    return uiState;
+
+  return ~updateSlicing(~uiState, reinterpret_cast<const uchar*>(pData), size_t(iLen));
 }
 
 } // namespace png
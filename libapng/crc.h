@@ -6,13 +6,24 @@ class QByteArray;
 
 namespace png {
 /**
- * @brief The CRC class This class is used to calculate CRC32
+ * @brief The CRC class This class is used to calculate CRC32. The fastest implementation supported
+ * by the CPU is selected at runtime: carry-less multiplication (PCLMULQDQ) on x86, the CRC32
+ * instructions on ARMv8 and a portable slicing-by-8 table implementation everywhere else.
  */
 class __declspec(dllexport) CRC
 {
 public:
   /**
-   * @brief CRC Default constructor. Builds the internal table
+   * @brief The Algorithm enum Denotes the implementation used by the object
+   */
+  enum class Algorithm {
+    eaSlicing,
+    eaClmul,
+    eaArmCrc
+  };
+
+  /**
+   * @brief CRC Default constructor. Selects the implementation for the current CPU
    */
   CRC();
   /**
@@ -21,9 +32,51 @@ public:
    * @return Calculated value
    */
   quint32 calculate(const QByteArray& rba) const;
+  /**
+   * @brief update Continues the CRC32 calculation with more data. The calculation is started with
+   * the state 0 and the returned state is the CRC32 of all the data passed so far, so that
+   * update(update(0, a), b) equals the CRC32 of a followed by b
+   * @param uiState CRC32 of the preceding data
+   * @param pData Pointer to the data
+   * @param iLen Number of bytes
+   * @return CRC32 of the preceding data, followed by the given data
+   */
+  quint32 update(quint32 uiState, const char* pData, qsizetype iLen) const;
+  /**
+   * @brief update Continues the CRC32 calculation with the content of the byte array
+   * @param uiState CRC32 of the preceding data
+   * @param rba Byte array to continue the calculation with
+   * @return CRC32 of the preceding data, followed by the byte array
+   */
+  quint32 update(quint32 uiState, const QByteArray& rba) const;
+  /**
+   * @brief combine Calculates the CRC32 of two concatenated blocks from the CRC32 of each block,
+   * without touching the data. Since the operation is linear, it can also strip a known prefix:
+   * CRC32(b) = CRC32(a + b) ^ combine(CRC32(a), 0, len(b))
+   * @param uiCrc1 CRC32 of the first block
+   * @param uiCrc2 CRC32 of the second block
+   * @param iLen2 Length of the second block in [bytes]
+   * @return CRC32 of the first block, followed by the second block
+   */
+  quint32 combine(quint32 uiCrc1, quint32 uiCrc2, qint64 iLen2) const;
+  /**
+   * @brief algorithm Returns the implementation selected for the current CPU
+   * @return Selected implementation
+   */
+  Algorithm algorithm() const { return m_eAlgorithm; }
+  /**
+   * @brief reference Continues the CRC32 calculation with the portable implementation, regardless
+   * of the CPU. Useful to verify the accelerated implementations
+   * @param uiState CRC32 of the preceding data
+   * @param pData Pointer to the data
+   * @param iLen Number of bytes
+   * @return CRC32 of the preceding data, followed by the given data
+   */
+  static quint32 reference(quint32 uiState, const char* pData, qsizetype iLen);
 
 private:
-  quint32 m_crcTable[256];
+  quint32 (*m_pfnUpdate)(quint32, const uchar*, size_t);
+  Algorithm m_eAlgorithm;
 };
 
 }
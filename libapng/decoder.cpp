@@ -0,0 +1,397 @@
+#include "decoder.h"
+
+#include <cstring>
+#include <limits>
+
+namespace png {
+
+namespace {
+
+/**
+ * @brief The Pass struct Describes one pass of the Adam7 interlace method
+ */
+struct Pass {
+  quint32 m_uiX;
+  quint32 m_uiY;
+  quint32 m_uiDX;
+  quint32 m_uiDY;
+};
+
+const Pass s_aAdam7[7] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4},
+                          {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}};
+
+const Pass s_passFull = {0, 0, 1, 1};
+
+inline quint32 passSize(quint32 uiSize, quint32 uiStart, quint32 uiStep)
+{
+  return (uiSize > uiStart ? (uiSize - uiStart + uiStep - 1) / uiStep : 0U);
+}
+
+inline quint16 read16(const uchar* p)
+{
+  return quint16((quint16(p[0]) << 8) | p[1]);
+}
+
+/*
+ * Every combination of the color type, the bit depth and the presence of the tRNS color key has its
+ * own row converter, so that the loops over the pixels do not branch on the format. The converter
+ * is selected once per frame.
+ */
+
+/**
+ * @brief sample Returns the i-th sample of a scanline with the bit depth D
+ * @param pSrc Pointer to the scanline
+ * @param i Sample index
+ * @return Sample value
+ */
+template <int D>
+inline quint32 sample(const uchar* pSrc, quint32 i)
+{
+  if constexpr (D == 8) {
+    return pSrc[i];
+  } else {
+    quint32 uiBit = i * D;
+    // samples are packed starting with the most significant bits of each byte
+    int iShift = 8 - D - int(uiBit & 7);
+    return (pSrc[uiBit >> 3] >> iShift) & ((1U << D) - 1U);
+  }
+}
+
+template <int D, bool T>
+void convertGray(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16* puiKey)
+{
+  // the samples are scaled to 8 bits exactly, since 255 is divisible by 1, 3 and 15
+  constexpr quint32 uiScale = 255U / ((1U << D) - 1U);
+  auto pDst32               = reinterpret_cast<QRgb*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    quint32 v = sample<D>(pSrc, x);
+    int iGray = int(v * uiScale);
+    if constexpr (T == true)
+      pDst32[x] = qRgba(iGray, iGray, iGray, v == puiKey[0] ? 0 : 255);
+    else
+      pDst[x] = uchar(iGray);
+  }
+}
+
+template <bool T>
+void convertGray16(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16* puiKey)
+{
+  auto pDst64 = reinterpret_cast<QRgba64*>(pDst);
+  auto pDst16 = reinterpret_cast<quint16*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    quint16 v = read16(pSrc + 2 * x);
+    if constexpr (T == true)
+      pDst64[x] = QRgba64::fromRgba64(v, v, v, v == puiKey[0] ? 0 : 65535);
+    else
+      pDst16[x] = v;
+  }
+}
+
+template <bool T>
+void convertRGB8(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16* puiKey)
+{
+  auto pDst32 = reinterpret_cast<QRgb*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    const uchar* p = pSrc + 3 * x;
+    quint32 uiA    = 255U;
+    if constexpr (T == true) {
+      if ((p[0] == puiKey[0]) && (p[1] == puiKey[1]) && (p[2] == puiKey[2]))
+        uiA = 0U;
+    }
+    pDst32[x] = (uiA << 24) | (quint32(p[0]) << 16) | (quint32(p[1]) << 8) | p[2];
+  }
+}
+
+template <bool T>
+void convertRGB16(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16* puiKey)
+{
+  auto pDst64 = reinterpret_cast<QRgba64*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    quint16 r   = read16(pSrc + 6 * x);
+    quint16 g   = read16(pSrc + 6 * x + 2);
+    quint16 b   = read16(pSrc + 6 * x + 4);
+    quint16 uiA = 65535U;
+    if constexpr (T == true) {
+      if ((r == puiKey[0]) && (g == puiKey[1]) && (b == puiKey[2]))
+        uiA = 0U;
+    }
+    pDst64[x] = QRgba64::fromRgba64(r, g, b, uiA);
+  }
+}
+
+template <int D>
+void convertPalette(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16*)
+{
+  if constexpr (D == 8) {
+    std::memcpy(pDst, pSrc, uiWidth);
+  } else {
+    for (quint32 x = 0; x < uiWidth; ++x)
+      pDst[x] = uchar(sample<D>(pSrc, x));
+  }
+}
+
+void convertGrayAlpha8(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16*)
+{
+  auto pDst32 = reinterpret_cast<QRgb*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    quint32 v = pSrc[2 * x];
+    pDst32[x] = (quint32(pSrc[2 * x + 1]) << 24) | (v << 16) | (v << 8) | v;
+  }
+}
+
+void convertGrayAlpha16(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16*)
+{
+  auto pDst64 = reinterpret_cast<QRgba64*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    quint16 v = read16(pSrc + 4 * x);
+    pDst64[x] = QRgba64::fromRgba64(v, v, v, read16(pSrc + 4 * x + 2));
+  }
+}
+
+void convertRGBA8(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16*)
+{
+  auto pDst32 = reinterpret_cast<QRgb*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    const uchar* p = pSrc + 4 * x;
+    pDst32[x] = (quint32(p[3]) << 24) | (quint32(p[0]) << 16) | (quint32(p[1]) << 8) | p[2];
+  }
+}
+
+void convertRGBA16(const uchar* pSrc, uchar* pDst, quint32 uiWidth, const quint16*)
+{
+  auto pDst64 = reinterpret_cast<QRgba64*>(pDst);
+  for (quint32 x = 0; x < uiWidth; ++x) {
+    const uchar* p = pSrc + 8 * x;
+    pDst64[x]      = QRgba64::fromRgba64(read16(p), read16(p + 2), read16(p + 4), read16(p + 6));
+  }
+}
+
+template <int D>
+Decoder::Converter grayConverter(bool bTransparent)
+{
+  return (bTransparent == true ? &convertGray<D, true> : &convertGray<D, false>);
+}
+
+} // namespace
+
+Decoder::Decoder() : m_bTransparent(false), m_auiTransparent{0, 0, 0} {}
+
+void Decoder::setHeader(const Header& rHeader)
+{
+  m_header = rHeader;
+}
+
+void Decoder::setPalette(const QByteArray& rbaPLTE)
+{
+  m_vPalette.clear();
+  auto p = reinterpret_cast<const uchar*>(rbaPLTE.constData());
+  for (int i = 0; i + 2 < rbaPLTE.size() && m_vPalette.count() < 256; i += 3)
+    m_vPalette << qRgb(p[i], p[i + 1], p[i + 2]);
+}
+
+void Decoder::setTransparency(const QByteArray& rbaTRNS)
+{
+  auto p = reinterpret_cast<const uchar*>(rbaTRNS.constData());
+  switch (m_header.m_uiColorType) {
+  case Header::ectGray:
+    if (rbaTRNS.size() >= 2) {
+      m_auiTransparent[0] = read16(p);
+      m_bTransparent      = true;
+    }
+    break;
+
+  case Header::ectRGB:
+    if (rbaTRNS.size() >= 6) {
+      m_auiTransparent[0] = read16(p);
+      m_auiTransparent[1] = read16(p + 2);
+      m_auiTransparent[2] = read16(p + 4);
+      m_bTransparent      = true;
+    }
+    break;
+
+  case Header::ectPalette:
+    // tRNS has to follow PLTE, so the palette is already known here
+    for (int i = 0; i < qMin(rbaTRNS.size(), m_vPalette.count()); ++i) {
+      auto rgb      = m_vPalette[i];
+      m_vPalette[i] = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), p[i]);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+QImage::Format Decoder::format() const
+{
+  bool bAlpha = m_header.hasAlpha() || m_bTransparent;
+  switch (m_header.m_uiColorType) {
+  case Header::ectPalette:
+    return QImage::Format_Indexed8;
+
+  case Header::ectGray:
+    if (bAlpha == false)
+      return (m_header.m_uiBitDepth == 16 ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8);
+    break;
+
+  case Header::ectRGB:
+    if (bAlpha == false)
+      return (m_header.m_uiBitDepth == 16 ? QImage::Format_RGBX64 : QImage::Format_RGB32);
+    break;
+
+  default:
+    break;
+  }
+
+  return (m_header.m_uiBitDepth == 16 ? QImage::Format_RGBA64 : QImage::Format_ARGB32);
+}
+
+QImage Decoder::decode(const QVector<QByteArray>& rvData, quint32 uiWidth, quint32 uiHeight) const
+{
+  if ((uiWidth == 0U) || (uiHeight == 0U) || (m_header.m_uiBitDepth == 0U))
+    return {};
+
+  bool bInterlaced = (m_header.m_uiInterlace == 1U);
+  const Pass* pPasses = (bInterlaced == true ? s_aAdam7 : &s_passFull);
+  int iPasses         = (bInterlaced == true ? 7 : 1);
+
+  // the exact size of the filtered data is known in advance
+  quint64 uiRawSize = 0U;
+  for (int p = 0; p < iPasses; ++p) {
+    quint32 uiW = passSize(uiWidth, pPasses[p].m_uiX, pPasses[p].m_uiDX);
+    quint32 uiH = passSize(uiHeight, pPasses[p].m_uiY, pPasses[p].m_uiDY);
+    if ((uiW > 0U) && (uiH > 0U))
+      uiRawSize += uiH * (1U + m_header.rowBytes(uiW));
+  }
+
+  if (uiRawSize > quint64(std::numeric_limits<int>::max()))
+    return {};
+
+  QImage img(int(uiWidth), int(uiHeight), format());
+  if (img.isNull() == true)
+    return {};
+
+  if (m_header.m_uiColorType == Header::ectPalette) {
+    auto vColors = m_vPalette;
+    while (vColors.count() < 256)
+      vColors << qRgb(0, 0, 0);
+    img.setColorTable(vColors);
+  }
+
+  auto pfnConvert = converter();
+  if (pfnConvert == nullptr)
+    return {};
+
+  QByteArray baRaw(int(uiRawSize), Qt::Uninitialized);
+  if (m_compression.inflate(rvData, baRaw) == false)
+    return {};
+
+  int iBpp       = m_header.filterBytes();
+  int iPixelSize = pixelSize();
+  auto pRaw      = reinterpret_cast<uchar*>(baRaw.data());
+  QByteArray baZero(int(m_header.rowBytes(uiWidth)), char(0));
+  QByteArray baPixels;
+  if (bInterlaced == true)
+    baPixels.resize(int(uiWidth) * iPixelSize);
+
+  for (int p = 0; p < iPasses; ++p) {
+    const auto& rPass = pPasses[p];
+    quint32 uiW       = passSize(uiWidth, rPass.m_uiX, rPass.m_uiDX);
+    quint32 uiH       = passSize(uiHeight, rPass.m_uiY, rPass.m_uiDY);
+    if ((uiW == 0U) || (uiH == 0U))
+      continue;
+
+    auto uiRowBytes    = quint32(m_header.rowBytes(uiW));
+    const uchar* pPrior = reinterpret_cast<const uchar*>(baZero.constData());
+    for (quint32 y = 0; y < uiH; ++y) {
+      uchar* pRow = pRaw + 1;
+      if (m_filter.unfilter(pRaw[0], pRow, pPrior, uiRowBytes, iBpp) == false)
+        return {};
+
+      int iY = int(rPass.m_uiY + y * rPass.m_uiDY);
+      if (bInterlaced == false) {
+        pfnConvert(pRow, img.scanLine(iY), uiW, m_auiTransparent);
+      } else {
+        // convert the pass row first and then scatter its pixels into the image
+        auto pPixels = reinterpret_cast<uchar*>(baPixels.data());
+        pfnConvert(pRow, pPixels, uiW, m_auiTransparent);
+        uchar* pLine = img.scanLine(iY);
+        for (quint32 x = 0; x < uiW; ++x) {
+          std::memcpy(pLine + (rPass.m_uiX + x * rPass.m_uiDX) * iPixelSize,
+                      pPixels + x * iPixelSize, iPixelSize);
+        }
+      }
+
+      pPrior = pRow;
+      pRaw += 1 + uiRowBytes;
+    }
+  }
+
+  return img;
+}
+
+Decoder::Converter Decoder::converter() const
+{
+  bool bKey = m_bTransparent;
+  switch (m_header.m_uiColorType) {
+  case Header::ectGray:
+    switch (m_header.m_uiBitDepth) {
+    case 1:
+      return grayConverter<1>(bKey);
+    case 2:
+      return grayConverter<2>(bKey);
+    case 4:
+      return grayConverter<4>(bKey);
+    case 8:
+      return grayConverter<8>(bKey);
+    case 16:
+      return (bKey == true ? &convertGray16<true> : &convertGray16<false>);
+    default:
+      return nullptr;
+    }
+
+  case Header::ectRGB:
+    if (m_header.m_uiBitDepth == 16)
+      return (bKey == true ? &convertRGB16<true> : &convertRGB16<false>);
+    return (bKey == true ? &convertRGB8<true> : &convertRGB8<false>);
+
+  case Header::ectPalette:
+    switch (m_header.m_uiBitDepth) {
+    case 1:
+      return &convertPalette<1>;
+    case 2:
+      return &convertPalette<2>;
+    case 4:
+      return &convertPalette<4>;
+    default:
+      return &convertPalette<8>;
+    }
+
+  case Header::ectGrayAlpha:
+    return (m_header.m_uiBitDepth == 16 ? &convertGrayAlpha16 : &convertGrayAlpha8);
+
+  case Header::ectRGBA:
+    return (m_header.m_uiBitDepth == 16 ? &convertRGBA16 : &convertRGBA8);
+
+  default:
+    return nullptr;
+  }
+}
+
+int Decoder::pixelSize() const
+{
+  switch (format()) {
+  case QImage::Format_Indexed8:
+  case QImage::Format_Grayscale8:
+    return 1;
+  case QImage::Format_Grayscale16:
+    return 2;
+  case QImage::Format_RGBA64:
+  case QImage::Format_RGBX64:
+    return 8;
+  default:
+    return 4;
+  }
+}
+
+} // namespace png
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "compression.h"
+#include "filter.h"
+#include "header.h"
+
+#include <QByteArray>
+#include <QImage>
+#include <QVector>
+
+namespace png {
+
+/**
+ * @brief The Decoder class This class decodes the compressed image data of a PNG frame (the
+ * concatenated IDAT or fdAT payloads) directly into a QImage. It inflates the data, reverses the
+ * scanline filters and converts the pixels, without building a standalone PNG first.
+ */
+class __declspec(dllexport) Decoder
+{
+public:
+  /**
+   * @brief Converter Function, which converts one unfiltered scanline into the output format. Its
+   * arguments are the scanline, the output pixels, the number of pixels and the tRNS color key
+   */
+  using Converter = void (*)(const uchar*, uchar*, quint32, const quint16*);
+
+  /**
+   * @brief Decoder Default constructor
+   */
+  Decoder();
+  /**
+   * @brief setHeader Sets the image header, which applies to all the decoded frames
+   * @param rHeader Reference to the header
+   */
+  void setHeader(const Header& rHeader);
+  /**
+   * @brief header Returns the image header
+   * @return Image header
+   */
+  const Header& header() const { return m_header; }
+  /**
+   * @brief setPalette Sets the palette
+   * @param rbaPLTE Reference to the PLTE chunk content
+   */
+  void setPalette(const QByteArray& rbaPLTE);
+  /**
+   * @brief setTransparency Sets the transparency information
+   * @param rbaTRNS Reference to the tRNS chunk content
+   */
+  void setTransparency(const QByteArray& rbaTRNS);
+  /**
+   * @brief format Returns the format of the decoded images
+   * @return Format of the decoded images
+   */
+  QImage::Format format() const;
+  /**
+   * @brief decode Decodes one frame. This method does not modify the object, so it can be called
+   * from several threads at once
+   * @param rvData Reference to the compressed image data, possibly split into several pieces
+   * @param uiWidth Frame width in [pixels]
+   * @param uiHeight Frame height in [pixels]
+   * @return Decoded frame or a null image, if the data could not be decoded
+   */
+  QImage decode(const QVector<QByteArray>& rvData, quint32 uiWidth, quint32 uiHeight) const;
+
+private:
+  /**
+   * @brief converter Returns the row converter specialized for the color type and the bit depth of
+   * the header and for the presence of the tRNS color key
+   * @return Row converter or nullptr, if the header describes an unsupported format
+   */
+  Converter converter() const;
+  /**
+   * @brief pixelSize Returns the size of one pixel in the output format
+   * @return pixel size in [bytes]
+   */
+  int pixelSize() const;
+
+private:
+  Header m_header;
+  Filter m_filter;
+  Compression m_compression;
+  QVector<QRgb> m_vPalette;
+  bool m_bTransparent;
+  quint16 m_auiTransparent[3];
+};
+
+} // namespace png
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+
+#include "header.h"
+
+namespace png {
+
+/**
+ * @brief The EncodedImage struct This struct holds an image compressed by the Encoder, before it
+ * is wrapped into any chunks: the header, the palette of the indexed images and the zlib stream of
+ * the filtered scanlines
+ */
+struct __declspec(dllexport) EncodedImage {
+  Header m_header;
+  QByteArray m_baPLTE;
+  QByteArray m_baTRNS;
+  QByteArray m_baData;
+  quint32 m_uiDataCRC = 0U; ///< CRC32 of m_baData alone, without any chunk name
+
+  /**
+   * @brief isNull Checks, whether the image could not be compressed
+   * @return true, if there is no compressed data and false otherwise
+   */
+  bool isNull() const { return m_baData.isEmpty(); }
+};
+
+} // namespace png
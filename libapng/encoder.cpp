@@ -0,0 +1,415 @@
+#include "encoder.h"
+
+#include <cstring>
+#include <limits>
+
+namespace png {
+
+namespace {
+
+inline void write16(uchar* p, quint16 ui)
+{
+  p[0] = uchar(ui >> 8);
+  p[1] = uchar(ui);
+}
+
+inline void write32(uchar* p, quint32 ui)
+{
+  p[0] = uchar(ui >> 24);
+  p[1] = uchar(ui >> 16);
+  p[2] = uchar(ui >> 8);
+  p[3] = uchar(ui);
+}
+
+/*
+ * Every format stored directly has its own row converter, so that the loops over the pixels do not
+ * branch on the format. The converter is selected once per image.
+ */
+
+void convertBytes(const uchar* pLine, uchar* pDst, int iWidth)
+{
+  std::memcpy(pDst, pLine, size_t(iWidth));
+}
+
+void convertGray16(const uchar* pLine, uchar* pDst, int iWidth)
+{
+  auto pSrc = reinterpret_cast<const quint16*>(pLine);
+  for (int x = 0; x < iWidth; ++x)
+    write16(pDst + 2 * x, pSrc[x]);
+}
+
+/**
+ * @brief pack Packs the bytes into the samples of D bits, the leftmost pixel in the high bits. The
+ * gray levels (S) are rounded to the nearest level of D bits, the palette indices are kept
+ */
+template <int D, bool S>
+void pack(const uchar* pLine, uchar* pDst, int iWidth)
+{
+  constexpr int ciPerByte = 8 / D;
+  constexpr quint32 cuiMax = (1U << D) - 1U;
+  for (int x = 0; x < iWidth; x += ciPerByte) {
+    quint32 uiByte = 0U;
+    for (int i = 0; i < ciPerByte; ++i) {
+      quint32 uiSample = 0U;
+      if (x + i < iWidth)
+        uiSample = (S == true ? (quint32(pLine[x + i]) * cuiMax + 127U) / 255U : pLine[x + i]);
+      uiByte = (uiByte << D) | (uiSample & cuiMax);
+    }
+    *pDst++ = uchar(uiByte);
+  }
+}
+
+template <bool A>
+void convert64(const uchar* pLine, uchar* pDst, int iWidth)
+{
+  auto pSrc = reinterpret_cast<const QRgba64*>(pLine);
+  for (int x = 0; x < iWidth; ++x) {
+    write16(pDst, pSrc[x].red());
+    write16(pDst + 2, pSrc[x].green());
+    write16(pDst + 4, pSrc[x].blue());
+    pDst += 6;
+    if constexpr (A == true) {
+      write16(pDst, pSrc[x].alpha());
+      pDst += 2;
+    }
+  }
+}
+
+template <bool A>
+void convert32(const uchar* pLine, uchar* pDst, int iWidth)
+{
+  auto pSrc = reinterpret_cast<const QRgb*>(pLine);
+  for (int x = 0; x < iWidth; ++x) {
+    pDst[0] = uchar(qRed(pSrc[x]));
+    pDst[1] = uchar(qGreen(pSrc[x]));
+    pDst[2] = uchar(qBlue(pSrc[x]));
+    pDst += 3;
+    if constexpr (A == true) {
+      pDst[0] = uchar(qAlpha(pSrc[x]));
+      pDst += 1;
+    }
+  }
+}
+
+/**
+ * @brief ciWindowSize Size of the deflate window in [bytes], which primes the blocks deflated in
+ * parallel
+ */
+const int ciWindowSize = 32768;
+
+} // namespace
+
+Encoder::Encoder(const EncoderOptions& rOptions) : m_options(rOptions) {}
+
+void Encoder::setOptions(const EncoderOptions& rOptions)
+{
+  m_options = rOptions;
+}
+
+void Encoder::setThreadPool(QThreadPool* pPool)
+{
+  m_runner.setThreadPool(pPool);
+}
+
+EncodedImage Encoder::compress(const QImage& rImg, quint8 uiBitDepth) const
+{
+  EncodedImage image;
+  if (rImg.isNull() == true)
+    return image;
+
+  auto img       = prepare(rImg);
+  image.m_header = header(img);
+  // the palette has to fit into the indices of the bit depth
+  if (((uiBitDepth == 1U) || (uiBitDepth == 2U) || (uiBitDepth == 4U)) &&
+      ((img.format() == QImage::Format_Grayscale8) ||
+       ((img.format() == QImage::Format_Indexed8) && (img.colorCount() <= (1 << uiBitDepth)))))
+    image.m_header.m_uiBitDepth = uiBitDepth;
+  auto uiRowSize = quint32(image.m_header.rowBytes(image.m_header.m_uiWidth));
+  int iBpp       = image.m_header.filterBytes();
+  // the filters do not pay off on the palette indices, as recommended by the PNG specification
+  bool bAdaptive = (m_options.m_eFilterMode == EncoderOptions::FilterMode::efmAdaptive) &&
+                   (image.m_header.m_uiColorType != Header::ectPalette);
+
+  QByteArray baRaw(int((1 + uiRowSize) * image.m_header.m_uiHeight), Qt::Uninitialized);
+  QByteArray baRows(int(2 * uiRowSize), char(0));
+  auto pRaw   = reinterpret_cast<uchar*>(baRaw.data());
+  auto pRow   = reinterpret_cast<uchar*>(baRows.data());
+  auto pPrior     = pRow + uiRowSize;
+  auto pfnConvert = converter(img.format(), image.m_header.m_uiBitDepth);
+  for (int y = 0; y < img.height(); ++y) {
+    std::swap(pRow, pPrior);
+    pfnConvert(img.constScanLine(y), pRow, img.width());
+    filterRow(pRaw, pRow, pPrior, uiRowSize, iBpp, bAdaptive);
+    pRaw += 1 + uiRowSize;
+  }
+
+  if (deflate(baRaw, image.m_baData) == false) {
+    image.m_baData.clear();
+    return image;
+  }
+  image.m_uiDataCRC = m_crc.update(0U, image.m_baData);
+
+  if (image.m_header.m_uiColorType == Header::ectPalette) {
+    for (auto rgb : img.colorTable()) {
+      image.m_baPLTE.append(char(qRed(rgb)));
+      image.m_baPLTE.append(char(qGreen(rgb)));
+      image.m_baPLTE.append(char(qBlue(rgb)));
+      image.m_baTRNS.append(char(qAlpha(rgb)));
+    }
+    // the trailing opaque entries do not need to be stored
+    int iTRNS = image.m_baTRNS.size();
+    while ((iTRNS > 0) && (uchar(image.m_baTRNS.at(iTRNS - 1)) == 255U))
+      --iTRNS;
+    image.m_baTRNS.truncate(iTRNS);
+  }
+
+  return image;
+}
+
+EncodedImage Encoder::compress(const uchar* pBits, int iWidth, int iHeight, qsizetype iStride,
+                               QImage::Format eFormat, const QVector<QRgb>& rvColors) const
+{
+  if ((pBits == nullptr) || (iWidth <= 0) || (iHeight <= 0))
+    return {};
+
+  // the image only wraps the buffer, which is converted by the prepare method if necessary
+  QImage img(pBits, iWidth, iHeight, iStride, eFormat);
+  if (eFormat == QImage::Format_Indexed8)
+    img.setColorTable(rvColors);
+
+  return compress(img);
+}
+
+QByteArray Encoder::encode(const QImage& rImg) const
+{
+  auto image = compress(rImg);
+  if (image.isNull() == true)
+    return {};
+
+  QByteArray ba = QByteArray::fromHex("89504E470D0A1A0A");
+  auto baIHDR   = image.m_header.toBytes();
+  appendChunk(ba, "IHDR", baIHDR.constData(), baIHDR.size());
+  if (image.m_baPLTE.isEmpty() == false)
+    appendChunk(ba, "PLTE", image.m_baPLTE.constData(), image.m_baPLTE.size());
+  if (image.m_baTRNS.isEmpty() == false)
+    appendChunk(ba, "tRNS", image.m_baTRNS.constData(), image.m_baTRNS.size());
+
+  // a single IDAT chunk is stored, the same way as the Writer stores the frames
+  appendChunk(ba, "IDAT", image.m_baData.constData(), image.m_baData.size());
+  appendChunk(ba, "IEND", nullptr, 0);
+  return ba;
+}
+
+QImage Encoder::prepare(const QImage& rImg) const
+{
+  switch (rImg.format()) {
+  case QImage::Format_Indexed8:
+    // the palette has to fit into the PLTE chunk
+    if ((rImg.colorCount() > 0) && (rImg.colorCount() <= 256))
+      return rImg;
+    return rImg.convertToFormat(QImage::Format_ARGB32);
+
+  case QImage::Format_Grayscale8:
+  case QImage::Format_Grayscale16:
+  case QImage::Format_RGB32:
+  case QImage::Format_ARGB32:
+  case QImage::Format_RGBX64:
+  case QImage::Format_RGBA64:
+    return rImg;
+
+  case QImage::Format_RGBA64_Premultiplied:
+    return rImg.convertToFormat(QImage::Format_RGBA64);
+
+  default:
+    return rImg.convertToFormat(rImg.hasAlphaChannel() == true ? QImage::Format_ARGB32
+                                                               : QImage::Format_RGB32);
+  }
+}
+
+Header Encoder::header(const QImage& rImg) const
+{
+  Header header;
+  header.m_uiWidth    = quint32(rImg.width());
+  header.m_uiHeight   = quint32(rImg.height());
+  header.m_uiBitDepth = 8U;
+  switch (rImg.format()) {
+  case QImage::Format_Indexed8:
+    header.m_uiColorType = Header::ectPalette;
+    break;
+  case QImage::Format_Grayscale8:
+    header.m_uiColorType = Header::ectGray;
+    break;
+  case QImage::Format_Grayscale16:
+    header.m_uiBitDepth  = 16U;
+    header.m_uiColorType = Header::ectGray;
+    break;
+  case QImage::Format_RGBX64:
+    header.m_uiBitDepth  = 16U;
+    header.m_uiColorType = Header::ectRGB;
+    break;
+  case QImage::Format_RGBA64:
+    header.m_uiBitDepth  = 16U;
+    header.m_uiColorType = Header::ectRGBA;
+    break;
+  case QImage::Format_RGB32:
+    header.m_uiColorType = Header::ectRGB;
+    break;
+  default:
+    header.m_uiColorType = Header::ectRGBA;
+    break;
+  }
+
+  return header;
+}
+
+Encoder::Converter Encoder::converter(QImage::Format eFormat, quint8 uiBitDepth) const
+{
+  switch (eFormat) {
+  case QImage::Format_Indexed8:
+    switch (uiBitDepth) {
+    case 1U:
+      return &pack<1, false>;
+    case 2U:
+      return &pack<2, false>;
+    case 4U:
+      return &pack<4, false>;
+    default:
+      return &convertBytes;
+    }
+  case QImage::Format_Grayscale8:
+    switch (uiBitDepth) {
+    case 1U:
+      return &pack<1, true>;
+    case 2U:
+      return &pack<2, true>;
+    case 4U:
+      return &pack<4, true>;
+    default:
+      return &convertBytes;
+    }
+  case QImage::Format_Grayscale16:
+    return &convertGray16;
+  case QImage::Format_RGBX64:
+    return &convert64<false>;
+  case QImage::Format_RGBA64:
+    return &convert64<true>;
+  case QImage::Format_RGB32:
+    return &convert32<false>;
+  default:
+    return &convert32<true>;
+  }
+}
+
+void Encoder::filterRow(uchar* pDst, const uchar* pRow, const uchar* pPrior, quint32 uiRowBytes,
+                        int iBpp, bool bAdaptive) const
+{
+  if (bAdaptive == false) {
+    quint8 uiType = (m_options.m_eFilterMode == EncoderOptions::FilterMode::efmFixed
+                       ? m_options.m_uiFilter
+                       : quint8(Filter::eftNone));
+    // an invalid fixed filter falls back to no filtering
+    if (m_filter.filter(uiType, pDst + 1, pRow, pPrior, uiRowBytes, iBpp) == false) {
+      uiType = Filter::eftNone;
+      m_filter.filter(uiType, pDst + 1, pRow, pPrior, uiRowBytes, iBpp);
+    }
+    pDst[0] = uiType;
+    return;
+  }
+
+  // every filter is tried and the one with the smallest sum of absolute differences is kept, the
+  // filtered bytes being taken as signed values
+  QByteArray baTrial(int(uiRowBytes), Qt::Uninitialized);
+  auto pTrial   = reinterpret_cast<uchar*>(baTrial.data());
+  quint64 uiMin = std::numeric_limits<quint64>::max();
+  for (quint8 uiType = Filter::eftNone; uiType <= Filter::eftPaeth; ++uiType) {
+    m_filter.filter(uiType, pTrial, pRow, pPrior, uiRowBytes, iBpp);
+    quint64 uiSum = m_filter.cost(pTrial, uiRowBytes);
+    if (uiSum < uiMin) {
+      uiMin   = uiSum;
+      pDst[0] = uiType;
+      std::memcpy(pDst + 1, pTrial, uiRowBytes);
+    }
+  }
+}
+
+bool Encoder::deflate(const QByteArray& rbaRaw, QByteArray& rbaOut) const
+{
+  if ((m_options.m_iBlockSize > 0) && (rbaRaw.size() > qMax(m_options.m_iBlockSize, ciWindowSize)) &&
+      (m_compression.supportsBlocks() == true))
+    return deflateBlocks(rbaRaw, rbaOut);
+
+  return m_compression.deflate(rbaRaw, rbaOut, m_options.m_iLevel, m_options.m_eStrategy);
+}
+
+bool Encoder::deflateBlocks(const QByteArray& rbaRaw, QByteArray& rbaOut) const
+{
+  // the blocks smaller than the window would not be primed by a full dictionary
+  int iBlockSize = qMax(m_options.m_iBlockSize, ciWindowSize);
+  int iCount     = (rbaRaw.size() + iBlockSize - 1) / iBlockSize;
+  int iLevel     = qBound(0, m_options.m_iLevel, 9);
+  auto eStrategy = m_options.m_eStrategy;
+  auto pRaw      = reinterpret_cast<const uchar*>(rbaRaw.constData());
+
+  QVector<QByteArray> vBlocks(iCount);
+  QVector<quint32> vAdler(iCount);
+  m_runner.run(iCount, [&](int i) {
+    int iStart = i * iBlockSize;
+    int iLen   = qMin(iBlockSize, rbaRaw.size() - iStart);
+    int iDict  = qMin(iStart, ciWindowSize);
+    // a failed block is left empty, the blocks deflated successfully never are
+    if (m_compression.deflateBlock(pRaw + iStart - iDict, quint32(iDict), pRaw + iStart,
+                                   quint32(iLen), i == iCount - 1, iLevel, eStrategy,
+                                   vBlocks[i]) == false)
+      vBlocks[i].clear();
+    vAdler[i] = m_compression.adler32(1U, pRaw + iStart, quint32(iLen));
+  });
+
+  int iSize = 6;
+  for (int i = 0; i < iCount; ++i) {
+    if (vBlocks[i].isEmpty() == true)
+      return false;
+    iSize += vBlocks[i].size();
+  }
+
+  // the zlib header is the one, which zlib writes for the same level and strategy: deflate with
+  // a 32 KiB window and the level flags, followed by the check bits
+  quint16 uiHeader = 0x7800U;
+  if ((iLevel >= 2) && (eStrategy != EncoderOptions::Strategy::esHuffmanOnly) &&
+      (eStrategy != EncoderOptions::Strategy::esRle))
+    uiHeader |= (iLevel < 6 ? 1U : (iLevel == 6 ? 2U : 3U)) << 6;
+  uiHeader += 31U - uiHeader % 31U;
+
+  rbaOut.resize(iSize);
+  auto pOut = reinterpret_cast<uchar*>(rbaOut.data());
+  write16(pOut, uiHeader);
+  pOut += 2;
+
+  quint32 uiAdler = vAdler[0];
+  for (int i = 0; i < iCount; ++i) {
+    std::memcpy(pOut, vBlocks[i].constData(), size_t(vBlocks[i].size()));
+    pOut += vBlocks[i].size();
+    if (i > 0) {
+      uiAdler = m_compression.adler32Combine(
+        uiAdler, vAdler[i], quint32(qMin(iBlockSize, rbaRaw.size() - i * iBlockSize)));
+    }
+  }
+  write32(pOut, uiAdler);
+  return true;
+}
+
+void Encoder::appendChunk(QByteArray& rba, const char* pName, const char* pData, int iLen) const
+{
+  uchar auiLength[4];
+  write32(auiLength, quint32(iLen));
+  rba.append(reinterpret_cast<const char*>(auiLength), 4);
+  rba.append(pName, 4);
+  if (iLen > 0)
+    rba.append(pData, iLen);
+
+  // name and data are checksummed in place, right after the length
+  uchar auiCRC[4];
+  write32(auiCRC, m_crc.update(0U, rba.constData() + rba.size() - iLen - 4, iLen + 4));
+  rba.append(reinterpret_cast<const char*>(auiCRC), 4);
+}
+
+} // namespace png
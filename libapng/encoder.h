@@ -0,0 +1,158 @@
+#pragma once
+
+#include "compression.h"
+#include "crc.h"
+#include "encodedimage.h"
+#include "encoderoptions.h"
+#include "filter.h"
+#include "header.h"
+#include "taskrunner.h"
+
+#include <QByteArray>
+#include <QImage>
+#include <QVector>
+
+namespace png {
+
+/**
+ * @brief The Encoder class This class filters and deflates the image pixels. Unlike QImage::save,
+ * it lets the caller choose the zlib level and strategy and the way the scanline filters are
+ * selected, and it can hand the compressed data over without wrapping it into a PNG image. The
+ * 16-bit, grayscale and indexed images keep their bit depth and color type, the other formats are
+ * stored as 8-bit RGB or RGBA. The large images can be deflated in blocks on several threads.
+ */
+class __declspec(dllexport) Encoder
+{
+public:
+  /**
+   * @brief Encoder Constructor
+   * @param rOptions Reference to the encoding options
+   */
+  explicit Encoder(const EncoderOptions& rOptions = EncoderOptions());
+  /**
+   * @brief setOptions Sets the encoding options
+   * @param rOptions Reference to the encoding options
+   */
+  void setOptions(const EncoderOptions& rOptions);
+  /**
+   * @brief options Returns the encoding options
+   * @return Encoding options
+   */
+  const EncoderOptions& options() const { return m_options; }
+  /**
+   * @brief setThreadPool Sets the thread pool, which deflates the blocks of one image in parallel,
+   * if EncoderOptions::m_iBlockSize is set
+   * @param pPool Pointer to the thread pool. If nullptr, the blocks are deflated one after another
+   * on the calling thread
+   */
+  void setThreadPool(QThreadPool* pPool);
+  /**
+   * @brief threadPool Returns the thread pool, which deflates the blocks
+   * @return Pointer to the thread pool or nullptr, if the blocks are deflated on the calling thread
+   */
+  QThreadPool* threadPool() const { return m_runner.threadPool(); }
+  /**
+   * @brief compress Filters and deflates the image. This method does not modify the object, so it
+   * can be called from several threads at once
+   * @param rImg Reference to the image to compress
+   * @param uiBitDepth Bit depth of 1, 2 or 4 bits, with which the QImage::Format_Grayscale8 images
+   * and the QImage::Format_Indexed8 images, whose palette fits into it, are stored. The gray levels
+   * are rounded to the nearest level of the bit depth, so they should be chosen by the Reducer. The
+   * other images and bit depths are stored as described above
+   * @return Compressed image, which is null if the image is null or could not be compressed
+   */
+  EncodedImage compress(const QImage& rImg, quint8 uiBitDepth = 8U) const;
+  /**
+   * @brief compress Filters and deflates the pixels in the caller's buffer. The buffer is read in
+   * place, unless its format has to be converted first
+   * @param pBits Pointer to the first pixel of the first row
+   * @param iWidth Image width in [pixels]
+   * @param iHeight Image height in [pixels]
+   * @param iStride Distance between the starts of two adjacent rows in [bytes]
+   * @param eFormat Pixel format of the buffer
+   * @param rvColors Reference to the color table of the QImage::Format_Indexed8 buffers
+   * @return Compressed image, which is null if the buffer could not be compressed
+   */
+  EncodedImage compress(const uchar* pBits, int iWidth, int iHeight, qsizetype iStride,
+                        QImage::Format eFormat,
+                        const QVector<QRgb>& rvColors = QVector<QRgb>()) const;
+  /**
+   * @brief encode Encodes the image as a standalone PNG image. This method does not modify the
+   * object, so it can be called from several threads at once
+   * @param rImg Reference to the image to encode
+   * @return PNG image content or an empty array, if the image is null or could not be compressed
+   */
+  QByteArray encode(const QImage& rImg) const;
+
+private:
+  /**
+   * @brief prepare Converts the image into one of the formats, which are stored directly
+   * @param rImg Reference to the image to convert
+   * @return Converted image
+   */
+  QImage prepare(const QImage& rImg) const;
+  /**
+   * @brief header Returns the header, which describes the prepared image
+   * @param rImg Reference to the prepared image
+   * @return Image header
+   */
+  Header header(const QImage& rImg) const;
+  /**
+   * @brief Converter Function, which converts one row of the prepared image into a PNG scanline.
+   * Its arguments are the image row, the scanline without the filter type byte and the width
+   */
+  using Converter = void (*)(const uchar*, uchar*, int);
+
+  /**
+   * @brief converter Returns the row converter specialized for the format of the prepared image
+   * @param eFormat Format of the prepared image
+   * @param uiBitDepth Bit depth of the scanline
+   * @return Row converter
+   */
+  Converter converter(QImage::Format eFormat, quint8 uiBitDepth) const;
+  /**
+   * @brief filterRow Filters one scanline by the filter chosen by the options
+   * @param pDst Pointer to the output, which receives the filter type byte and the filtered bytes
+   * @param pRow Pointer to the scanline
+   * @param pPrior Pointer to the previous scanline
+   * @param uiRowBytes Size of the scanline in [bytes]
+   * @param iBpp Distance between the corresponding bytes of adjacent pixels in [bytes]
+   * @param bAdaptive Indicates, whether the filter is chosen adaptively
+   */
+  void filterRow(uchar* pDst, const uchar* pRow, const uchar* pPrior, quint32 uiRowBytes, int iBpp,
+                 bool bAdaptive) const;
+  /**
+   * @brief deflate Compresses the filtered scanlines
+   * @param rbaRaw Reference to the filtered scanlines
+   * @param rbaOut Reference to the output buffer
+   * @return true on success and false otherwise
+   */
+  bool deflate(const QByteArray& rbaRaw, QByteArray& rbaOut) const;
+  /**
+   * @brief deflateBlocks Compresses the filtered scanlines in blocks of m_iBlockSize bytes on the
+   * thread pool. The blocks are raw deflate streams ended by a sync flush, except for the last one,
+   * so they are simply concatenated between the zlib header and the Adler-32 checksum. The backend
+   * has to support the blocks
+   * @param rbaRaw Reference to the filtered scanlines
+   * @param rbaOut Reference to the output buffer
+   * @return true on success and false otherwise
+   */
+  bool deflateBlocks(const QByteArray& rbaRaw, QByteArray& rbaOut) const;
+  /**
+   * @brief appendChunk Appends the chunk with its length and CRC
+   * @param rba Reference to the array to append to
+   * @param pName Pointer to the four character chunk name
+   * @param pData Pointer to the chunk content
+   * @param iLen Size of the chunk content in [bytes]
+   */
+  void appendChunk(QByteArray& rba, const char* pName, const char* pData, int iLen) const;
+
+private:
+  EncoderOptions m_options;
+  Filter m_filter;
+  CRC m_crc;
+  Compression m_compression;
+  TaskRunner m_runner;
+};
+
+} // namespace png
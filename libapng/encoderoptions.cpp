@@ -0,0 +1,39 @@
+#include "encoderoptions.h"
+
+namespace png {
+
+EncoderOptions EncoderOptions::preset(Preset ePreset)
+{
+  EncoderOptions options;
+  switch (ePreset) {
+  case Preset::epRealtime:
+    options.m_iLevel      = 1;
+    options.m_eStrategy   = Strategy::esRle;
+    options.m_eFilterMode = FilterMode::efmFixed;
+    options.m_uiFilter    = Filter::eftUp;
+    break;
+
+  case Preset::epBalanced:
+    break;
+
+  case Preset::epArchive:
+    options.m_iLevel = 9;
+    break;
+  }
+
+  return options;
+}
+
+std::optional<EncoderOptions> EncoderOptions::preset(const QString& rqsName)
+{
+  if (rqsName == "realtime")
+    return preset(Preset::epRealtime);
+  if (rqsName == "balanced")
+    return preset(Preset::epBalanced);
+  if (rqsName == "archive")
+    return preset(Preset::epArchive);
+
+  return {};
+}
+
+} // namespace png
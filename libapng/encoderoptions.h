@@ -0,0 +1,72 @@
+#pragma once
+
+#include <optional>
+
+#include <QString>
+#include <QtGlobal>
+
+#include "filter.h"
+
+namespace png {
+
+/**
+ * @brief The EncoderOptions struct This struct holds the settings, which trade the encoding speed
+ * for the size of the encoded frames
+ */
+struct __declspec(dllexport) EncoderOptions {
+  /**
+   * @brief The Strategy enum Denotes the zlib compression strategy
+   */
+  enum class Strategy {
+    esDefault,    ///< Z_DEFAULT_STRATEGY
+    esFiltered,   ///< Z_FILTERED, favours the Huffman coding of the filtered data
+    esRle,        ///< Z_RLE, only finds runs of the same byte, which is fast on flat images
+    esHuffmanOnly ///< Z_HUFFMAN_ONLY, does not look for any matches at all
+  };
+
+  /**
+   * @brief The FilterMode enum Denotes how the scanline filters are chosen
+   */
+  enum class FilterMode {
+    efmNone,    ///< the scanlines are not filtered
+    efmFixed,   ///< every scanline is filtered by m_uiFilter
+    efmAdaptive ///< every scanline is filtered by the filter, which gives the smallest sum of
+                ///< absolute differences
+  };
+
+  /**
+   * @brief The Preset enum Denotes the named presets
+   */
+  enum class Preset {
+    epRealtime, ///< zlib level 1, RLE strategy and the Up filter, for live previews
+    epBalanced, ///< zlib level 6 with adaptive filters
+    epArchive   ///< zlib level 9 with adaptive filters, for the smallest files
+  };
+
+  int m_iLevel              = 6;
+  Strategy m_eStrategy      = Strategy::esDefault;
+  FilterMode m_eFilterMode  = FilterMode::efmAdaptive;
+  quint8 m_uiFilter         = Filter::eftNone;
+  /**
+   * @brief m_iBlockSize Size of the blocks of filtered scanlines in [bytes], which are deflated in
+   * parallel and joined into one zlib stream. Each block is primed with the last 32 KiB of the
+   * data before it, so the compression ratio hardly suffers. The frames up to this size and all
+   * the frames, if it is 0, are deflated as one block
+   */
+  int m_iBlockSize = 0;
+
+  /**
+   * @brief preset Returns the options of the named preset
+   * @param ePreset Preset to return
+   * @return Options of the preset
+   */
+  static EncoderOptions preset(Preset ePreset);
+  /**
+   * @brief preset Returns the options of the preset with the given name
+   * @param rqsName Reference to the preset name: "realtime", "balanced" or "archive"
+   * @return Options of the preset or an empty value, if there is no preset with the given name
+   */
+  static std::optional<EncoderOptions> preset(const QString& rqsName);
+};
+
+} // namespace png
@@ -0,0 +1,589 @@
+#include "filter.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LIBAPNG_FILTER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LIBAPNG_TARGET_SSE2
+#else
+#include <cpuid.h>
+#define LIBAPNG_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LIBAPNG_FILTER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace png {
+
+namespace {
+
+/**
+ * @brief paeth Returns the Paeth predictor of the three neighbouring bytes
+ * @param a Byte to the left
+ * @param b Byte above
+ * @param c Byte above and to the left
+ * @return Predicted value
+ */
+inline uchar paeth(int a, int b, int c)
+{
+  int pa = std::abs(b - c);
+  int pb = std::abs(a - c);
+  int pc = std::abs(a + b - 2 * c);
+  if ((pa <= pb) && (pa <= pc))
+    return uchar(a);
+  return uchar(pb <= pc ? b : c);
+}
+
+/*
+ * The bytes of the first pixel have no left neighbour, so they are handled by the head functions.
+ * The tail functions continue from any position at or past the first pixel, which lets the
+ * accelerated implementations hand over the bytes, that do not fill a whole vector.
+ */
+
+void unfilterHead(quint8 uiType, uchar* pRow, const uchar* pPrior, quint32 uiFirst)
+{
+  for (quint32 i = 0; i < uiFirst; ++i) {
+    if (uiType == Filter::eftAverage)
+      pRow[i] = uchar(pRow[i] + (pPrior[i] >> 1));
+    else if ((uiType == Filter::eftUp) || (uiType == Filter::eftPaeth))
+      pRow[i] = uchar(pRow[i] + pPrior[i]);
+  }
+}
+
+void unfilterTail(quint8 uiType, uchar* pRow, const uchar* pPrior, quint32 uiFrom,
+                  quint32 uiRowBytes, quint32 uiBpp)
+{
+  switch (uiType) {
+  case Filter::eftSub:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pRow[i] = uchar(pRow[i] + pRow[i - uiBpp]);
+    break;
+
+  case Filter::eftUp:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pRow[i] = uchar(pRow[i] + pPrior[i]);
+    break;
+
+  case Filter::eftAverage:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pRow[i] = uchar(pRow[i] + ((pRow[i - uiBpp] + pPrior[i]) >> 1));
+    break;
+
+  case Filter::eftPaeth:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pRow[i] = uchar(pRow[i] + paeth(pRow[i - uiBpp], pPrior[i], pPrior[i - uiBpp]));
+    break;
+
+  default:
+    break;
+  }
+}
+
+void filterHead(quint8 uiType, uchar* pDst, const uchar* pRow, const uchar* pPrior,
+                quint32 uiFirst)
+{
+  for (quint32 i = 0; i < uiFirst; ++i) {
+    if (uiType == Filter::eftAverage)
+      pDst[i] = uchar(pRow[i] - (pPrior[i] >> 1));
+    else if ((uiType == Filter::eftUp) || (uiType == Filter::eftPaeth))
+      pDst[i] = uchar(pRow[i] - pPrior[i]);
+    else
+      pDst[i] = pRow[i];
+  }
+}
+
+void filterTail(quint8 uiType, uchar* pDst, const uchar* pRow, const uchar* pPrior,
+                quint32 uiFrom, quint32 uiRowBytes, quint32 uiBpp)
+{
+  switch (uiType) {
+  case Filter::eftNone:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pDst[i] = pRow[i];
+    break;
+
+  case Filter::eftSub:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pDst[i] = uchar(pRow[i] - pRow[i - uiBpp]);
+    break;
+
+  case Filter::eftUp:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pDst[i] = uchar(pRow[i] - pPrior[i]);
+    break;
+
+  case Filter::eftAverage:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pDst[i] = uchar(pRow[i] - ((pRow[i - uiBpp] + pPrior[i]) >> 1));
+    break;
+
+  case Filter::eftPaeth:
+    for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+      pDst[i] = uchar(pRow[i] - paeth(pRow[i - uiBpp], pPrior[i], pPrior[i - uiBpp]));
+    break;
+
+  default:
+    break;
+  }
+}
+
+quint64 costTail(const uchar* pRow, quint32 uiFrom, quint32 uiRowBytes)
+{
+  quint64 uiSum = 0U;
+  for (quint32 i = uiFrom; i < uiRowBytes; ++i)
+    uiSum += quint64(std::abs(int(qint8(pRow[i]))));
+  return uiSum;
+}
+
+bool unfilterScalar(quint8 uiType, uchar* pRow, const uchar* pPrior, quint32 uiRowBytes,
+                    quint32 uiBpp)
+{
+  if (uiType > Filter::eftPaeth)
+    return false;
+
+  quint32 uiFirst = qMin(uiBpp, uiRowBytes);
+  unfilterHead(uiType, pRow, pPrior, uiFirst);
+  unfilterTail(uiType, pRow, pPrior, uiFirst, uiRowBytes, uiBpp);
+  return true;
+}
+
+bool filterScalar(quint8 uiType, uchar* pDst, const uchar* pRow, const uchar* pPrior,
+                  quint32 uiRowBytes, quint32 uiBpp)
+{
+  if (uiType > Filter::eftPaeth)
+    return false;
+
+  quint32 uiFirst = qMin(uiBpp, uiRowBytes);
+  filterHead(uiType, pDst, pRow, pPrior, uiFirst);
+  filterTail(uiType, pDst, pRow, pPrior, uiFirst, uiRowBytes, uiBpp);
+  return true;
+}
+
+quint64 costScalar(const uchar* pRow, quint32 uiRowBytes)
+{
+  return costTail(pRow, 0U, uiRowBytes);
+}
+
+#if defined(LIBAPNG_FILTER_X86)
+
+/*
+ * The Sub, Average and Paeth filters can only be reversed one pixel after another, since every
+ * pixel depends on the one to its left. The pixels of 3 to 8 bytes are reversed with all their
+ * bytes in one vector, the narrower pixels are left to the scalar implementation. Applying the
+ * filters has no such dependency, so 16 bytes are filtered at once regardless of the pixel size.
+ */
+
+/**
+ * @brief loadWidth Returns the number of bytes loaded for one pixel of N bytes. The pixels of 3
+ * and 6 bytes are loaded together with the start of the next pixel, which is then ignored
+ */
+template <quint32 N>
+constexpr quint32 loadWidth()
+{
+  return (N <= 4 ? 4U : 8U);
+}
+
+template <quint32 N>
+LIBAPNG_TARGET_SSE2 inline __m128i loadPixelSse2(const uchar* p)
+{
+  if constexpr (loadWidth<N>() == 4U) {
+    qint32 i;
+    std::memcpy(&i, p, 4);
+    return _mm_cvtsi32_si128(i);
+  } else {
+    return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  }
+}
+
+template <quint32 N>
+LIBAPNG_TARGET_SSE2 inline void storePixelSse2(uchar* p, __m128i v)
+{
+  if constexpr (loadWidth<N>() == 4U) {
+    qint32 i = _mm_cvtsi128_si32(v);
+    std::memcpy(p, &i, N);
+  } else {
+    quint64 ui;
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&ui), v);
+    std::memcpy(p, &ui, N);
+  }
+}
+
+LIBAPNG_TARGET_SSE2 inline __m128i absSse2(__m128i v)
+{
+  return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+/**
+ * @brief paethSse2 Returns the Paeth predictors of the bytes, given in 16-bit lanes
+ */
+LIBAPNG_TARGET_SSE2 inline __m128i paethSse2(__m128i a, __m128i b, __m128i c)
+{
+  __m128i bc   = _mm_sub_epi16(b, c);
+  __m128i ac   = _mm_sub_epi16(a, c);
+  __m128i pa   = absSse2(bc);
+  __m128i pb   = absSse2(ac);
+  __m128i pc   = absSse2(_mm_add_epi16(bc, ac));
+  __m128i notA = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+  __m128i notB = _mm_cmpgt_epi16(pb, pc);
+  __m128i pbc  = _mm_or_si128(_mm_and_si128(notB, c), _mm_andnot_si128(notB, b));
+  return _mm_or_si128(_mm_and_si128(notA, pbc), _mm_andnot_si128(notA, a));
+}
+
+template <quint32 N>
+LIBAPNG_TARGET_SSE2 void unfilterPixelsSse2(quint8 uiType, uchar* pRow, const uchar* pPrior,
+                                            quint32 uiRowBytes)
+{
+  // the scanlines too short for a single load are left to the scalar implementation
+  if (uiRowBytes < loadWidth<N>()) {
+    unfilterScalar(uiType, pRow, pPrior, uiRowBytes, N);
+    return;
+  }
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask = _mm_set1_epi16(0xFF);
+  __m128i a          = zero;
+  __m128i c          = zero;
+  quint32 i          = 0;
+  for (; i + loadWidth<N>() <= uiRowBytes; i += N) {
+    __m128i x = loadPixelSse2<N>(pRow + i);
+    if (uiType == Filter::eftSub) {
+      a = _mm_add_epi8(x, a);
+      storePixelSse2<N>(pRow + i, a);
+      continue;
+    }
+
+    x         = _mm_unpacklo_epi8(x, zero);
+    __m128i b = _mm_unpacklo_epi8(loadPixelSse2<N>(pPrior + i), zero);
+    if (uiType == Filter::eftAverage) {
+      a = _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(_mm_add_epi16(a, b), 1)), mask);
+    } else {
+      // the first pixel has no left neighbours, for which the predictor is the byte above
+      a = _mm_and_si128(_mm_add_epi16(x, paethSse2(a, b, c)), mask);
+      c = b;
+    }
+    storePixelSse2<N>(pRow + i, _mm_packus_epi16(a, a));
+  }
+
+  unfilterTail(uiType, pRow, pPrior, i, uiRowBytes, N);
+}
+
+LIBAPNG_TARGET_SSE2 bool unfilterSse2(quint8 uiType, uchar* pRow, const uchar* pPrior,
+                                      quint32 uiRowBytes, quint32 uiBpp)
+{
+  if (uiType == Filter::eftUp) {
+    quint32 i = 0;
+    for (; i + 16 <= uiRowBytes; i += 16) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrior + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pRow + i), _mm_add_epi8(x, b));
+    }
+    unfilterTail(uiType, pRow, pPrior, i, uiRowBytes, uiBpp);
+    return true;
+  }
+
+  if ((uiType != Filter::eftSub) && (uiType != Filter::eftAverage) &&
+      (uiType != Filter::eftPaeth))
+    return unfilterScalar(uiType, pRow, pPrior, uiRowBytes, uiBpp);
+
+  switch (uiBpp) {
+  case 3:
+    unfilterPixelsSse2<3>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  case 4:
+    unfilterPixelsSse2<4>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  case 6:
+    unfilterPixelsSse2<6>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  case 8:
+    unfilterPixelsSse2<8>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  default:
+    return unfilterScalar(uiType, pRow, pPrior, uiRowBytes, uiBpp);
+  }
+}
+
+LIBAPNG_TARGET_SSE2 bool filterSse2(quint8 uiType, uchar* pDst, const uchar* pRow,
+                                    const uchar* pPrior, quint32 uiRowBytes, quint32 uiBpp)
+{
+  if (uiType > Filter::eftPaeth)
+    return false;
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one  = _mm_set1_epi8(1);
+  // the None and Up filters do not look to the left, so they are vectorized from the first byte
+  quint32 i = ((uiType == Filter::eftNone) || (uiType == Filter::eftUp) ? 0U
+                                                                        : qMin(uiBpp, uiRowBytes));
+  filterHead(uiType, pDst, pRow, pPrior, i);
+  for (; i + 16 <= uiRowBytes; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i));
+    __m128i d = x;
+    if (uiType == Filter::eftUp) {
+      d = _mm_sub_epi8(x, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrior + i)));
+    } else if (uiType != Filter::eftNone) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i - uiBpp));
+      if (uiType == Filter::eftSub) {
+        d = _mm_sub_epi8(x, a);
+      } else if (uiType == Filter::eftAverage) {
+        // the average is rounded up by the instruction, while the filter rounds it down
+        __m128i b   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrior + i));
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        d           = _mm_sub_epi8(x, avg);
+      } else {
+        __m128i b  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrior + i));
+        __m128i c  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrior + i - uiBpp));
+        __m128i lo = paethSse2(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero),
+                               _mm_unpacklo_epi8(c, zero));
+        __m128i hi = paethSse2(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero),
+                               _mm_unpackhi_epi8(c, zero));
+        d          = _mm_sub_epi8(x, _mm_packus_epi16(lo, hi));
+      }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), d);
+  }
+
+  filterTail(uiType, pDst, pRow, pPrior, i, uiRowBytes, uiBpp);
+  return true;
+}
+
+LIBAPNG_TARGET_SSE2 quint64 costSse2(const uchar* pRow, quint32 uiRowBytes)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum        = zero;
+  quint32 i          = 0;
+  for (; i + 16 <= uiRowBytes; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i));
+    // the magnitude of a signed byte is the smaller one of the byte and its negation, unsigned
+    __m128i abs = _mm_min_epu8(x, _mm_sub_epi8(zero, x));
+    sum         = _mm_add_epi64(sum, _mm_sad_epu8(abs, zero));
+  }
+
+  quint64 auiSum[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(auiSum), sum);
+  return auiSum[0] + auiSum[1] + costTail(pRow, i, uiRowBytes);
+}
+
+bool hasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+  return true;
+#elif defined(_MSC_VER)
+  int aiInfo[4];
+  __cpuid(aiInfo, 1);
+  return (aiInfo[3] & (1 << 26)) != 0;
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    return false;
+  return (edx & (1U << 26)) != 0;
+#endif
+}
+
+#elif defined(LIBAPNG_FILTER_NEON)
+
+/*
+ * The pixels are loaded together with the start of the next pixel, which is then ignored.
+ */
+
+inline uint8x8_t loadPixelNeon(const uchar* p)
+{
+  return vld1_u8(p);
+}
+
+template <quint32 N>
+inline void storePixelNeon(uchar* p, uint8x8_t v)
+{
+  quint64 ui = vget_lane_u64(vreinterpret_u64_u8(v), 0);
+  std::memcpy(p, &ui, N);
+}
+
+/**
+ * @brief paethNeon Returns the Paeth predictors of the bytes, given in 16-bit lanes
+ */
+inline int16x8_t paethNeon(int16x8_t a, int16x8_t b, int16x8_t c)
+{
+  int16x8_t bc    = vsubq_s16(b, c);
+  int16x8_t ac    = vsubq_s16(a, c);
+  int16x8_t pa    = vabsq_s16(bc);
+  int16x8_t pb    = vabsq_s16(ac);
+  int16x8_t pc    = vabsq_s16(vaddq_s16(bc, ac));
+  uint16x8_t notA = vorrq_u16(vcgtq_s16(pa, pb), vcgtq_s16(pa, pc));
+  uint16x8_t notB = vcgtq_s16(pb, pc);
+  return vbslq_s16(notA, vbslq_s16(notB, c, b), a);
+}
+
+inline int16x8_t widenNeon(uint8x8_t v)
+{
+  return vreinterpretq_s16_u16(vmovl_u8(v));
+}
+
+inline uint8x8_t narrowNeon(int16x8_t v)
+{
+  return vmovn_u16(vreinterpretq_u16_s16(v));
+}
+
+template <quint32 N>
+void unfilterPixelsNeon(quint8 uiType, uchar* pRow, const uchar* pPrior, quint32 uiRowBytes)
+{
+  // the scanlines too short for a single load are left to the scalar implementation
+  if (uiRowBytes < 8) {
+    unfilterScalar(uiType, pRow, pPrior, uiRowBytes, N);
+    return;
+  }
+
+  uint8x8_t a  = vdup_n_u8(0);
+  int16x8_t aw = vdupq_n_s16(0);
+  int16x8_t cw = vdupq_n_s16(0);
+  quint32 i    = 0;
+  for (; i + 8 <= uiRowBytes; i += N) {
+    uint8x8_t x = loadPixelNeon(pRow + i);
+    if (uiType == Filter::eftSub) {
+      a = vadd_u8(x, a);
+    } else if (uiType == Filter::eftAverage) {
+      // the halving add does not overflow, so the bytes do not have to be widened
+      a = vadd_u8(x, vhadd_u8(a, loadPixelNeon(pPrior + i)));
+    } else {
+      // the first pixel has no left neighbours, for which the predictor is the byte above
+      int16x8_t bw = widenNeon(loadPixelNeon(pPrior + i));
+      a            = vadd_u8(x, narrowNeon(paethNeon(aw, bw, cw)));
+      aw           = widenNeon(a);
+      cw           = bw;
+    }
+    storePixelNeon<N>(pRow + i, a);
+  }
+
+  unfilterTail(uiType, pRow, pPrior, i, uiRowBytes, N);
+}
+
+bool unfilterNeon(quint8 uiType, uchar* pRow, const uchar* pPrior, quint32 uiRowBytes,
+                  quint32 uiBpp)
+{
+  if (uiType == Filter::eftUp) {
+    quint32 i = 0;
+    for (; i + 16 <= uiRowBytes; i += 16)
+      vst1q_u8(pRow + i, vaddq_u8(vld1q_u8(pRow + i), vld1q_u8(pPrior + i)));
+    unfilterTail(uiType, pRow, pPrior, i, uiRowBytes, uiBpp);
+    return true;
+  }
+
+  if ((uiType != Filter::eftSub) && (uiType != Filter::eftAverage) &&
+      (uiType != Filter::eftPaeth))
+    return unfilterScalar(uiType, pRow, pPrior, uiRowBytes, uiBpp);
+
+  switch (uiBpp) {
+  case 3:
+    unfilterPixelsNeon<3>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  case 4:
+    unfilterPixelsNeon<4>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  case 6:
+    unfilterPixelsNeon<6>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  case 8:
+    unfilterPixelsNeon<8>(uiType, pRow, pPrior, uiRowBytes);
+    return true;
+  default:
+    return unfilterScalar(uiType, pRow, pPrior, uiRowBytes, uiBpp);
+  }
+}
+
+bool filterNeon(quint8 uiType, uchar* pDst, const uchar* pRow, const uchar* pPrior,
+                quint32 uiRowBytes, quint32 uiBpp)
+{
+  if (uiType > Filter::eftPaeth)
+    return false;
+
+  // the None and Up filters do not look to the left, so they are vectorized from the first byte
+  quint32 i = ((uiType == Filter::eftNone) || (uiType == Filter::eftUp) ? 0U
+                                                                        : qMin(uiBpp, uiRowBytes));
+  filterHead(uiType, pDst, pRow, pPrior, i);
+  for (; i + 16 <= uiRowBytes; i += 16) {
+    uint8x16_t x = vld1q_u8(pRow + i);
+    uint8x16_t d = x;
+    if (uiType == Filter::eftUp) {
+      d = vsubq_u8(x, vld1q_u8(pPrior + i));
+    } else if (uiType != Filter::eftNone) {
+      uint8x16_t a = vld1q_u8(pRow + i - uiBpp);
+      if (uiType == Filter::eftSub) {
+        d = vsubq_u8(x, a);
+      } else if (uiType == Filter::eftAverage) {
+        d = vsubq_u8(x, vhaddq_u8(a, vld1q_u8(pPrior + i)));
+      } else {
+        uint8x16_t b = vld1q_u8(pPrior + i);
+        uint8x16_t c = vld1q_u8(pPrior + i - uiBpp);
+        int16x8_t lo = paethNeon(widenNeon(vget_low_u8(a)), widenNeon(vget_low_u8(b)),
+                                 widenNeon(vget_low_u8(c)));
+        int16x8_t hi = paethNeon(widenNeon(vget_high_u8(a)), widenNeon(vget_high_u8(b)),
+                                 widenNeon(vget_high_u8(c)));
+        d            = vsubq_u8(x, vcombine_u8(narrowNeon(lo), narrowNeon(hi)));
+      }
+    }
+    vst1q_u8(pDst + i, d);
+  }
+
+  filterTail(uiType, pDst, pRow, pPrior, i, uiRowBytes, uiBpp);
+  return true;
+}
+
+quint64 costNeon(const uchar* pRow, quint32 uiRowBytes)
+{
+  quint64 uiSum = 0U;
+  quint32 i     = 0;
+  for (; i + 16 <= uiRowBytes; i += 16) {
+    uint8x16_t x = vld1q_u8(pRow + i);
+    // the magnitude of a signed byte is the smaller one of the byte and its negation, unsigned
+    uiSum += vaddlvq_u8(vminq_u8(x, vsubq_u8(vdupq_n_u8(0), x)));
+  }
+
+  return uiSum + costTail(pRow, i, uiRowBytes);
+}
+
+#endif
+
+} // namespace
+
+Filter::Filter()
+{
+  m_pfnUnfilter = &unfilterScalar;
+  m_pfnFilter   = &filterScalar;
+  m_pfnCost     = &costScalar;
+  m_eAlgorithm  = Algorithm::eaScalar;
+#if defined(LIBAPNG_FILTER_X86)
+  if (hasSse2() == true) {
+    m_pfnUnfilter = &unfilterSse2;
+    m_pfnFilter   = &filterSse2;
+    m_pfnCost     = &costSse2;
+    m_eAlgorithm  = Algorithm::eaSse2;
+  }
+#elif defined(LIBAPNG_FILTER_NEON)
+  // NEON is a mandatory part of ARMv8
+  m_pfnUnfilter = &unfilterNeon;
+  m_pfnFilter   = &filterNeon;
+  m_pfnCost     = &costNeon;
+  m_eAlgorithm  = Algorithm::eaNeon;
+#endif
+}
+
+bool Filter::referenceUnfilter(quint8 uiType, uchar* pRow, const uchar* pPrior,
+                               quint32 uiRowBytes, int iBpp)
+{
+  return unfilterScalar(uiType, pRow, pPrior, uiRowBytes, quint32(iBpp));
+}
+
+bool Filter::referenceFilter(quint8 uiType, uchar* pDst, const uchar* pRow, const uchar* pPrior,
+                             quint32 uiRowBytes, int iBpp)
+{
+  return filterScalar(uiType, pDst, pRow, pPrior, uiRowBytes, quint32(iBpp));
+}
+
+quint64 Filter::referenceCost(const uchar* pRow, quint32 uiRowBytes)
+{
+  return costScalar(pRow, uiRowBytes);
+}
+
+} // namespace png
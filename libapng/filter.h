@@ -0,0 +1,109 @@
+#pragma once
+
+#include <QtGlobal>
+
+namespace png {
+
+/**
+ * @brief The Filter class This class implements the PNG scanline filters (filter method 0). The
+ * fastest implementation supported by the CPU is selected at runtime: SSE2 on x86, NEON on ARMv8
+ * and a portable scalar implementation everywhere else. All of them give exactly the same results.
+ */
+class __declspec(dllexport) Filter
+{
+public:
+  /**
+   * @brief The Type enum Denotes the filter type, stored in front of every scanline
+   */
+  enum Type : quint8 {
+    eftNone    = 0,
+    eftSub     = 1,
+    eftUp      = 2,
+    eftAverage = 3,
+    eftPaeth   = 4
+  };
+
+  /**
+   * @brief The Algorithm enum Denotes the implementation used by the object
+   */
+  enum class Algorithm {
+    eaScalar,
+    eaSse2,
+    eaNeon
+  };
+
+  /**
+   * @brief Filter Default constructor. Selects the implementation for the current CPU
+   */
+  Filter();
+  /**
+   * @brief unfilter Reverses the filter of one scanline in place
+   * @param uiType Filter type of the scanline
+   * @param pRow Pointer to the scanline, without the filter type byte
+   * @param pPrior Pointer to the previous, already unfiltered scanline. For the first scanline of
+   * an image (or an interlace pass), it should point to a scanline of zeros
+   * @param uiRowBytes Size of the scanline in [bytes]
+   * @param iBpp Distance between the corresponding bytes of adjacent pixels in [bytes]
+   * @return true on success and false, if the filter type is invalid
+   */
+  bool unfilter(quint8 uiType, uchar* pRow, const uchar* pPrior, quint32 uiRowBytes,
+                int iBpp) const
+  {
+    return m_pfnUnfilter(uiType, pRow, pPrior, uiRowBytes, quint32(iBpp));
+  }
+  /**
+   * @brief filter Applies the filter to one scanline
+   * @param uiType Filter type to apply
+   * @param pDst Pointer to the output, which receives uiRowBytes filtered bytes
+   * @param pRow Pointer to the scanline, without the filter type byte
+   * @param pPrior Pointer to the previous scanline. For the first scanline of an image, it should
+   * point to a scanline of zeros
+   * @param uiRowBytes Size of the scanline in [bytes]
+   * @param iBpp Distance between the corresponding bytes of adjacent pixels in [bytes]
+   * @return true on success and false, if the filter type is invalid
+   */
+  bool filter(quint8 uiType, uchar* pDst, const uchar* pRow, const uchar* pPrior,
+              quint32 uiRowBytes, int iBpp) const
+  {
+    return m_pfnFilter(uiType, pDst, pRow, pPrior, uiRowBytes, quint32(iBpp));
+  }
+  /**
+   * @brief cost Returns the sum of the magnitudes of the filtered bytes, taken as signed values.
+   * The filter with the smallest sum usually compresses best, so it is used to choose the filter of
+   * every scanline adaptively
+   * @param pRow Pointer to the filtered scanline, without the filter type byte
+   * @param uiRowBytes Size of the scanline in [bytes]
+   * @return Sum of the magnitudes
+   */
+  quint64 cost(const uchar* pRow, quint32 uiRowBytes) const { return m_pfnCost(pRow, uiRowBytes); }
+  /**
+   * @brief algorithm Returns the implementation selected for the current CPU
+   * @return Selected implementation
+   */
+  Algorithm algorithm() const { return m_eAlgorithm; }
+  /**
+   * @brief referenceUnfilter Reverses the filter with the portable implementation, regardless of
+   * the CPU. Useful to verify the accelerated implementations
+   */
+  static bool referenceUnfilter(quint8 uiType, uchar* pRow, const uchar* pPrior,
+                                quint32 uiRowBytes, int iBpp);
+  /**
+   * @brief referenceFilter Applies the filter with the portable implementation, regardless of the
+   * CPU. Useful to verify the accelerated implementations
+   */
+  static bool referenceFilter(quint8 uiType, uchar* pDst, const uchar* pRow, const uchar* pPrior,
+                              quint32 uiRowBytes, int iBpp);
+  /**
+   * @brief referenceCost Returns the cost of the scanline with the portable implementation,
+   * regardless of the CPU. Useful to verify the accelerated implementations
+   */
+  static quint64 referenceCost(const uchar* pRow, quint32 uiRowBytes);
+
+private:
+  bool (*m_pfnUnfilter)(quint8, uchar*, const uchar*, quint32, quint32);
+  bool (*m_pfnFilter)(quint8, uchar*, const uchar*, const uchar*, quint32, quint32);
+  quint64 (*m_pfnCost)(const uchar*, quint32);
+  Algorithm m_eAlgorithm;
+};
+
+} // namespace png
@@ -0,0 +1,457 @@
+#include "framecache.h"
+
+#include "crc.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace png {
+
+namespace {
+
+/**
+ * @brief cbaMagic Identifies the files of the cache and the version of their layout
+ */
+const QByteArray cbaMagic("APNGFRM1");
+/**
+ * @brief cqsSuffix Suffix of the files of the cache
+ */
+const QString cqsSuffix(".frame");
+/**
+ * @brief ciEntrySize Size of the bookkeeping of one frame kept in memory in [bytes]
+ */
+const qint64 ciEntrySize = 128;
+
+/**
+ * @brief The Hash class Calculates a 128-bit hash in two independent lanes, which both mix every
+ * 8 bytes of the data by a multiplication. It is several times faster than the cryptographic
+ * hashes, but it does not withstand deliberate collisions
+ */
+class Hash
+{
+public:
+  void add(const void* pData, size_t uiLen)
+  {
+    auto p = static_cast<const uchar*>(pData);
+    size_t i = 0;
+    for (; i + 8 <= uiLen; i += 8) {
+      quint64 ui;
+      std::memcpy(&ui, p + i, 8);
+      mix(ui);
+    }
+
+    // the tail is padded by its length, so the data split differently hashes differently
+    quint64 uiTail = uiLen - i;
+    for (; i < uiLen; ++i)
+      uiTail = (uiTail << 8) | p[i];
+    mix(uiTail);
+    m_uiLength += uiLen;
+  }
+
+  template <typename T>
+  void add(T value)
+  {
+    add(&value, sizeof(value));
+  }
+
+  QByteArray result() const
+  {
+    quint64 auiResult[2] = {qToBigEndian(finish(m_uiA ^ m_uiLength)),
+                            qToBigEndian(finish(m_uiB + m_uiA))};
+    return QByteArray(reinterpret_cast<const char*>(auiResult), int(sizeof(auiResult)));
+  }
+
+private:
+  static quint64 rotate(quint64 ui, int iBits) { return (ui << iBits) | (ui >> (64 - iBits)); }
+
+  /**
+   * @brief finish Spreads every bit over the whole value, as the finalizer of MurmurHash3
+   */
+  static quint64 finish(quint64 ui)
+  {
+    ui ^= ui >> 33;
+    ui *= 0xFF51AFD7ED558CCDULL;
+    ui ^= ui >> 33;
+    ui *= 0xC4CEB9FE1A85EC53ULL;
+    return ui ^ (ui >> 33);
+  }
+
+  void mix(quint64 ui)
+  {
+    m_uiA = rotate(m_uiA ^ (ui * 0x9E3779B97F4A7C15ULL), 27) * 0xC2B2AE3D27D4EB4FULL;
+    m_uiB = rotate(m_uiB + (ui * 0x165667B19E3779F9ULL), 31) * 0x85EBCA77C2B2AE63ULL;
+  }
+
+  quint64 m_uiA      = 0x243F6A8885A308D3ULL;
+  quint64 m_uiB      = 0x13198A2E03707344ULL;
+  quint64 m_uiLength = 0U;
+};
+
+void append32(QByteArray& rba, quint32 ui)
+{
+  ui = qToBigEndian(ui);
+  rba.append(reinterpret_cast<const char*>(&ui), 4);
+}
+
+/**
+ * @brief take32 Reads the 32-bit value and moves the offset past it
+ * @param rba Reference to the data
+ * @param riOffset Reference to the offset of the value
+ * @param rui Reference to the value
+ * @return true on success and false, if the data ends before the value
+ */
+bool take32(const QByteArray& rba, int& riOffset, quint32& rui)
+{
+  if (riOffset + 4 > rba.size())
+    return false;
+
+  rui = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(rba.constData() + riOffset));
+  riOffset += 4;
+  return true;
+}
+
+/**
+ * @brief takeArray Reads the array, preceded by its size, and moves the offset past it
+ * @param rba Reference to the data
+ * @param riOffset Reference to the offset of the size
+ * @param rbaArray Reference to the array
+ * @return true on success and false, if the data ends before the array
+ */
+bool takeArray(const QByteArray& rba, int& riOffset, QByteArray& rbaArray)
+{
+  quint32 uiSize = 0U;
+  if ((take32(rba, riOffset, uiSize) == false) || (uiSize > quint32(rba.size() - riOffset)))
+    return false;
+
+  rbaArray = rba.mid(riOffset, int(uiSize));
+  riOffset += int(uiSize);
+  return true;
+}
+
+} // namespace
+
+FrameCache::FrameCache()
+  : m_iMemoryBudget(64 * 1024 * 1024), m_iMemoryBytes(0), m_iDiskBudget(0), m_iDiskBytes(0),
+    m_uiUsed(0U), m_uiHits(0U), m_uiMisses(0U)
+{
+}
+
+FrameCache* FrameCache::globalInstance()
+{
+  static FrameCache cache;
+  return &cache;
+}
+
+void FrameCache::setMemoryBudget(qint64 iBytes)
+{
+  QMutexLocker locker(&m_mutex);
+  m_iMemoryBudget = qMax<qint64>(0, iBytes);
+  evictMemory();
+}
+
+qint64 FrameCache::memoryBudget() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_iMemoryBudget;
+}
+
+qint64 FrameCache::memoryUsage() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_iMemoryBytes;
+}
+
+bool FrameCache::setDiskCache(const QString& rqsDir, qint64 iBytes)
+{
+  // the directory is created and listed without the lock, so that the other threads are not held up
+  bool bOk = true;
+  QString qsDirectory;
+  QFileInfoList vInfo;
+  if (rqsDir.isEmpty() == false) {
+    QDir dir(rqsDir);
+    bOk = dir.mkpath(".");
+    if (bOk == true) {
+      // the files of the previous processes are ordered from the least recently modified one
+      qsDirectory = dir.absolutePath();
+      vInfo = dir.entryInfoList({"*" + cqsSuffix}, QDir::Files, QDir::Time | QDir::Reversed);
+    }
+  }
+
+  QMutexLocker locker(&m_mutex);
+  m_hashDisk.clear();
+  m_mapDiskOrder.clear();
+  m_iDiskBytes  = 0;
+  m_iDiskBudget = qMax<qint64>(0, iBytes);
+  m_qsDirectory = qsDirectory;
+  for (const auto& rInfo : vInfo) {
+    auto baKey = QByteArray::fromHex(rInfo.completeBaseName().toLatin1());
+    if (baKey.size() != 16)
+      continue;
+
+    Entry entry{EncodedImage(), rInfo.size(), ++m_uiUsed};
+    m_hashDisk.insert(baKey, entry);
+    m_mapDiskOrder.insert(entry.m_uiUsed, baKey);
+    m_iDiskBytes += entry.m_iSize;
+  }
+
+  auto vqsEvicted = evictDisk();
+  locker.unlock();
+  removeFiles(vqsEvicted);
+  return bOk;
+}
+
+QString FrameCache::diskDirectory() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_qsDirectory;
+}
+
+qint64 FrameCache::diskBudget() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_iDiskBudget;
+}
+
+qint64 FrameCache::diskUsage() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_iDiskBytes;
+}
+
+quint64 FrameCache::hits() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_uiHits;
+}
+
+quint64 FrameCache::misses() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_uiMisses;
+}
+
+QByteArray FrameCache::key(const QImage& rImg, const QByteArray& rbaSettings)
+{
+  Hash hash;
+  hash.add(rbaSettings.constData(), size_t(rbaSettings.size()));
+  hash.add(qint32(rImg.format()));
+  hash.add(qint32(rImg.width()));
+  hash.add(qint32(rImg.height()));
+  for (auto rgb : rImg.colorTable())
+    hash.add(quint32(rgb));
+
+  const size_t uiRow = (size_t(rImg.width()) * size_t(rImg.depth()) + 7U) / 8U;
+  for (int y = 0; y < rImg.height(); ++y)
+    hash.add(rImg.constScanLine(y), uiRow);
+
+  return hash.result();
+}
+
+bool FrameCache::contains(const QByteArray& rbaKey) const
+{
+  QMutexLocker locker(&m_mutex);
+  return (m_hashMemory.contains(rbaKey) == true) || (m_hashDisk.contains(rbaKey) == true);
+}
+
+std::optional<EncodedImage> FrameCache::find(const QByteArray& rbaKey)
+{
+  QMutexLocker locker(&m_mutex);
+  auto it = m_hashMemory.find(rbaKey);
+  if (it != m_hashMemory.end()) {
+    touch(it.value(), m_mapMemoryOrder, rbaKey);
+    ++m_uiHits;
+    return it.value().m_image;
+  }
+
+  if (m_hashDisk.contains(rbaKey) == false) {
+    ++m_uiMisses;
+    return {};
+  }
+
+  // the file is read without the lock, so that the other threads are not held up by the disk
+  auto qsPath = path(rbaKey);
+  locker.unlock();
+  auto optImage = load(qsPath);
+  locker.relock();
+
+  // the entry may have been evicted or the directory changed in the meantime
+  auto itDisk = m_hashDisk.find(rbaKey);
+  bool bEntry = (itDisk != m_hashDisk.end()) && (path(rbaKey) == qsPath);
+  if (optImage.has_value() == true) {
+    if (bEntry == true)
+      touch(itDisk.value(), m_mapDiskOrder, rbaKey);
+    keep(rbaKey, optImage.value());
+    ++m_uiHits;
+    return optImage;
+  }
+
+  // the file was removed or damaged by someone else
+  ++m_uiMisses;
+  if (bEntry == true) {
+    m_iDiskBytes -= itDisk.value().m_iSize;
+    m_mapDiskOrder.remove(itDisk.value().m_uiUsed);
+    m_hashDisk.erase(itDisk);
+    locker.unlock();
+    QFile::remove(qsPath);
+  }
+
+  return {};
+}
+
+void FrameCache::insert(const QByteArray& rbaKey, const EncodedImage& rImage)
+{
+  if (rImage.isNull() == true)
+    return;
+
+  QMutexLocker locker(&m_mutex);
+  keep(rbaKey, rImage);
+  if ((m_qsDirectory.isEmpty() == true) || (m_hashDisk.contains(rbaKey) == true))
+    return;
+
+  // the file is written without the lock, QSaveFile only replaces it once it is complete
+  auto qsPath = path(rbaKey);
+  locker.unlock();
+  qint64 iSize = store(qsPath, rImage);
+  locker.relock();
+
+  // another thread may have stored the same frame or changed the directory in the meantime
+  if ((iSize > 0) && (m_hashDisk.contains(rbaKey) == false) && (path(rbaKey) == qsPath)) {
+    Entry entry{EncodedImage(), iSize, ++m_uiUsed};
+    m_hashDisk.insert(rbaKey, entry);
+    m_mapDiskOrder.insert(entry.m_uiUsed, rbaKey);
+    m_iDiskBytes += iSize;
+    auto vqsEvicted = evictDisk();
+    locker.unlock();
+    removeFiles(vqsEvicted);
+  }
+}
+
+void FrameCache::clear()
+{
+  QMutexLocker locker(&m_mutex);
+  QStringList vqsFiles;
+  for (auto it = m_hashDisk.constBegin(); it != m_hashDisk.constEnd(); ++it)
+    vqsFiles << path(it.key());
+
+  m_hashMemory.clear();
+  m_mapMemoryOrder.clear();
+  m_hashDisk.clear();
+  m_mapDiskOrder.clear();
+  m_iMemoryBytes = 0;
+  m_iDiskBytes   = 0;
+  locker.unlock();
+  removeFiles(vqsFiles);
+}
+
+void FrameCache::touch(Entry& rEntry, QMap<quint64, QByteArray>& rmapOrder,
+                       const QByteArray& rbaKey)
+{
+  rmapOrder.remove(rEntry.m_uiUsed);
+  rEntry.m_uiUsed = ++m_uiUsed;
+  rmapOrder.insert(rEntry.m_uiUsed, rbaKey);
+}
+
+void FrameCache::keep(const QByteArray& rbaKey, const EncodedImage& rImage)
+{
+  qint64 iSize = ciEntrySize + rImage.m_baData.size() + rImage.m_baPLTE.size() +
+                 rImage.m_baTRNS.size();
+  // the frames larger than the whole budget would only evict all the others
+  if ((m_hashMemory.contains(rbaKey) == true) || (iSize > m_iMemoryBudget))
+    return;
+
+  Entry entry{rImage, iSize, ++m_uiUsed};
+  m_hashMemory.insert(rbaKey, entry);
+  m_mapMemoryOrder.insert(entry.m_uiUsed, rbaKey);
+  m_iMemoryBytes += iSize;
+  evictMemory();
+}
+
+void FrameCache::evictMemory()
+{
+  while ((m_iMemoryBytes > m_iMemoryBudget) && (m_mapMemoryOrder.isEmpty() == false)) {
+    auto baKey = m_mapMemoryOrder.take(m_mapMemoryOrder.firstKey());
+    m_iMemoryBytes -= m_hashMemory.take(baKey).m_iSize;
+  }
+}
+
+QStringList FrameCache::evictDisk()
+{
+  QStringList vqsEvicted;
+  while ((m_iDiskBytes > m_iDiskBudget) && (m_mapDiskOrder.isEmpty() == false)) {
+    auto baKey = m_mapDiskOrder.take(m_mapDiskOrder.firstKey());
+    m_iDiskBytes -= m_hashDisk.take(baKey).m_iSize;
+    vqsEvicted << path(baKey);
+  }
+
+  return vqsEvicted;
+}
+
+void FrameCache::removeFiles(const QStringList& rvqsFiles)
+{
+  // a frame stored again in the meantime loses its file, which the find method treats as a miss
+  for (const auto& rqsFile : rvqsFiles)
+    QFile::remove(rqsFile);
+}
+
+QString FrameCache::path(const QByteArray& rbaKey) const
+{
+  return m_qsDirectory + "/" + QString::fromLatin1(rbaKey.toHex()) + cqsSuffix;
+}
+
+std::optional<EncodedImage> FrameCache::load(const QString& rqsPath)
+{
+  QFile f(rqsPath);
+  if (f.open(QFile::ReadOnly) == false)
+    return {};
+
+  auto ba = f.readAll();
+  f.close();
+
+  // the layout is the magic, the IHDR content, the CRC of the data and the arrays with their sizes
+  EncodedImage image;
+  int iOffset = cbaMagic.size() + 13;
+  if ((ba.startsWith(cbaMagic) == false) || (ba.size() < iOffset))
+    return {};
+
+  auto optHeader = Header::parse(ba.mid(cbaMagic.size(), 13));
+  if ((optHeader.has_value() == false) || (take32(ba, iOffset, image.m_uiDataCRC) == false) ||
+      (takeArray(ba, iOffset, image.m_baPLTE) == false) ||
+      (takeArray(ba, iOffset, image.m_baTRNS) == false) ||
+      (takeArray(ba, iOffset, image.m_baData) == false) || (iOffset != ba.size()))
+    return {};
+
+  image.m_header = optHeader.value();
+  if ((image.isNull() == true) || (CRC().calculate(image.m_baData) != image.m_uiDataCRC))
+    return {};
+
+  return image;
+}
+
+qint64 FrameCache::store(const QString& rqsPath, const EncodedImage& rImage)
+{
+  QByteArray ba = cbaMagic;
+  ba.append(rImage.m_header.toBytes());
+  append32(ba, rImage.m_uiDataCRC);
+  append32(ba, quint32(rImage.m_baPLTE.size()));
+  ba.append(rImage.m_baPLTE);
+  append32(ba, quint32(rImage.m_baTRNS.size()));
+  ba.append(rImage.m_baTRNS);
+  append32(ba, quint32(rImage.m_baData.size()));
+  ba.append(rImage.m_baData);
+
+  // the other processes never see a partially written file
+  QSaveFile f(rqsPath);
+  if ((f.open(QIODevice::WriteOnly) == false) || (f.write(ba) != ba.size()) ||
+      (f.commit() == false))
+    return 0;
+
+  return ba.size();
+}
+
+} // namespace png
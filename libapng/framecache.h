@@ -0,0 +1,199 @@
+#pragma once
+
+#include <optional>
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include "encodedimage.h"
+
+namespace png {
+
+/**
+ * @brief The FrameCache class This class keeps the compressed frames, so that the frames shared by
+ * several animations, like intros, logos and backgrounds, are only compressed once. The frames are
+ * found by a key, which is a fast 128-bit hash of their pixels and of the settings, with which they
+ * were compressed. The cache is limited by the memory budget and optionally extended by a directory
+ * on the disk with its own budget, which also keeps the frames for the next processes. When either
+ * budget is exceeded, the least recently used frames are evicted first. The hash is not meant to
+ * withstand deliberate collisions, so the cache should only be shared by trusted users. All the
+ * methods are thread safe.
+ */
+class __declspec(dllexport) FrameCache
+{
+public:
+  /**
+   * @brief FrameCache Default constructor. The memory budget is 64 MiB and the disk is not used
+   */
+  FrameCache();
+  /**
+   * @brief globalInstance Returns the cache shared by the whole process
+   * @return Pointer to the process wide cache
+   */
+  static FrameCache* globalInstance();
+  /**
+   * @brief setMemoryBudget Sets the maximal size of the frames kept in memory and evicts the least
+   * recently used frames, until they fit
+   * @param iBytes Maximal size in [bytes]. If 0, no frames are kept in memory
+   */
+  void setMemoryBudget(qint64 iBytes);
+  /**
+   * @brief memoryBudget Returns the maximal size of the frames kept in memory
+   * @return Maximal size in [bytes]
+   */
+  qint64 memoryBudget() const;
+  /**
+   * @brief memoryUsage Returns the size of the frames kept in memory
+   * @return Size in [bytes]
+   */
+  qint64 memoryUsage() const;
+  /**
+   * @brief setDiskCache Sets the directory, in which the frames are stored as well, and the maximal
+   * size of the stored frames. The frames already stored in the directory are taken over, the
+   * least recently modified ones being evicted first
+   * @param rqsDir Reference to the path of the directory, which is created if necessary. If empty,
+   * the disk is not used
+   * @param iBytes Maximal size of the stored frames in [bytes]
+   * @return true on success and false, if the directory could not be created
+   */
+  bool setDiskCache(const QString& rqsDir, qint64 iBytes);
+  /**
+   * @brief diskDirectory Returns the directory, in which the frames are stored
+   * @return Path of the directory or an empty string, if the disk is not used
+   */
+  QString diskDirectory() const;
+  /**
+   * @brief diskBudget Returns the maximal size of the frames stored on the disk
+   * @return Maximal size in [bytes]
+   */
+  qint64 diskBudget() const;
+  /**
+   * @brief diskUsage Returns the size of the frames stored on the disk
+   * @return Size in [bytes]
+   */
+  qint64 diskUsage() const;
+  /**
+   * @brief hits Returns the number of frames found in the cache
+   * @return Number of frames found
+   */
+  quint64 hits() const;
+  /**
+   * @brief misses Returns the number of frames looked up in vain
+   * @return Number of frames not found
+   */
+  quint64 misses() const;
+  /**
+   * @brief key Returns the key of the image, compressed with the given settings. Only the pixels
+   * within the width of the rows count, the padding at their end does not
+   * @param rImg Reference to the image
+   * @param rbaSettings Reference to the settings, which change the compressed frame besides the
+   * pixels, in any serialized form
+   * @return Key of 16 bytes
+   */
+  static QByteArray key(const QImage& rImg, const QByteArray& rbaSettings);
+  /**
+   * @brief contains Indicates, whether the frame is in memory or on the disk, without marking it as
+   * used or counting a miss
+   * @param rbaKey Reference to the key of the frame
+   * @return true, if the frame is in the cache and false otherwise
+   */
+  bool contains(const QByteArray& rbaKey) const;
+  /**
+   * @brief find Finds the frame in memory or on the disk and marks it as the most recently used
+   * @param rbaKey Reference to the key of the frame
+   * @return Compressed frame or an empty value, if it is not in the cache
+   */
+  std::optional<EncodedImage> find(const QByteArray& rbaKey);
+  /**
+   * @brief insert Adds the frame to the memory and to the disk, if it is used
+   * @param rbaKey Reference to the key of the frame
+   * @param rImage Reference to the compressed frame
+   */
+  void insert(const QByteArray& rbaKey, const EncodedImage& rImage);
+  /**
+   * @brief clear Removes all the frames from the memory and from the disk
+   */
+  void clear();
+
+private:
+  /**
+   * @brief The Entry struct Holds the size of a cached frame and its last use
+   */
+  struct Entry {
+    EncodedImage m_image;
+    qint64 m_iSize;
+    quint64 m_uiUsed;
+  };
+
+  /**
+   * @brief touch Marks the entry as the most recently used
+   * @param rEntry Reference to the entry
+   * @param rmapOrder Reference to the entries ordered by their last use
+   * @param rbaKey Reference to the key of the entry
+   */
+  void touch(Entry& rEntry, QMap<quint64, QByteArray>& rmapOrder, const QByteArray& rbaKey);
+  /**
+   * @brief keep Adds the frame to the memory and evicts the least recently used frames, until the
+   * frames fit into the budget
+   * @param rbaKey Reference to the key of the frame
+   * @param rImage Reference to the compressed frame
+   */
+  void keep(const QByteArray& rbaKey, const EncodedImage& rImage);
+  /**
+   * @brief evictMemory Removes the least recently used frames from memory, until the rest fits
+   */
+  void evictMemory();
+  /**
+   * @brief evictDisk Drops the least recently used frames from the disk cache, until the rest fits.
+   * Their files are only listed, so that they can be removed, once the lock is released
+   * @return Paths of the files of the evicted frames
+   */
+  QStringList evictDisk();
+  /**
+   * @brief removeFiles Removes the files of the frames dropped from the disk cache. It is called
+   * without the lock
+   * @param rvqsFiles Reference to the paths of the files
+   */
+  static void removeFiles(const QStringList& rvqsFiles);
+  /**
+   * @brief path Returns the path of the file, which stores the frame
+   * @param rbaKey Reference to the key of the frame
+   * @return Path of the file
+   */
+  QString path(const QByteArray& rbaKey) const;
+  /**
+   * @brief load Reads the frame from the disk and verifies it. It is called without the lock
+   * @param rqsPath Reference to the path of the file
+   * @return Compressed frame or an empty value, if the file is missing or damaged
+   */
+  static std::optional<EncodedImage> load(const QString& rqsPath);
+  /**
+   * @brief store Writes the frame to the disk. It is called without the lock
+   * @param rqsPath Reference to the path of the file
+   * @param rImage Reference to the compressed frame
+   * @return Size of the file in [bytes] or 0, if it could not be written
+   */
+  static qint64 store(const QString& rqsPath, const EncodedImage& rImage);
+
+private:
+  mutable QMutex m_mutex;
+  QHash<QByteArray, Entry> m_hashMemory;
+  QMap<quint64, QByteArray> m_mapMemoryOrder;
+  QHash<QByteArray, Entry> m_hashDisk;
+  QMap<quint64, QByteArray> m_mapDiskOrder;
+  QString m_qsDirectory;
+  qint64 m_iMemoryBudget;
+  qint64 m_iMemoryBytes;
+  qint64 m_iDiskBudget;
+  qint64 m_iDiskBytes;
+  quint64 m_uiUsed;
+  quint64 m_uiHits;
+  quint64 m_uiMisses;
+};
+
+} // namespace png
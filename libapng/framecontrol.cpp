@@ -0,0 +1,71 @@
+#include "framecontrol.h"
+
+namespace png {
+
+namespace {
+
+inline quint32 read32(const uchar* p)
+{
+  return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | p[3];
+}
+
+inline void write32(uchar* p, quint32 ui)
+{
+  p[0] = uchar(ui >> 24);
+  p[1] = uchar(ui >> 16);
+  p[2] = uchar(ui >> 8);
+  p[3] = uchar(ui);
+}
+
+} // namespace
+
+std::optional<FrameControl> FrameControl::parse(const QByteArray& rba)
+{
+  if (rba.size() < 26)
+    return {};
+
+  auto p = reinterpret_cast<const uchar*>(rba.constData());
+  FrameControl fc;
+  fc.m_uiSequence = read32(p);
+  fc.m_uiWidth    = read32(p + 4);
+  fc.m_uiHeight   = read32(p + 8);
+  fc.m_uiX        = read32(p + 12);
+  fc.m_uiY        = read32(p + 16);
+  fc.m_uiDelayNum = quint16((p[20] << 8) | p[21]);
+  fc.m_uiDelayDen = quint16((p[22] << 8) | p[23]);
+  fc.m_uiDispose  = p[24];
+  fc.m_uiBlend    = p[25];
+
+  if ((fc.m_uiWidth == 0U) || (fc.m_uiHeight == 0U) || (fc.m_uiDispose > edoPrevious) ||
+      (fc.m_uiBlend > eboOver))
+    return {};
+
+  return fc;
+}
+
+QByteArray FrameControl::toBytes() const
+{
+  QByteArray ba(26, char(0));
+  auto p = reinterpret_cast<uchar*>(ba.data());
+  write32(p, m_uiSequence);
+  write32(p + 4, m_uiWidth);
+  write32(p + 8, m_uiHeight);
+  write32(p + 12, m_uiX);
+  write32(p + 16, m_uiY);
+  p[20] = uchar(m_uiDelayNum >> 8);
+  p[21] = uchar(m_uiDelayNum);
+  p[22] = uchar(m_uiDelayDen >> 8);
+  p[23] = uchar(m_uiDelayDen);
+  p[24] = m_uiDispose;
+  p[25] = m_uiBlend;
+  return ba;
+}
+
+quint32 FrameControl::delay() const
+{
+  // a zero denominator stands for 100 according to the specification
+  quint32 uiDen = (m_uiDelayDen == 0U ? 100U : m_uiDelayDen);
+  return quint32(m_uiDelayNum) * 1000U / uiDen;
+}
+
+} // namespace png
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <optional>
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace png {
+
+/**
+ * @brief The FrameControl struct This struct holds the parsed content of the fcTL chunk
+ */
+struct __declspec(dllexport) FrameControl {
+  /**
+   * @brief The DisposeOp enum Denotes, what happens to the frame region before the next frame
+   */
+  enum DisposeOp : quint8 {
+    edoNone       = 0,
+    edoBackground = 1,
+    edoPrevious   = 2
+  };
+  /**
+   * @brief The BlendOp enum Denotes, how the frame is combined with the canvas
+   */
+  enum BlendOp : quint8 {
+    eboSource = 0,
+    eboOver   = 1
+  };
+
+  quint32 m_uiSequence  = 0U;
+  quint32 m_uiWidth     = 0U;
+  quint32 m_uiHeight    = 0U;
+  quint32 m_uiX         = 0U;
+  quint32 m_uiY         = 0U;
+  quint16 m_uiDelayNum  = 0U;
+  quint16 m_uiDelayDen  = 0U;
+  quint8 m_uiDispose    = edoNone;
+  quint8 m_uiBlend      = eboSource;
+
+  /**
+   * @brief parse Parses and validates the fcTL chunk content
+   * @param rba Reference to the fcTL chunk content
+   * @return Parsed frame control or an empty value, if the content is not a valid fcTL
+   */
+  static std::optional<FrameControl> parse(const QByteArray& rba);
+  /**
+   * @brief toBytes Serializes the frame control into the fcTL chunk content
+   * @return fcTL chunk content
+   */
+  QByteArray toBytes() const;
+  /**
+   * @brief delay Returns the frame delay
+   * @return frame delay in [ms]
+   */
+  quint32 delay() const;
+};
+
+} // namespace png
@@ -0,0 +1,83 @@
+#include "header.h"
+
+namespace png {
+
+std::optional<Header> Header::parse(const QByteArray& rba)
+{
+  if (rba.size() < 13)
+    return {};
+
+  auto p = reinterpret_cast<const uchar*>(rba.constData());
+  Header header;
+  header.m_uiWidth       = (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | p[3];
+  header.m_uiHeight      = (quint32(p[4]) << 24) | (quint32(p[5]) << 16) | (quint32(p[6]) << 8) | p[7];
+  header.m_uiBitDepth    = p[8];
+  header.m_uiColorType   = p[9];
+  header.m_uiCompression = p[10];
+  header.m_uiFilter      = p[11];
+  header.m_uiInterlace   = p[12];
+
+  if ((header.m_uiWidth == 0U) || (header.m_uiHeight == 0U) || (header.m_uiCompression != 0U) ||
+      (header.m_uiFilter != 0U) || (header.m_uiInterlace > 1U))
+    return {};
+
+  bool bValid = false;
+  switch (header.m_uiColorType) {
+  case ectGray:
+    bValid = (header.m_uiBitDepth == 1) || (header.m_uiBitDepth == 2) ||
+             (header.m_uiBitDepth == 4) || (header.m_uiBitDepth == 8) || (header.m_uiBitDepth == 16);
+    break;
+  case ectPalette:
+    bValid = (header.m_uiBitDepth == 1) || (header.m_uiBitDepth == 2) ||
+             (header.m_uiBitDepth == 4) || (header.m_uiBitDepth == 8);
+    break;
+  case ectRGB:
+  case ectGrayAlpha:
+  case ectRGBA:
+    bValid = (header.m_uiBitDepth == 8) || (header.m_uiBitDepth == 16);
+    break;
+  default:
+    break;
+  }
+
+  if (bValid == false)
+    return {};
+
+  return header;
+}
+
+QByteArray Header::toBytes() const
+{
+  QByteArray ba(13, char(0));
+  auto p = reinterpret_cast<uchar*>(ba.data());
+  p[0]   = uchar(m_uiWidth >> 24);
+  p[1]   = uchar(m_uiWidth >> 16);
+  p[2]   = uchar(m_uiWidth >> 8);
+  p[3]   = uchar(m_uiWidth);
+  p[4]   = uchar(m_uiHeight >> 24);
+  p[5]   = uchar(m_uiHeight >> 16);
+  p[6]   = uchar(m_uiHeight >> 8);
+  p[7]   = uchar(m_uiHeight);
+  p[8]   = m_uiBitDepth;
+  p[9]   = m_uiColorType;
+  p[10]  = m_uiCompression;
+  p[11]  = m_uiFilter;
+  p[12]  = m_uiInterlace;
+  return ba;
+}
+
+int Header::channels() const
+{
+  switch (m_uiColorType) {
+  case ectRGB:
+    return 3;
+  case ectGrayAlpha:
+    return 2;
+  case ectRGBA:
+    return 4;
+  default:
+    return 1;
+  }
+}
+
+} // namespace png
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <optional>
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace png {
+
+/**
+ * @brief The Header struct This struct holds the parsed content of the IHDR chunk
+ */
+struct __declspec(dllexport) Header {
+  /**
+   * @brief The ColorType enum Denotes the PNG color types
+   */
+  enum ColorType : quint8 {
+    ectGray      = 0,
+    ectRGB       = 2,
+    ectPalette   = 3,
+    ectGrayAlpha = 4,
+    ectRGBA      = 6
+  };
+
+  quint32 m_uiWidth       = 0U;
+  quint32 m_uiHeight      = 0U;
+  quint8 m_uiBitDepth     = 0U;
+  quint8 m_uiColorType    = 0U;
+  quint8 m_uiCompression  = 0U;
+  quint8 m_uiFilter       = 0U;
+  quint8 m_uiInterlace    = 0U;
+
+  /**
+   * @brief parse Parses and validates the IHDR chunk content
+   * @param rba Reference to the IHDR chunk content
+   * @return Parsed header or an empty value, if the content is not a valid IHDR
+   */
+  static std::optional<Header> parse(const QByteArray& rba);
+  /**
+   * @brief toBytes Serializes the header into the IHDR chunk content
+   * @return IHDR chunk content
+   */
+  QByteArray toBytes() const;
+  /**
+   * @brief channels Returns the number of samples per pixel
+   * @return number of samples per pixel
+   */
+  int channels() const;
+  /**
+   * @brief bitsPerPixel Returns the number of bits per pixel
+   * @return number of bits per pixel
+   */
+  int bitsPerPixel() const { return channels() * m_uiBitDepth; }
+  /**
+   * @brief filterBytes Returns the distance in bytes between the corresponding bytes of adjacent
+   * pixels, as used by the scanline filters (never less than 1)
+   * @return filter distance in [bytes]
+   */
+  int filterBytes() const { return qMax(1, bitsPerPixel() / 8); }
+  /**
+   * @brief rowBytes Returns the size of one scanline without the filter type byte
+   * @param uiWidth Width of the scanline in [pixels]
+   * @return scanline size in [bytes]
+   */
+  quint64 rowBytes(quint32 uiWidth) const { return (quint64(uiWidth) * bitsPerPixel() + 7) / 8; }
+  /**
+   * @brief hasAlpha Returns true, if the color type contains the alpha channel
+   * @return true, if the color type contains the alpha channel and false otherwise
+   */
+  bool hasAlpha() const { return (m_uiColorType & 4) != 0; }
+};
+
+} // namespace png
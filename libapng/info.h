@@ -28,7 +28,9 @@ public:
     epeNoACTL,
     epeCRC,
     epeChunkName,
-    epeInvalidSize
+    epeInvalidSize,
+    epeSequence,
+    epeFrameControl
   };
 
   /**
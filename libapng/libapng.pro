@@ -10,22 +10,68 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    chunkstream.cpp \
+    compositor.cpp \
+    compression.cpp \
     info.cpp \
     libapng.cpp \
+    mappedfile.cpp \
     base.cpp \
+    blend.cpp \
     crc.cpp \
+    decoder.cpp \
+    encoder.cpp \
+    encoderoptions.cpp \
+    filter.cpp \
+    framecache.cpp \
+    framecontrol.cpp \
+    header.cpp \
+    quantizer.cpp \
     reader.cpp \
+    reducer.cpp \
+    taskrunner.cpp \
     writer.cpp
 
 HEADERS += \
+    chunkstream.h \
+    compositor.h \
+    compression.h \
     info.h \
     libapng_global.h \
     libapng.h \
+    mappedfile.h \
     base.h \
+    blend.h \
     crc.h \
+    decoder.h \
+    encodedimage.h \
+    encoder.h \
+    encoderoptions.h \
+    filter.h \
+    framecache.h \
+    framecontrol.h \
+    header.h \
+    quantizer.h \
     reader.h \
+    reducer.h \
+    taskrunner.h \
     writer.h
 
+# the frames are inflated and deflated by libdeflate or zlib-ng, if pkg-config finds either of them,
+# and by the system zlib otherwise. CONFIG+=apng_system_zlib always selects the system zlib
+!apng_system_zlib:packagesExist(libdeflate) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libdeflate
+    DEFINES += LIBAPNG_LIBDEFLATE
+} else: !apng_system_zlib:packagesExist(zlib-ng) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += zlib-ng
+    DEFINES += LIBAPNG_ZLIB_NG
+} else {
+    win32: LIBS += -lzlib
+    else: LIBS += -lz
+}
+
 # Default rules for deployment.
 unix {
     target.path = /usr/lib
@@ -0,0 +1,73 @@
+#include "mappedfile.h"
+
+#include "base.h"
+
+#include <QFile>
+
+namespace png {
+
+MappedFile::MappedFile() : m_pData(nullptr), m_uiSize(0U) {}
+
+bool MappedFile::open(const QString& rqsFile)
+{
+  reset();
+
+  auto pFile = new QFile(rqsFile);
+  if ((pFile->open(QFile::ReadOnly) == false) || (pFile->size() <= 0) ||
+      (pFile->size() > qint64(0xFFFFFFFFU))) {
+    delete pFile;
+    return false;
+  }
+
+  auto pData = pFile->map(0, pFile->size());
+  if (pData == nullptr) {
+    delete pFile;
+    return false;
+  }
+
+  m_pData  = pData;
+  m_uiSize = quint32(pFile->size());
+  // closing the file releases the mapping as well
+  m_spMapping = std::shared_ptr<void>(pFile, [](void* p) { delete static_cast<QFile*>(p); });
+  return true;
+}
+
+bool MappedFile::map(QFileDevice* pDevice)
+{
+  reset();
+
+  if ((pDevice == nullptr) || (pDevice->isOpen() == false) || (pDevice->size() <= 0) ||
+      (pDevice->size() > qint64(0xFFFFFFFFU))) {
+    return false;
+  }
+
+  auto pData = pDevice->map(0, pDevice->size());
+  if (pData == nullptr)
+    return false;
+
+  m_pData     = pData;
+  m_uiSize    = quint32(pDevice->size());
+  m_spMapping = std::shared_ptr<void>(pData, [pDevice](void* p) {
+    pDevice->unmap(static_cast<uchar*>(p));
+  });
+  return true;
+}
+
+void MappedFile::reset()
+{
+  m_spMapping.reset();
+  m_pData  = nullptr;
+  m_uiSize = 0U;
+}
+
+QByteArray MappedFile::bytes(quint32 uiOffset, quint32 uiLength) const
+{
+  return QByteArray::fromRawData(reinterpret_cast<const char*>(m_pData) + uiOffset, uiLength);
+}
+
+QByteArray MappedFile::payload(const ChunkView& rView) const
+{
+  return bytes(rView.m_uiOffset, rView.m_uiLength);
+}
+
+} // namespace png
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+
+#include <QByteArray>
+#include <QtGlobal>
+
+class QFileDevice;
+class QString;
+
+namespace png {
+
+struct ChunkView;
+
+/**
+ * @brief The MappedFile class This class holds a read-only memory mapping of a file. Copies of the
+ * object share the same mapping, which is released when the last copy is destroyed or reset.
+ */
+class __declspec(dllexport) MappedFile
+{
+public:
+  /**
+   * @brief MappedFile Default constructor. Creates an empty object, which maps nothing
+   */
+  MappedFile();
+  /**
+   * @brief open Opens and maps the whole file
+   * @param rqsFile Full path to the file to map
+   * @return true on success and false, if the file could not be opened or mapped
+   */
+  bool open(const QString& rqsFile);
+  /**
+   * @brief map Maps the whole content of an already opened file device. The device is not owned by
+   * this object and has to outlive the mapping
+   * @param pDevice Pointer to the file device to map
+   * @return true on success and false, if the device could not be mapped
+   */
+  bool map(QFileDevice* pDevice);
+  /**
+   * @brief reset Releases the mapping
+   */
+  void reset();
+  /**
+   * @brief isMapped Returns true, if a file is currently mapped
+   * @return true, if a file is mapped and false otherwise
+   */
+  bool isMapped() const { return m_pData != nullptr; }
+  /**
+   * @brief data Returns the pointer to the beginning of the mapped memory
+   * @return Pointer to the mapped memory or nullptr, if nothing is mapped
+   */
+  const uchar* data() const { return m_pData; }
+  /**
+   * @brief size Returns the size of the mapped memory
+   * @return Size of the mapped memory in [bytes]
+   */
+  quint32 size() const { return m_uiSize; }
+  /**
+   * @brief bytes Returns a byte array, which refers to the given range of the mapped memory without
+   * copying it. The returned array is only valid as long as the mapping exists
+   * @param uiOffset Offset of the range in [bytes]
+   * @param uiLength Length of the range in [bytes]
+   * @return Byte array referring to the mapped memory
+   */
+  QByteArray bytes(quint32 uiOffset, quint32 uiLength) const;
+  /**
+   * @brief payload Returns the payload of the chunk, described by the view, without copying it
+   * @param rView Reference to the chunk view
+   * @return Byte array referring to the chunk payload in the mapped memory
+   */
+  QByteArray payload(const ChunkView& rView) const;
+
+private:
+  std::shared_ptr<void> m_spMapping;
+  const uchar* m_pData;
+  quint32 m_uiSize;
+};
+
+} // namespace png
@@ -0,0 +1,360 @@
+#include "quantizer.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace png {
+
+namespace {
+
+/**
+ * @brief ciMaxColors Number of distinct colors, above which the collected colors lose precision
+ */
+const int ciMaxColors = 65536;
+/**
+ * @brief ciCacheSize Number of entries of the cache, which every thread keeps while mapping
+ */
+const int ciCacheSize = 4096;
+/**
+ * @brief ciRowsPerTask Number of rows mapped by one task
+ */
+const int ciRowsPerTask = 32;
+
+/**
+ * @brief The Entry struct Holds one collected color and the number of its pixels
+ */
+struct Entry {
+  QRgb m_rgb;
+  quint32 m_uiCount;
+};
+
+/**
+ * @brief The Box struct Holds a range of the collected colors, which is split by the median cut
+ */
+struct Box {
+  int m_iBegin;
+  int m_iEnd;
+  int m_iChannel;
+  int m_iRange;
+};
+
+int channel(QRgb rgb, int iChannel)
+{
+  return int((rgb >> (8 * iChannel)) & 0xFFU);
+}
+
+/**
+ * @brief reduce Drops the low bits of the color channels, so that similar colors are collected
+ * together. The alpha channel is kept, so the opaque colors stay opaque
+ * @param rgb Color to reduce
+ * @param iShift Number of bits to drop
+ * @return Color in the middle of the bucket
+ */
+QRgb reduce(QRgb rgb, int iShift)
+{
+  if (iShift == 0)
+    return rgb;
+
+  quint32 uiMask = (0xFFU << iShift) & 0xFFU;
+  quint32 uiHalf = (1U << iShift) >> 1;
+  return (rgb & (0xFF000000U | uiMask * 0x10101U)) | uiHalf * 0x10101U;
+}
+
+/**
+ * @brief makeBox Returns the box with the channel of the widest range of the colors
+ * @param rvEntries Reference to the collected colors
+ * @param iBegin Index of the first color of the box
+ * @param iEnd Index after the last color of the box
+ * @return Box
+ */
+Box makeBox(const QVector<Entry>& rvEntries, int iBegin, int iEnd)
+{
+  int aiMin[4] = {255, 255, 255, 255};
+  int aiMax[4] = {0, 0, 0, 0};
+  for (int i = iBegin; i < iEnd; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      aiMin[c] = qMin(aiMin[c], channel(rvEntries[i].m_rgb, c));
+      aiMax[c] = qMax(aiMax[c], channel(rvEntries[i].m_rgb, c));
+    }
+  }
+
+  Box box{iBegin, iEnd, 0, -1};
+  for (int c = 0; c < 4; ++c) {
+    if (aiMax[c] - aiMin[c] > box.m_iRange) {
+      box.m_iRange   = aiMax[c] - aiMin[c];
+      box.m_iChannel = c;
+    }
+  }
+
+  return box;
+}
+
+/**
+ * @brief average Returns the average color of the box, weighted by the numbers of pixels
+ * @param rvEntries Reference to the collected colors
+ * @param rBox Reference to the box
+ * @return Average color
+ */
+QRgb average(const QVector<Entry>& rvEntries, const Box& rBox)
+{
+  quint64 auiSum[4] = {0U, 0U, 0U, 0U};
+  quint64 uiCount   = 0U;
+  for (int i = rBox.m_iBegin; i < rBox.m_iEnd; ++i) {
+    for (int c = 0; c < 4; ++c)
+      auiSum[c] += quint64(channel(rvEntries[i].m_rgb, c)) * rvEntries[i].m_uiCount;
+    uiCount += rvEntries[i].m_uiCount;
+  }
+
+  QRgb rgb = 0U;
+  for (int c = 0; c < 4; ++c)
+    rgb |= QRgb((auiSum[c] + uiCount / 2U) / uiCount) << (8 * c);
+  return rgb;
+}
+
+/**
+ * @brief The Search class Finds the nearest palette entries. The entries are sorted by their green
+ * channel, so the search starts at the entries with the closest green value and stops as soon as
+ * the difference of the green channel alone exceeds the best distance found
+ */
+class Search
+{
+public:
+  explicit Search(const QVector<QRgb>& rvPalette)
+  {
+    for (int i = 0; i < rvPalette.count(); ++i)
+      m_vItems << Item{rvPalette[i], i};
+    std::stable_sort(m_vItems.begin(), m_vItems.end(), [](const Item& rA, const Item& rB) {
+      return channel(rA.m_rgb, 1) < channel(rB.m_rgb, 1);
+    });
+  }
+
+  /**
+   * @brief nearest Returns the index of the palette entry nearest to the color
+   * @param rgb Color
+   * @return Index of the nearest palette entry
+   */
+  int nearest(QRgb rgb) const
+  {
+    int iGreen = channel(rgb, 1);
+    auto it    = std::lower_bound(m_vItems.begin(), m_vItems.end(), iGreen,
+                               [](const Item& rItem, int i) {
+                                 return channel(rItem.m_rgb, 1) < i;
+                               });
+    int iUp    = int(it - m_vItems.begin());
+    int iDown  = iUp - 1;
+    int iBest  = 0;
+    int iMin   = std::numeric_limits<int>::max();
+    while ((iUp < m_vItems.count()) || (iDown >= 0)) {
+      if (iUp < m_vItems.count()) {
+        int iDiff = channel(m_vItems[iUp].m_rgb, 1) - iGreen;
+        if (iDiff * iDiff > iMin)
+          iUp = m_vItems.count();
+        else
+          check(rgb, m_vItems[iUp++], iBest, iMin);
+      }
+      if (iDown >= 0) {
+        int iDiff = iGreen - channel(m_vItems[iDown].m_rgb, 1);
+        if (iDiff * iDiff > iMin)
+          iDown = -1;
+        else
+          check(rgb, m_vItems[iDown--], iBest, iMin);
+      }
+    }
+
+    return iBest;
+  }
+
+private:
+  /**
+   * @brief The Item struct Holds one palette entry and its index
+   */
+  struct Item {
+    QRgb m_rgb;
+    int m_iIndex;
+  };
+
+  static void check(QRgb rgb, const Item& rItem, int& riBest, int& riMin)
+  {
+    int iDistance = 0;
+    for (int c = 0; c < 4; ++c) {
+      int iDiff = channel(rgb, c) - channel(rItem.m_rgb, c);
+      iDistance += iDiff * iDiff;
+    }
+    // the equally near entries are resolved by the index, regardless of the search order
+    if ((iDistance < riMin) || ((iDistance == riMin) && (rItem.m_iIndex < riBest))) {
+      riMin  = iDistance;
+      riBest = rItem.m_iIndex;
+    }
+  }
+
+  QVector<Item> m_vItems;
+};
+
+} // namespace
+
+Quantizer::Quantizer(int iColors) : m_iColors(qBound(1, iColors, 256)), m_iShift(0) {}
+
+void Quantizer::setColors(int iColors)
+{
+  m_iColors = qBound(1, iColors, 256);
+}
+
+void Quantizer::setThreadPool(QThreadPool* pPool)
+{
+  m_runner.setThreadPool(pPool);
+}
+
+void Quantizer::add(const QImage& rImg)
+{
+  if (rImg.isNull() == true)
+    return;
+
+  auto img = rImg.convertToFormat(QImage::Format_ARGB32);
+  for (int y = 0; y < img.height(); ++y) {
+    auto pLine = reinterpret_cast<const QRgb*>(img.constScanLine(y));
+    // the runs of the same color are counted at once
+    for (int x = 0; x < img.width();) {
+      int iRun = 1;
+      while ((x + iRun < img.width()) && (pLine[x + iRun] == pLine[x]))
+        ++iRun;
+
+      QRgb rgb = (qAlpha(pLine[x]) == 0 ? 0U : reduce(pLine[x], m_iShift));
+      m_hashColors[rgb] += quint32(iRun);
+      x += iRun;
+    }
+
+    // too many colors are collected into coarser buckets
+    while ((m_hashColors.count() > ciMaxColors) && (m_iShift < 5)) {
+      ++m_iShift;
+      QHash<QRgb, quint32> hashReduced;
+      for (auto it = m_hashColors.constBegin(); it != m_hashColors.constEnd(); ++it)
+        hashReduced[reduce(it.key(), m_iShift)] += it.value();
+      m_hashColors = hashReduced;
+    }
+  }
+}
+
+void Quantizer::clear()
+{
+  m_hashColors.clear();
+  m_iShift = 0;
+}
+
+QVector<QRgb> Quantizer::palette() const
+{
+  // the fully transparent color keeps its exact entry, which the frames blended by the OVER
+  // operation rely on
+  QVector<Entry> vEntries;
+  QVector<QRgb> vPalette;
+  for (auto it = m_hashColors.constBegin(); it != m_hashColors.constEnd(); ++it) {
+    if (it.key() == 0U)
+      vPalette << 0U;
+    else
+      vEntries << Entry{it.key(), it.value()};
+  }
+
+  // the order of the hash is not defined, but the palette has to be reproducible
+  std::sort(vEntries.begin(), vEntries.end(),
+            [](const Entry& rA, const Entry& rB) { return rA.m_rgb < rB.m_rgb; });
+
+  int iColors = m_iColors - vPalette.count();
+  if (vEntries.count() <= iColors) {
+    for (const auto& rEntry : vEntries)
+      vPalette << rEntry.m_rgb;
+  } else if (iColors > 0) {
+    // the box with the widest channel range is split at the median pixel of that channel
+    QVector<Box> vBoxes = {makeBox(vEntries, 0, vEntries.count())};
+    while (vBoxes.count() < iColors) {
+      auto it = std::max_element(vBoxes.begin(), vBoxes.end(), [](const Box& rA, const Box& rB) {
+        return rA.m_iRange < rB.m_iRange;
+      });
+      if (it->m_iRange <= 0)
+        break;
+
+      Box box     = *it;
+      int iChannel = box.m_iChannel;
+      std::sort(vEntries.begin() + box.m_iBegin, vEntries.begin() + box.m_iEnd,
+                [iChannel](const Entry& rA, const Entry& rB) {
+                  return channel(rA.m_rgb, iChannel) < channel(rB.m_rgb, iChannel);
+                });
+
+      quint64 uiTotal = 0U;
+      for (int i = box.m_iBegin; i < box.m_iEnd; ++i)
+        uiTotal += vEntries[i].m_uiCount;
+
+      int iSplit      = box.m_iBegin + 1;
+      quint64 uiBelow = vEntries[box.m_iBegin].m_uiCount;
+      while ((iSplit < box.m_iEnd - 1) && (2U * uiBelow < uiTotal))
+        uiBelow += vEntries[iSplit++].m_uiCount;
+
+      *it = makeBox(vEntries, box.m_iBegin, iSplit);
+      vBoxes << makeBox(vEntries, iSplit, box.m_iEnd);
+    }
+
+    for (const auto& rBox : vBoxes)
+      vPalette << average(vEntries, rBox);
+  }
+
+  // the translucent entries come first, so the opaque ones do not have to be listed in tRNS
+  std::stable_sort(vPalette.begin(), vPalette.end(),
+                   [](QRgb rgbA, QRgb rgbB) { return qAlpha(rgbA) < qAlpha(rgbB); });
+  return vPalette;
+}
+
+QImage Quantizer::quantize(const QImage& rImg, const QVector<QRgb>& rvPalette) const
+{
+  if ((rImg.isNull() == true) || (rvPalette.isEmpty() == true) || (rvPalette.count() > 256))
+    return {};
+
+  auto imgSrc = rImg.convertToFormat(QImage::Format_ARGB32);
+  QImage img(imgSrc.size(), QImage::Format_Indexed8);
+  img.setColorTable(rvPalette);
+
+  // the first of the equal entries is used and any fully transparent entry serves all the fully
+  // transparent pixels
+  QHash<QRgb, int> hashExact;
+  Search search(rvPalette);
+  int iTransparent = -1;
+  for (int i = rvPalette.count() - 1; i >= 0; --i) {
+    hashExact.insert(rvPalette[i], i);
+    if (qAlpha(rvPalette[i]) == 0)
+      iTransparent = i;
+  }
+
+  // the rows are written through the pointer, since scanLine may not be called concurrently
+  uchar* pBits     = img.bits();
+  qsizetype iLine  = img.bytesPerLine();
+  int iTasks       = (img.height() + ciRowsPerTask - 1) / ciRowsPerTask;
+  m_runner.run(iTasks, [&](int iTask) {
+    std::array<QRgb, ciCacheSize> aKeys;
+    std::array<int, ciCacheSize> aiIndices;
+    aiIndices.fill(-1);
+
+    int iEnd = qMin(img.height(), (iTask + 1) * ciRowsPerTask);
+    for (int y = iTask * ciRowsPerTask; y < iEnd; ++y) {
+      auto pLine = reinterpret_cast<const QRgb*>(imgSrc.constScanLine(y));
+      uchar* pDst = pBits + y * iLine;
+      for (int x = 0; x < img.width(); ++x) {
+        QRgb rgb = pLine[x];
+        if ((qAlpha(rgb) == 0) && (iTransparent >= 0)) {
+          pDst[x] = uchar(iTransparent);
+          continue;
+        }
+
+        int iSlot = int(((rgb * 2654435761U) >> 20) & quint32(ciCacheSize - 1));
+        if ((aiIndices[iSlot] < 0) || (aKeys[iSlot] != rgb)) {
+          aKeys[iSlot]     = rgb;
+          aiIndices[iSlot] = hashExact.value(rgb, -1);
+          if (aiIndices[iSlot] < 0)
+            aiIndices[iSlot] = search.nearest(rgb);
+        }
+        pDst[x] = uchar(aiIndices[iSlot]);
+      }
+    }
+  });
+
+  return img;
+}
+
+} // namespace png
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QVector>
+
+#include "taskrunner.h"
+
+namespace png {
+
+/**
+ * @brief The Quantizer class This class reduces the images to a palette of at most 256 colors,
+ * which is shared by all the frames of an animation, since APNG only allows one PLTE chunk. The
+ * colors of all the frames are collected by the add method first and the palette is built by
+ * the median cut of the collected colors. When there are no more colors than palette entries, as is
+ * common for user interface and illustration content, the palette holds them exactly and the
+ * quantized images are lossless.
+ */
+class __declspec(dllexport) Quantizer
+{
+public:
+  /**
+   * @brief Quantizer Constructor
+   * @param iColors Maximal number of palette entries from 1 to 256
+   */
+  explicit Quantizer(int iColors = 256);
+  /**
+   * @brief setColors Sets the maximal number of palette entries
+   * @param iColors Maximal number of palette entries, which is bounded to 1 to 256
+   */
+  void setColors(int iColors);
+  /**
+   * @brief colors Returns the maximal number of palette entries
+   * @return Maximal number of palette entries
+   */
+  int colors() const { return m_iColors; }
+  /**
+   * @brief setThreadPool Sets the thread pool, which maps the rows of one image to the palette in
+   * parallel
+   * @param pPool Pointer to the thread pool. If nullptr, the rows are mapped on the calling thread
+   */
+  void setThreadPool(QThreadPool* pPool);
+  /**
+   * @brief threadPool Returns the thread pool, which maps the rows to the palette
+   * @return Pointer to the thread pool or nullptr, if the rows are mapped on the calling thread
+   */
+  QThreadPool* threadPool() const { return m_runner.threadPool(); }
+  /**
+   * @brief add Collects the colors of the image for the palette
+   * @param rImg Reference to the image
+   */
+  void add(const QImage& rImg);
+  /**
+   * @brief clear Forgets all the collected colors
+   */
+  void clear();
+  /**
+   * @brief palette Builds the palette from the collected colors. The fully transparent colors are
+   * all collected as transparent black, and the translucent entries come first, so that the tRNS
+   * chunk stays short
+   * @return Palette, which is empty if no colors were collected
+   */
+  QVector<QRgb> palette() const;
+  /**
+   * @brief quantize Maps every pixel of the image to the nearest palette entry. This method does
+   * not modify the object, so it can be called from several threads at once
+   * @param rImg Reference to the image to quantize
+   * @param rvPalette Reference to the palette with 1 to 256 entries
+   * @return Image in QImage::Format_Indexed8 with the palette as its color table, or a null image,
+   * if the image is null or the palette is not valid
+   */
+  QImage quantize(const QImage& rImg, const QVector<QRgb>& rvPalette) const;
+
+private:
+  QHash<QRgb, quint32> m_hashColors;
+  int m_iColors;
+  int m_iShift;
+  TaskRunner m_runner;
+};
+
+} // namespace png
@@ -2,52 +2,32 @@
 
 #include <QBuffer>
 #include <QFile>
+#include <QFileDevice>
+#include <QThreadPool>
 
 namespace png {
 
-Reader::Reader() {}
+Reader::Reader()
+  : m_vFrames({Frame()}), m_eReadMode(ReadMode::ermStream),
+    m_runner(QThreadPool::globalInstance()), m_iSnapshotBudget(0), m_iSnapshotBytes(0),
+    m_iSnapshotInterval(16), m_iComposed(-1), m_bDecoder(false), m_bIEND(false), m_bACTL(false),
+    m_uiSequence(0U)
+{}
 
 QVector<QByteArray> Reader::import(const QString& rqsFile)
 {
-  reset();
-  // default type is PNG
-  m_info.setType(Info::Type::etPNG);
-
-  QVector<QByteArray> vImg;
-
-  auto ba = readContent(rqsFile);
-  if (ba.size() > 0 && m_info.error() == Info::ParseError::epeNone) {
-    parseChunks(ba);
-
-    auto vIDAT = split(m_baIDAT);
-
-    auto baContent = m_cbaSig;
-    writeChunk(baContent, m_chunkIHDR);
-    for (const auto& rOther : m_vOtherChunks) {
-      writeChunk(baContent, rOther);
-    }
-    for (const auto& rba : vIDAT) {
-      baContent.append(rba);
-    }
+  if (parse(rqsFile) == false)
+    return {};
 
-    writeChunk(baContent, iend());
-    vImg << baContent;
+  return frames();
+}
 
-    for (const auto& rFDAT : m_vfDAT) {
-      baContent = m_cbaSig;
-      writeChunk(baContent, m_chunkIHDR);
-      for (const auto& rOther : m_vOtherChunks)
-        writeChunk(baContent, rOther);
-      auto vIDAT = split(rFDAT.m_baContent.mid(4));
-      for (const auto& rba : vIDAT) {
-        baContent.append(rba);
-      }
-      writeChunk(baContent, iend());
-      vImg << baContent;
-    }
-  }
+QVector<QByteArray> Reader::import(QIODevice* pDevice)
+{
+  if (parse(pDevice) == false)
+    return {};
 
-  return vImg;
+  return frames();
 }
 
 void Reader::import(const QString& rqsFile, const QString& rqsOutFile)
@@ -68,32 +48,262 @@ void Reader::import(const QString& rqsFile, const QString& rqsOutFile)
 
 QVector<QImage> Reader::importImages(const QString& rqsFile)
 {
-  auto vbaContent = import(rqsFile);
+  if (parse(rqsFile) == false)
+    return {};
+
+  return composeImages(decodeImages());
+}
+
+QVector<QImage> Reader::importImages(QIODevice* pDevice)
+{
+  if (parse(pDevice) == false)
+    return {};
+
+  return composeImages(decodeImages());
+}
+
+QVector<QPixmap> Reader::importPixmaps(const QString& rqsFile)
+{
+  return toPixmaps(importImages(rqsFile));
+}
+
+QVector<QPixmap> Reader::importPixmaps(QIODevice* pDevice)
+{
+  return toPixmaps(importImages(pDevice));
+}
+
+bool Reader::open(const QString& rqsFile)
+{
+  return (parse(rqsFile) == true) && (m_info.isOk() == true);
+}
+
+bool Reader::open(QIODevice* pDevice)
+{
+  return (parse(pDevice) == true) && (m_info.isOk() == true);
+}
+
+FrameControl Reader::frameControl(int i) const
+{
+  if ((i < 0) || (i >= m_vFrames.count()))
+    return {};
+
+  if (m_vFrames[i].m_bControl == true)
+    return m_vFrames[i].m_control;
+
+  FrameControl fc;
+  fc.m_uiWidth  = m_decoder.header().m_uiWidth;
+  fc.m_uiHeight = m_decoder.header().m_uiHeight;
+  return fc;
+}
+
+QImage Reader::frame(int i) const
+{
+  if ((m_bDecoder == false) || (i < 0) || (i >= m_vFrames.count()))
+    return {};
+
+  auto fc = frameControl(i);
+  return m_decoder.decode(frameSegments(i), fc.m_uiWidth, fc.m_uiHeight);
+}
+
+bool Reader::isKeyframe(int i) const
+{
+  if ((i < 0) || (i >= m_vFrames.count()))
+    return false;
+
+  return m_vFrames[i].m_iKeyframe == i;
+}
+
+QImage Reader::composedFrame(int i)
+{
+  if ((m_bDecoder == false) || (i < 0) || (i >= m_vFrames.count()))
+    return {};
+
+  // the frames outside of the animation are shown as they are
+  if (m_vFrames[i].m_bControl == false)
+    return frame(i);
+
+  if (m_iComposed == i)
+    return m_compositor.canvas();
+
+  // the frames are decoded in small batches in parallel, but composed one after another
+  for (int iFirst = seek(i); iFirst <= i; iFirst += m_ciSeekBatch) {
+    QVector<QImage> vImg(qMin(m_ciSeekBatch, i - iFirst + 1));
+    m_runner.run(vImg.count(), [&](int j) {
+      if (m_vFrames[iFirst + j].m_bControl == true)
+        vImg[j] = frame(iFirst + j);
+    });
+
+    for (int j = 0; j < vImg.count(); ++j) {
+      int iFrame = iFirst + j;
+      if (m_vFrames[iFrame].m_bControl == false)
+        continue;
+
+      takeSnapshot(iFrame);
+      m_compositor.compose(vImg[j], m_vFrames[iFrame].m_control);
+      m_iComposed = iFrame;
+    }
+  }
+
+  // the canvas is shared with the returned image and only copied, when the next frame changes it
+  return m_compositor.canvas();
+}
+
+void Reader::setSnapshotBudget(qint64 iBytes)
+{
+  m_iSnapshotBudget = qMax<qint64>(0, iBytes);
+  while ((m_iSnapshotBytes > m_iSnapshotBudget) && (m_mapSnapshot.isEmpty() == false)) {
+    m_iSnapshotBytes -= m_mapSnapshot.last().sizeInBytes();
+    m_mapSnapshot.erase(--m_mapSnapshot.end());
+  }
+}
+
+void Reader::setSnapshotInterval(int iFrames)
+{
+  m_iSnapshotInterval = qMax(1, iFrames);
+}
+
+int Reader::seek(int i)
+{
+  int iKeyframe = m_vFrames[i].m_iKeyframe;
+  int iSnapshot = -1;
+  auto it       = m_mapSnapshot.upperBound(i);
+  if (it != m_mapSnapshot.begin())
+    iSnapshot = (--it).key();
+
+  // the playback simply goes on, unless a keyframe or a snapshot is closer
+  if ((m_iComposed >= 0) && (m_iComposed < i) && (m_iComposed >= qMax(iKeyframe, iSnapshot)))
+    return m_iComposed + 1;
+
+  const auto& rHeader = m_decoder.header();
+  m_compositor.reset(QSize(int(rHeader.m_uiWidth), int(rHeader.m_uiHeight)), canvasFormat());
+  m_iComposed = -1;
+  if (iSnapshot > iKeyframe) {
+    m_compositor.restore(m_mapSnapshot.value(iSnapshot));
+    return iSnapshot;
+  }
+
+  // nothing before the keyframe shows through, so it is composed onto an empty canvas
+  return iKeyframe;
+}
+
+void Reader::takeSnapshot(int i)
+{
+  if ((m_iSnapshotBudget == 0) || (isKeyframe(i) == true) || (m_mapSnapshot.contains(i) == true))
+    return;
+
+  int iLast = m_vFrames[i].m_iKeyframe;
+  auto it   = m_mapSnapshot.upperBound(i);
+  if (it != m_mapSnapshot.begin())
+    iLast = qMax(iLast, (--it).key());
+  if (i - iLast < m_iSnapshotInterval)
+    return;
+
+  // the snapshot holds the canvas after the previous frame has been disposed of
+  m_compositor.flush();
+  const auto& rCanvas = m_compositor.canvas();
+  if (m_iSnapshotBytes + rCanvas.sizeInBytes() > m_iSnapshotBudget)
+    return;
+
+  m_mapSnapshot.insert(i, rCanvas);
+  m_iSnapshotBytes += rCanvas.sizeInBytes();
+}
+
+QVector<QImage> Reader::decodeImages() const
+{
+  if (m_bDecoder == false)
+    return {};
+
+  // every frame is a separate zlib stream, so the frames are decoded independently
+  QVector<QImage> vImg(m_vFrames.count());
+  m_runner.run(vImg.count(), [&](int i) { vImg[i] = frame(i); });
+
+  return vImg;
+}
+
+QVector<QImage> Reader::composeImages(const QVector<QImage>& rvFrames) const
+{
+  Compositor compositor;
+  const auto& rHeader = m_decoder.header();
+  compositor.reset(QSize(int(rHeader.m_uiWidth), int(rHeader.m_uiHeight)), canvasFormat());
+
   QVector<QImage> vImg;
+  vImg.reserve(rvFrames.count());
+  for (int i = 0; i < rvFrames.count(); ++i) {
+    if (m_vFrames[i].m_bControl == false) {
+      vImg << rvFrames[i];
+      continue;
+    }
 
-  for (auto& rba : vbaContent) {
-    QBuffer buf(&rba);
-    buf.open(QIODevice::ReadOnly);
-    buf.seek(0);
-    QImage img;
-    img.load(&buf, "PNG");
-    buf.close();
-    vImg << img;
+    compositor.compose(rvFrames[i], m_vFrames[i].m_control);
+    // the canvas is shared with the returned image and only copied, when the next frame changes it
+    vImg << compositor.canvas();
   }
 
   return vImg;
 }
 
-QVector<QPixmap> Reader::importPixmaps(const QString& rqsFile)
+QImage::Format Reader::canvasFormat() const
 {
-  auto vbaContent = import(rqsFile);
-  QVector<QPixmap> vPix;
+  return (m_decoder.header().m_uiBitDepth == 16 ? QImage::Format_RGBA64 : QImage::Format_ARGB32);
+}
 
-  for (auto& rba : vbaContent) {
-    QPixmap pix;
-    pix.loadFromData(rba, "PNG");
-    vPix << pix;
+void Reader::indexKeyframes()
+{
+  const auto& rHeader = m_decoder.header();
+  auto covers         = [&rHeader](const FrameControl& rControl) {
+    return (rControl.m_uiX == 0U) && (rControl.m_uiY == 0U) &&
+           (rControl.m_uiWidth >= rHeader.m_uiWidth) && (rControl.m_uiHeight >= rHeader.m_uiHeight);
+  };
+
+  FrameControl previous;
+  bool bPrevious = false;
+  int iKeyframe  = -1;
+  for (int i = 0; i < m_vFrames.count(); ++i) {
+    auto& rFrame = m_vFrames[i];
+    if (rFrame.m_bControl == false) {
+      rFrame.m_iKeyframe = i;
+      continue;
+    }
+
+    const auto& rControl = rFrame.m_control;
+    if ((bPrevious == false) ||
+        ((rControl.m_uiBlend == FrameControl::eboSource) &&
+         (rControl.m_uiDispose != FrameControl::edoPrevious) && (covers(rControl) == true)) ||
+        ((previous.m_uiDispose == FrameControl::edoBackground) && (covers(previous) == true)))
+      iKeyframe = i;
+
+    rFrame.m_iKeyframe = iKeyframe;
+    previous           = rControl;
+    bPrevious          = true;
   }
+}
+
+bool Reader::prepareDecoder()
+{
+  auto optHeader = Header::parse(m_chunkIHDR.m_baContent);
+  if (optHeader.has_value() == false)
+    return false;
+
+  m_decoder = Decoder();
+  m_decoder.setHeader(optHeader.value());
+  // tRNS always follows PLTE, so the palette is set before the transparency
+  for (const auto& rChunk : m_vOtherChunks) {
+    if (rChunk.m_baName == m_cbaPLTE)
+      m_decoder.setPalette(rChunk.m_baContent);
+    else if (rChunk.m_baName == m_cbaTRNS)
+      m_decoder.setTransparency(rChunk.m_baContent);
+  }
+
+  return true;
+}
+
+QVector<QPixmap> Reader::toPixmaps(const QVector<QImage>& rvImg) const
+{
+  QVector<QPixmap> vPix;
+  vPix.reserve(rvImg.count());
+
+  for (const auto& rImg : rvImg)
+    vPix << QPixmap::fromImage(rImg);
 
   return vPix;
 }
@@ -102,87 +312,339 @@ void Reader::reset()
 {
   Base::reset();
   m_chunkIHDR = Chunk();
-  m_baIDAT.clear();
-  m_vfDAT.clear();
   m_vOtherChunks.clear();
+  // the default image always has an index entry, so that the frames keep their indices
+  m_vFrames = {Frame()};
+  m_map.reset();
+  m_mapSnapshot.clear();
+  m_iSnapshotBytes = 0;
+  m_iComposed      = -1;
+  m_bDecoder = false;
+  m_bIEND    = false;
+  m_bACTL = false;
+  m_uiSequence = 0U;
 }
 
-QByteArray Reader::readContent(const QString& rqsFile)
+void Reader::setReadMode(ReadMode eMode)
 {
-  QByteArray ba;
+  m_eReadMode = eMode;
+}
+
+void Reader::setThreadPool(QThreadPool* pPool)
+{
+  m_runner.setThreadPool(pPool);
+}
+
+void Reader::setMaxConcurrency(int iCount)
+{
+  m_runner.setMaxConcurrency(iCount);
+}
+
+bool Reader::parse(const QString& rqsFile)
+{
+  if (m_eReadMode == ReadMode::ermMapped) {
+    reset();
+    // default type is PNG
+    m_info.setType(Info::Type::etPNG);
+
+    if (m_map.open(rqsFile) == true) {
+      if (readSignature(m_map) == false)
+        return false;
+
+      parseChunks(m_map);
+      return true;
+    }
+  }
+
+  // files, which can not be mapped, are streamed instead
   QFile f(rqsFile);
-  if (f.open(QFile::ReadOnly) == true) {
-    ba = f.readAll();
-    f.close();
+  f.open(QFile::ReadOnly | QFile::Unbuffered);
+  return parse(&f);
+}
+
+bool Reader::parse(QIODevice* pDevice)
+{
+  reset();
+  // default type is PNG
+  m_info.setType(Info::Type::etPNG);
+
+  if (m_eReadMode == ReadMode::ermMapped) {
+    auto pFile = qobject_cast<QFileDevice*>(pDevice);
+    if ((pFile != nullptr) && (pFile->pos() == 0) && (m_map.map(pFile) == true)) {
+      if (readSignature(m_map) == false)
+        return false;
+
+      parseChunks(m_map);
+      return true;
+    }
   }
 
-  // if the signature is not found, clear the content, which signals an error
-  if (ba.left(8) != m_cbaSig) {
+  ChunkStream stream(pDevice, m_cuiReadBufferSize);
+  if (readSignature(stream) == false)
+    return false;
+
+  parseChunks(stream);
+  return true;
+}
+
+QVector<QByteArray> Reader::frames() const
+{
+  auto optHeader = Header::parse(m_chunkIHDR.m_baContent);
+
+  QVector<QByteArray> vImg;
+  for (int i = 0; i < m_vFrames.count(); ++i) {
+    auto baContent = m_cbaSig;
+    auto chunkIHDR = m_chunkIHDR;
+    // the frames, which only cover a part of the image, get their own size
+    if ((optHeader.has_value() == true) && (m_vFrames[i].m_bControl == true)) {
+      auto header       = optHeader.value();
+      header.m_uiWidth  = m_vFrames[i].m_control.m_uiWidth;
+      header.m_uiHeight = m_vFrames[i].m_control.m_uiHeight;
+      if (header.toBytes() != chunkIHDR.m_baContent) {
+        chunkIHDR.m_baContent = header.toBytes();
+        chunkIHDR.m_baCRC     = convert(crc(chunkIHDR));
+      }
+    }
+    writeChunk(baContent, chunkIHDR);
+    for (const auto& rOther : m_vOtherChunks)
+      writeChunk(baContent, rOther);
+    auto vIDAT = split(frameData(i));
+    for (const auto& rba : vIDAT) {
+      baContent.append(rba);
+    }
+    writeChunk(baContent, iend());
+    vImg << baContent;
+  }
+
+  return vImg;
+}
+
+QByteArray Reader::frameData(int i) const
+{
+  auto vSegments = frameSegments(i);
+  if (vSegments.count() == 1)
+    return vSegments.first();
+
+  // the IDAT payloads are only joined here, when the frame is actually emitted
+  QByteArray ba;
+  for (const auto& rba : vSegments)
+    ba.append(rba);
+  return ba;
+}
+
+QVector<QByteArray> Reader::frameSegments(int i) const
+{
+  const auto& rFrame = m_vFrames[i];
+  QVector<QByteArray> vSegments;
+  for (const auto& rView : rFrame.m_vView)
+    vSegments << m_map.payload(rView);
+
+  // the fdAT chunks are kept whole in the stream mode, so their sequence numbers are skipped here
+  int iSkip = (i == 0 ? 0 : 4);
+  for (const auto& rba : rFrame.m_vData) {
+    if (rba.size() > iSkip)
+      vSegments << QByteArray::fromRawData(rba.constData() + iSkip, rba.size() - iSkip);
+  }
+
+  return vSegments;
+}
+
+bool Reader::readSignature(ChunkStream& rStream)
+{
+  QByteArray ba;
+  if ((rStream.device()->isReadable() == false) || (rStream.read(ba, m_cbaSig.size()) == false) ||
+      (ba != m_cbaSig)) {
     m_info.setType(Info::Type::etInvalid);
     m_info.setError(Info::ParseError::epeNoSignature,
                     "No PNG signature found at the beginning of the file", 0U);
+    return false;
   }
 
-  return ba;
+  return true;
 }
 
-void Reader::parseChunks(const QByteArray& rba)
+bool Reader::readSignature(const MappedFile& rMap)
+{
+  if ((rMap.size() < quint32(m_cbaSig.size())) || (rMap.bytes(0, m_cbaSig.size()) != m_cbaSig)) {
+    m_info.setType(Info::Type::etInvalid);
+    m_info.setError(Info::ParseError::epeNoSignature,
+                    "No PNG signature found at the beginning of the file", 0U);
+    return false;
+  }
+
+  return true;
+}
+
+void Reader::parseChunks(ChunkStream& rStream)
 {
-  bool bIEND       = false;
-  bool bACTL       = false;
   quint32 uiOffset = m_cbaSig.size();
-  parseIHDR(rba, uiOffset);
+  parseIHDR(rStream, uiOffset);
   if (m_info.isOk() == false)
     return;
 
-  auto optChunk = readChunk(rba, uiOffset);
+  auto optChunk = readChunk(rStream, uiOffset);
   while (optChunk.has_value() == true) {
-    auto chunk = optChunk.value();
-    if (chunk.m_baName == m_cbaIDAT)
-      m_baIDAT.append(chunk.m_baContent);
-    else if (chunk.m_baName == m_cbaFDAT)
-      m_vfDAT << chunk;
-    else if (chunk.m_baName == m_cbaIEND)
-      bIEND = true;
-    else if ((chunk.m_baName != m_cbaACTL) && (chunk.m_baName != m_cbaFCTL))
-      m_vOtherChunks << chunk;
-
-    if (chunk.m_baName == m_cbaFCTL) {
-      auto num   = convert(chunk.m_baContent.mid(20, 2));
-      auto denom = convert(chunk.m_baContent.mid(22, 2));
-      m_info.setFPS(num > 0 ? denom / num : 0);
+    auto& chunk = optChunk.value();
+    if (chunk.m_baName == m_cbaIDAT) {
+      dataFrame(true).m_vData << chunk.m_baContent;
+    } else if (chunk.m_baName == m_cbaFDAT) {
+      checkSequence(chunk.m_baContent, uiOffset);
+      auto& rFrame = dataFrame(false);
+      rFrame.m_vSequence << convert(chunk.m_baContent);
+      rFrame.m_vData << chunk.m_baContent;
+    } else {
+      if (chunk.m_baName == m_cbaFCTL)
+        checkSequence(chunk.m_baContent, uiOffset);
+      parseChunk(chunk, uiOffset);
     }
 
-    if (chunk.m_baName == m_cbaACTL) {
-      bACTL = true;
+    // nothing may follow IEND, so stop pulling data from the device
+    if (m_bIEND == true)
+      break;
+
+    optChunk = readChunk(rStream, uiOffset);
+  }
+
+  m_info.setFrameCount((m_vFrames.first().hasData() == true ? 1 : 0) + m_vFrames.count() - 1);
+  checkChunks(m_vFrames.first().hasData(), uiOffset);
+  m_bDecoder = prepareDecoder();
+  if (m_bDecoder == true)
+    indexKeyframes();
+}
+
+void Reader::parseChunks(const MappedFile& rMap)
+{
+  quint32 uiOffset = m_cbaSig.size();
+  auto optIHDR     = readChunk(rMap, uiOffset);
+  if (optIHDR.has_value() == true)
+    m_chunkIHDR = toChunk(rMap, optIHDR.value());
+
+  if (m_chunkIHDR.m_baName != m_cbaIHDR) {
+    m_info.setError(Info::ParseError::epeNoIHDR, "No IHDR chunk found", uiOffset);
+    return;
+  }
+
+  auto optView = readChunk(rMap, uiOffset);
+  while (optView.has_value() == true) {
+    const auto& rView = optView.value();
+    // the frame data stays in the mapping, only the small chunks are copied out
+    if (rView.m_uiName == m_cuiIDAT) {
+      dataFrame(true).m_vView << rView;
+    } else if ((rView.m_uiName == m_cuiFDAT) && (rView.m_uiLength >= 4U)) {
+      // the view is narrowed down to the image data after the sequence number
+      auto baSequence = rMap.bytes(rView.m_uiOffset, 4);
+      checkSequence(baSequence, uiOffset);
+      auto& rFrame = dataFrame(false);
+      rFrame.m_vSequence << convert(baSequence);
+      rFrame.m_vView << ChunkView{rView.m_uiOffset + 4, rView.m_uiLength - 4, rView.m_uiName};
+    } else {
+      // the fdAT chunk too short for the sequence number is caught here as well
+      auto chunk = toChunk(rMap, rView);
+      if ((chunk.m_baName == m_cbaFCTL) || (chunk.m_baName == m_cbaFDAT))
+        checkSequence(chunk.m_baContent, uiOffset);
+      parseChunk(chunk, uiOffset);
+    }
+
+    if (m_bIEND == true)
+      break;
+
+    optView = readChunk(rMap, uiOffset);
+  }
+
+  m_info.setFrameCount((m_vFrames.first().hasData() == true ? 1 : 0) + m_vFrames.count() - 1);
+  checkChunks(m_vFrames.first().hasData(), uiOffset);
+  m_bDecoder = prepareDecoder();
+  if (m_bDecoder == true)
+    indexKeyframes();
+}
+
+void Reader::parseChunk(const Chunk& rChunk, quint32 uiOffset)
+{
+  if (rChunk.m_baName == m_cbaIEND)
+    m_bIEND = true;
+  else if ((rChunk.m_baName != m_cbaACTL) && (rChunk.m_baName != m_cbaFCTL))
+    m_vOtherChunks << rChunk;
+
+  if (rChunk.m_baName == m_cbaFCTL) {
+    auto num   = convert(rChunk.m_baContent.mid(20, 2));
+    auto denom = convert(rChunk.m_baContent.mid(22, 2));
+    m_info.setFPS(num > 0 ? denom / num : 0);
+    indexFCTL(rChunk.m_baContent, uiOffset);
+  }
+
+  if (rChunk.m_baName == m_cbaACTL) {
+    m_bACTL = true;
+  }
+}
+
+void Reader::indexFCTL(const QByteArray& rbaContent, quint32 uiOffset)
+{
+  auto optControl = FrameControl::parse(rbaContent);
+  if ((optControl.has_value() == false) && (m_info.isOk() == true))
+    m_info.setError(Info::ParseError::epeFrameControl, "Invalid fcTL chunk", uiOffset);
+
+  if ((m_vFrames.count() == 1) && (m_vFrames.first().hasData() == false)) {
+    if (optControl.has_value() == true) {
+      m_vFrames.first().m_control  = optControl.value();
+      m_vFrames.first().m_bControl = true;
     }
+    return;
+  }
 
-    optChunk = readChunk(rba, uiOffset);
+  // the next fdAT chunks belong to this frame, even if its control could not be read
+  Frame frame;
+  if (optControl.has_value() == true) {
+    frame.m_control  = optControl.value();
+    frame.m_bControl = true;
   }
+  m_vFrames << frame;
+}
 
-  m_info.setFrameCount((m_baIDAT.size() > 0 ? 1 : 0) + m_vfDAT.count());
+void Reader::checkSequence(const QByteArray& rbaContent, quint32 uiOffset)
+{
+  // the missing or reordered chunks would make the frames composed out of the wrong data
+  if ((m_info.isOk() == true) &&
+      ((rbaContent.size() < 4) || (convert(rbaContent) != m_uiSequence)))
+    m_info.setError(Info::ParseError::epeSequence, "Wrong sequence number of an fcTL or fdAT chunk",
+                    uiOffset);
+  ++m_uiSequence;
+}
 
+Reader::Frame& Reader::dataFrame(bool bIDAT)
+{
+  if (bIDAT == true)
+    return m_vFrames.first();
+
+  // fdAT without its own fcTL still gets a frame of its own
+  if (m_vFrames.count() == 1)
+    m_vFrames << Frame();
+
+  return m_vFrames.last();
+}
+
+void Reader::checkChunks(bool bIDAT, quint32 uiOffset)
+{
   if (m_info.isOk() == false)
     return;
 
-  if (m_baIDAT.size() == 0) {
+  if (bIDAT == false) {
     m_info.setError(Info::ParseError::epeNoIDAT, "No IDAT chunk found", uiOffset);
     return;
   }
 
-  if ((m_info.type() == Info::Type::etAPNG) && (bACTL == false)) {
+  if ((m_info.type() == Info::Type::etAPNG) && (m_bACTL == false)) {
     m_info.setError(Info::ParseError::epeNoACTL, "No ACTL chunk found", uiOffset);
     return;
   }
 
-  if (bIEND == false) {
+  if (m_bIEND == false) {
     m_info.setError(Info::ParseError::epeNoIEND, "No IEND chunk found ", uiOffset);
   }
 }
 
-void Reader::parseIHDR(const QByteArray& rba, quint32& riOffset)
+void Reader::parseIHDR(ChunkStream& rStream, quint32& riOffset)
 {
-  auto opt = readChunk(rba, riOffset);
+  auto opt = readChunk(rStream, riOffset);
   if (opt.has_value() == true)
     m_chunkIHDR = opt.value();
 
@@ -195,11 +657,13 @@ QVector<QByteArray> Reader::split(const QByteArray& rba) const
 {
   QVector<QByteArray> vIDAT;
   for (quint32 ui = 0; ui < rba.size(); ui += m_cuiLibPngLimit) {
-    QByteArray ba = rba.mid(ui, m_cuiLibPngLimit);
-    ba.prepend(m_cbaIDAT);
-    auto uiCrc = m_crc.calculate(ba);
-    ba.prepend(convert(ba.size() - 4));
-    ba.append(convert(uiCrc));
+    quint32 uiLen = qMin(m_cuiLibPngLimit, quint32(rba.size()) - ui);
+    QByteArray ba = convert(uiLen);
+    ba.reserve(uiLen + 12);
+    ba.append(m_cbaIDAT);
+    ba.append(rba.constData() + ui, uiLen);
+    // name and data are checksummed in place, right after the length
+    ba.append(convert(m_crc.update(0U, ba.constData() + 4, uiLen + 4)));
     vIDAT << ba;
   }
 
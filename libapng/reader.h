@@ -1,12 +1,20 @@
 #pragma once
 
 #include "base.h"
+#include "compositor.h"
+#include "decoder.h"
+#include "framecontrol.h"
+#include "taskrunner.h"
 
 #include <QByteArray>
 #include <QImage>
+#include <QMap>
 #include <QPixmap>
 #include <QVector>
 
+class QIODevice;
+class QThreadPool;
+
 namespace png {
 
 /**
@@ -17,10 +25,145 @@ namespace png {
 class __declspec(dllexport) Reader : public Base
 {
 public:
+  /**
+   * @brief The ReadMode enum Denotes how the input files are read
+   */
+  enum class ReadMode {
+    ermStream, ///< the file is read chunk by chunk through a small buffer
+    ermMapped  ///< the file is memory-mapped and the frame data is never copied while parsing
+  };
+
   /**
    * @brief Reader Default constructor
    */
   Reader();
+  /**
+   * @brief setReadMode Sets the way the input files are read. In the mapped mode, the file stays
+   * mapped until the next import or reset call. Devices, which can not be mapped, are always
+   * streamed.
+   * @param eMode New read mode
+   */
+  void setReadMode(ReadMode eMode);
+  /**
+   * @brief readMode Returns the way the input files are read
+   * @return Current read mode
+   */
+  ReadMode readMode() const { return m_eReadMode; }
+  /**
+   * @brief setThreadPool Sets the thread pool, which decodes the frames in parallel. The frames
+   * are returned in order regardless. By default, the global thread pool is used
+   * @param pPool Pointer to the thread pool. If nullptr, the frames are decoded one after another
+   * on the calling thread
+   */
+  void setThreadPool(QThreadPool* pPool);
+  /**
+   * @brief threadPool Returns the thread pool, which decodes the frames
+   * @return Pointer to the thread pool or nullptr, if the frames are decoded on the calling thread
+   */
+  QThreadPool* threadPool() const { return m_runner.threadPool(); }
+  /**
+   * @brief setMaxConcurrency Limits the number of threads, which decode the frames of one file at
+   * the same time, so that a single large animation does not take up the whole thread pool
+   * @param iCount Maximal number of threads, including the calling thread. If 0, the frames are
+   * decoded by as many threads as the pool allows
+   */
+  void setMaxConcurrency(int iCount);
+  /**
+   * @brief maxConcurrency Returns the maximal number of threads, which decode the frames of one
+   * file at the same time
+   * @return Maximal number of threads or 0, if it is only limited by the thread pool
+   */
+  int maxConcurrency() const { return m_runner.maxConcurrency(); }
+  /**
+   * @brief open Parses the APNG file and indexes its frames without decoding any of them. The
+   * frames can then be decoded one at a time by the frame method. The caller should call the
+   * info().isOk() method to get the details of a possible parse error.
+   * @param rqsFile Full path to the file to open
+   * @return true, if the file was parsed correctly and false otherwise
+   */
+  bool open(const QString& rqsFile);
+  /**
+   * @brief open Parses the APNG from the device and indexes its frames without decoding any of
+   * them. The device is not needed any more after this method returns
+   * @param pDevice Pointer to the device to read from. The device should be open for reading
+   * @return true, if the APNG was parsed correctly and false otherwise
+   */
+  bool open(QIODevice* pDevice);
+  /**
+   * @brief frameCount Returns the number of indexed frames. The default image is always the frame
+   * 0, even when it is not part of the animation
+   * @return number of indexed frames
+   */
+  int frameCount() const { return m_vFrames.count(); }
+  /**
+   * @brief frameControl Returns the frame control of the i-th indexed frame. The frames without
+   * their own fcTL chunk cover the whole image
+   * @param i Frame index
+   * @return Frame control of the i-th frame
+   */
+  FrameControl frameControl(int i) const;
+  /**
+   * @brief canvasFormat Returns the format of the composed images
+   * @return QImage::Format_RGBA64 for the 16-bit images and QImage::Format_ARGB32 otherwise
+   */
+  QImage::Format canvasFormat() const;
+  /**
+   * @brief frame Decodes the i-th indexed frame only. The decoded image has the frame size,
+   * declared by its fcTL chunk. This method can be called from several threads at once
+   * @param i Frame index
+   * @return Decoded frame or a null image, if the index is out of range or the frame could not be
+   * decoded
+   */
+  QImage frame(int i) const;
+  /**
+   * @brief isKeyframe Checks, whether the i-th indexed frame can be composed without any of the
+   * frames before it. The first frame of the animation is a keyframe, so is every frame, which
+   * covers the whole image with the SOURCE blend operation and is not disposed to the previous
+   * content, and every frame following a frame, which covers the whole image and is disposed to
+   * the background. The frames without their own frame control are keyframes as well
+   * @param i Frame index
+   * @return true, if the frame is a keyframe and false otherwise
+   */
+  bool isKeyframe(int i) const;
+  /**
+   * @brief composedFrame Composes the i-th indexed frame into a full image, exactly as importImages
+   * does. Only the frames since the nearest keyframe or canvas snapshot are decoded, unless the
+   * previously composed frame is closer, so consecutive calls for consecutive frames decode one
+   * frame each. Unlike the frame method, this method is not thread-safe
+   * @param i Frame index
+   * @return Composed frame or a null image, if the index is out of range or the file could not be
+   * decoded
+   */
+  QImage composedFrame(int i);
+  /**
+   * @brief setSnapshotBudget Sets the memory, which composedFrame may take up by snapshots of the
+   * canvas. The snapshots are taken periodically between the keyframes, so that seeking into long
+   * runs of frames without a keyframe stays cheap. The snapshots over the new budget are dropped
+   * @param iBytes Memory budget in [bytes]. If 0, no snapshots are taken
+   */
+  void setSnapshotBudget(qint64 iBytes);
+  /**
+   * @brief snapshotBudget Returns the memory, which composedFrame may take up by snapshots
+   * @return Memory budget in [bytes]
+   */
+  qint64 snapshotBudget() const { return m_iSnapshotBudget; }
+  /**
+   * @brief snapshotUsage Returns the memory taken up by the snapshots of the canvas
+   * @return Memory usage in [bytes]
+   */
+  qint64 snapshotUsage() const { return m_iSnapshotBytes; }
+  /**
+   * @brief setSnapshotInterval Sets the number of frames between two canvas snapshots. A seek
+   * composes at most this many frames, as long as the snapshots fit into the budget
+   * @param iFrames Number of frames between two snapshots. Values smaller than 1 are treated as 1
+   */
+  void setSnapshotInterval(int iFrames);
+  /**
+   * @brief snapshotInterval Returns the number of frames between two canvas snapshots
+   * @return Number of frames between two snapshots
+   */
+  int snapshotInterval() const { return m_iSnapshotInterval; }
+
   /**
    * @brief import Reads the APNG file and splits it into individual frames. If an error occured
    * during APNG parsing, this method will return an empty vector. In any case, the caller should
@@ -29,6 +172,14 @@ public:
    * @return Imported frames in a vector of binary content
    */
   QVector<QByteArray> import(const QString& rqsFile);
+  /**
+   * @brief import Reads the APNG from the device and splits it into individual frames. The device
+   * is read chunk by chunk through a small buffer, so the whole file is never held in memory at
+   * once.
+   * @param pDevice Pointer to the device to read from. The device should be open for reading
+   * @return Imported frames in a vector of binary content
+   */
+  QVector<QByteArray> import(QIODevice* pDevice);
   /**
    * @brief import Reads the APNG file and splits it into individual frames
    * @param rqsFile Full path to the file to read
@@ -39,11 +190,20 @@ public:
   void import(const QString& rqsFile, const QString& rqsOutFile);
 
   /**
-   * @brief importImages Reads the APNG file and splits it into individual frames
+   * @brief importImages Reads the APNG file and splits it into individual frames. The frames are
+   * decoded directly from the compressed image data, without building standalone PNG files first,
+   * and composed into full images by their offsets, dispose and blend operations
    * @param rqsFile Full path to the file to read
    * @return Imported frames in a vector of QImages
    */
   QVector<QImage> importImages(const QString& rqsFile);
+  /**
+   * @brief importImages Reads the APNG from the device and splits it into individual composed
+   * frames
+   * @param pDevice Pointer to the device to read from. The device should be open for reading
+   * @return Imported frames in a vector of QImages
+   */
+  QVector<QImage> importImages(QIODevice* pDevice);
 
   /**
    * @brief importPixmaps Reads the APNG file and splits it into individual frames
@@ -51,6 +211,12 @@ public:
    * @return Imported frames in a vector of QPixmaps
    */
   QVector<QPixmap> importPixmaps(const QString& rqsFile);
+  /**
+   * @brief importPixmaps Reads the APNG from the device and splits it into individual frames
+   * @param pDevice Pointer to the device to read from. The device should be open for reading
+   * @return Imported frames in a vector of QPixmaps
+   */
+  QVector<QPixmap> importPixmaps(QIODevice* pDevice);
   /**
    * @brief reset Resets all the parsed data. This method is called automatically by all the import
    * methods, so no need to call it explicitly, unless the resources taken by the individual frames
@@ -60,22 +226,159 @@ public:
 
 private:
   /**
-   * @brief readContent Reads the content of the file and returns it
-   * @param rqsFile Full path to the file to read
-   * @return Content of the file
+   * @brief The Frame struct This struct holds the index entry of one frame. In the mapped mode,
+   * only the position of the image data is kept, in the stream mode the data itself
+   */
+  struct Frame {
+    FrameControl m_control;
+    bool m_bControl = false;
+    QVector<ChunkView> m_vView;
+    QVector<QByteArray> m_vData;
+    QVector<quint32> m_vSequence;
+    int m_iKeyframe = -1;
+
+    /**
+     * @brief hasData Returns true, if any image data belongs to the frame
+     * @return true, if any image data belongs to the frame and false otherwise
+     */
+    bool hasData() const { return (m_vView.isEmpty() == false) || (m_vData.isEmpty() == false); }
+  };
+
+  /**
+   * @brief parse Parses the file, either by mapping or by streaming it
+   * @param rqsFile Full path to the file to parse
+   * @return true, if the PNG signature was found and false otherwise
+   */
+  bool parse(const QString& rqsFile);
+  /**
+   * @brief parse Parses the device, either by mapping or by streaming it
+   * @param pDevice Pointer to the device to parse
+   * @return true, if the PNG signature was found and false otherwise
+   */
+  bool parse(QIODevice* pDevice);
+  /**
+   * @brief frames Builds standalone PNG files from the parsed frames
+   * @return Parsed frames in a vector of binary content
+   */
+  QVector<QByteArray> frames() const;
+  /**
+   * @brief frameData Returns the compressed image data of the i-th parsed frame. In the mapped
+   * mode, the returned array refers to the mapping whenever the data does not need to be joined
+   * @param i Frame index
+   * @return Compressed image data
+   */
+  QByteArray frameData(int i) const;
+  /**
+   * @brief frameSegments Returns the compressed image data of the i-th parsed frame as it is
+   * stored in the file, split into one piece per chunk. Nothing is copied in the mapped mode
+   * @param i Frame index
+   * @return Compressed image data pieces
+   */
+  QVector<QByteArray> frameSegments(int i) const;
+  /**
+   * @brief prepareDecoder Sets up the decoder for the parsed file
+   * @return true, if the parsed IHDR chunk is valid and false otherwise
+   */
+  bool prepareDecoder();
+  /**
+   * @brief decodeImages Decodes the parsed frames directly into images, in parallel if a thread
+   * pool is set
+   * @return Decoded images
+   */
+  QVector<QImage> decodeImages() const;
+  /**
+   * @brief composeImages Composes the decoded frames into full images. The frames without their
+   * own frame control, like the default image, which is not part of the animation, are returned
+   * unchanged
+   * @param rvFrames Reference to the decoded frames
+   * @return Composed images
+   */
+  QVector<QImage> composeImages(const QVector<QImage>& rvFrames) const;
+  /**
+   * @brief indexKeyframes Finds the nearest keyframe at or before every parsed frame
+   */
+  void indexKeyframes();
+  /**
+   * @brief seek Prepares the compositor for composing the i-th frame from the closest state: the
+   * previously composed frame, the nearest snapshot or the nearest keyframe
+   * @param i Index of the frame to compose
+   * @return Index of the first frame, which has to be composed
    */
-  QByteArray readContent(const QString& rqsFile);
+  int seek(int i);
+  /**
+   * @brief takeSnapshot Saves the canvas before the i-th frame is composed, if the snapshot is due
+   * and fits into the budget
+   * @param i Index of the frame, which is about to be composed
+   */
+  void takeSnapshot(int i);
+  /**
+   * @brief toPixmaps Converts the images into pixmaps
+   * @param rvImg Reference to the images to convert
+   * @return Converted pixmaps
+   */
+  QVector<QPixmap> toPixmaps(const QVector<QImage>& rvImg) const;
+  /**
+   * @brief readSignature Reads the PNG signature from the mapped file
+   * @param rMap Reference to the mapped file
+   * @return true, if the signature was found and false otherwise
+   */
+  bool readSignature(const MappedFile& rMap);
+  /**
+   * @brief readSignature Reads the PNG signature from the stream
+   * @param rStream Reference to the stream to read from
+   * @return true, if the signature was found and false otherwise
+   */
+  bool readSignature(ChunkStream& rStream);
   /**
    * @brief parseChunks Parses PNG chunks
-   * @param rba Reference to the byte array to parse
+   * @param rStream Reference to the stream to parse
+   */
+  void parseChunks(ChunkStream& rStream);
+  /**
+   * @brief parseChunks Parses PNG chunks of the mapped file. IDAT and fdAT chunks are only
+   * recorded as views into the mapping
+   * @param rMap Reference to the mapped file
+   */
+  void parseChunks(const MappedFile& rMap);
+  /**
+   * @brief parseChunk Handles a chunk, which does not contain image data
+   * @param rChunk Reference to the chunk
+   * @param uiOffset Offset of the end of the chunk
    */
-  void parseChunks(const QByteArray& rba);
+  void parseChunk(const Chunk& rChunk, quint32 uiOffset);
+  /**
+   * @brief indexFCTL Adds the frame control into the frame index. The fcTL chunk before the first
+   * IDAT chunk belongs to the default image, any other one starts a new frame. The malformed fcTL
+   * chunk is reported as an error, but it still starts a frame, so that its data stays separate
+   * @param rbaContent Reference to the fcTL chunk content
+   * @param uiOffset Offset of the end of the chunk
+   */
+  void indexFCTL(const QByteArray& rbaContent, quint32 uiOffset);
+  /**
+   * @brief checkSequence Checks, whether the sequence number of the fcTL or fdAT chunk follows the
+   * one of the previous such chunk. The first error is kept in the info
+   * @param rbaContent Reference to the chunk content, which starts with the sequence number
+   * @param uiOffset Offset of the end of the chunk
+   */
+  void checkSequence(const QByteArray& rbaContent, quint32 uiOffset);
+  /**
+   * @brief dataFrame Returns the index entry, which the next image data chunk belongs to
+   * @param bIDAT Indicates, whether the image data chunk is IDAT or fdAT
+   * @return Reference to the frame index entry
+   */
+  Frame& dataFrame(bool bIDAT);
+  /**
+   * @brief checkChunks Checks, whether all the required chunks were found
+   * @param bIDAT Indicates, whether any image data was found
+   * @param uiOffset Offset, where the parsing stopped
+   */
+  void checkChunks(bool bIDAT, quint32 uiOffset);
   /**
    * @brief parseIHDR parses the IHDR chunk
-   * @param rba APNG content
+   * @param rStream Reference to the stream to parse
    * @param riOffset reference to the offset variable
    */
-  void parseIHDR(const QByteArray& rba, quint32& riOffset);
+  void parseIHDR(ChunkStream& rStream, quint32& riOffset);
   /**
    * @brief split Splits the content into chunks of 8192 bytes (png library limit). It also equips
    * the chunks with size, IDAT and CRC
@@ -86,9 +389,29 @@ private:
 
 private:
   Chunk m_chunkIHDR;
-  QByteArray m_baIDAT;
-  QVector<Chunk> m_vfDAT;
   QVector<Chunk> m_vOtherChunks;
+  QVector<Frame> m_vFrames;
+
+  ReadMode m_eReadMode;
+  TaskRunner m_runner;
+  MappedFile m_map;
+  Decoder m_decoder;
+  Compositor m_compositor;
+  QMap<int, QImage> m_mapSnapshot;
+  qint64 m_iSnapshotBudget;
+  qint64 m_iSnapshotBytes;
+  int m_iSnapshotInterval;
+  int m_iComposed;
+  bool m_bDecoder;
+  bool m_bIEND;
+  bool m_bACTL;
+  quint32 m_uiSequence;
+
+  const quint32 m_cuiReadBufferSize = 65536U;
+  /**
+   * @brief m_ciSeekBatch Number of frames, which composedFrame decodes in parallel at once
+   */
+  const int m_ciSeekBatch = 8;
 };
 
 } // namespace png
@@ -0,0 +1,400 @@
+#include "reducer.h"
+
+#include "header.h"
+#include "quantizer.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LIBAPNG_REDUCER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LIBAPNG_TARGET_SSE2
+#else
+#include <cpuid.h>
+#define LIBAPNG_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LIBAPNG_REDUCER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace png {
+
+namespace {
+
+/*
+ * The properties are accumulated without branches, so that whole rows are scanned by the vector
+ * instructions:
+ *
+ *   - the pixels are opaque, if the alpha byte of their AND is 255
+ *   - the pixels are gray, if every channel equals the next one, i.e. the low 16 bits of
+ *     p ^ (p >> 8) are zero for all of them
+ *   - the gray level b fits n bits, if it repeats its top n bits, i.e. the low 8 - n bits of
+ *     b ^ (b >> n) are zero. The mismatches for 1, 2 and 4 bits are kept in bytes 0, 1 and 2
+ */
+
+const quint32 cuiChromaMask = 0xFFFFU;
+const quint32 cuiLevels1    = 0x7FU;
+const quint32 cuiLevels2    = 0x3FU;
+const quint32 cuiLevels4    = 0x0FU;
+
+void scanScalar(const QRgb* pLine, int iWidth, Reducer::Stats& rStats)
+{
+  quint32 uiAlpha  = rStats.m_uiAlpha;
+  quint32 uiChroma = 0U;
+  quint32 uiLevels = 0U;
+  for (int x = 0; x < iWidth; ++x) {
+    quint32 ui     = pLine[x];
+    quint32 uiBlue = ui & 0xFFU;
+    uiAlpha &= ui;
+    uiChroma |= ui ^ (ui >> 8);
+    uiLevels |= ((uiBlue ^ (uiBlue >> 1)) & cuiLevels1) |
+                (((uiBlue ^ (uiBlue >> 2)) & cuiLevels2) << 8) |
+                (((uiBlue ^ (uiBlue >> 4)) & cuiLevels4) << 16);
+  }
+
+  rStats.m_uiAlpha = uiAlpha;
+  rStats.m_uiChroma |= uiChroma & cuiChromaMask;
+  rStats.m_uiLevels |= uiLevels;
+}
+
+#if defined(LIBAPNG_REDUCER_X86)
+
+LIBAPNG_TARGET_SSE2 void scanSse2(const QRgb* pLine, int iWidth, Reducer::Stats& rStats)
+{
+  const __m128i blue = _mm_set1_epi32(0xFF);
+  __m128i alpha      = _mm_set1_epi32(-1);
+  __m128i chroma     = _mm_setzero_si128();
+  __m128i levels1    = _mm_setzero_si128();
+  __m128i levels2    = _mm_setzero_si128();
+  __m128i levels4    = _mm_setzero_si128();
+  int x              = 0;
+  for (; x + 4 <= iWidth; x += 4) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pLine + x));
+    __m128i b = _mm_and_si128(p, blue);
+    alpha     = _mm_and_si128(alpha, p);
+    chroma    = _mm_or_si128(chroma, _mm_xor_si128(p, _mm_srli_epi32(p, 8)));
+    // the masks are applied once to the accumulated bits
+    levels1 = _mm_or_si128(levels1, _mm_xor_si128(b, _mm_srli_epi32(b, 1)));
+    levels2 = _mm_or_si128(levels2, _mm_xor_si128(b, _mm_srli_epi32(b, 2)));
+    levels4 = _mm_or_si128(levels4, _mm_xor_si128(b, _mm_srli_epi32(b, 4)));
+  }
+
+  quint32 auiAlpha[4], auiChroma[4], auiLevels1[4], auiLevels2[4], auiLevels4[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(auiAlpha), alpha);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(auiChroma), chroma);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(auiLevels1), levels1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(auiLevels2), levels2);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(auiLevels4), levels4);
+  for (int i = 0; i < 4; ++i) {
+    rStats.m_uiAlpha &= auiAlpha[i];
+    rStats.m_uiChroma |= auiChroma[i] & cuiChromaMask;
+    rStats.m_uiLevels |= (auiLevels1[i] & cuiLevels1) | ((auiLevels2[i] & cuiLevels2) << 8) |
+                         ((auiLevels4[i] & cuiLevels4) << 16);
+  }
+
+  scanScalar(pLine + x, iWidth - x, rStats);
+}
+
+bool hasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+  return true;
+#elif defined(_MSC_VER)
+  int aiInfo[4];
+  __cpuid(aiInfo, 1);
+  return (aiInfo[3] & (1 << 26)) != 0;
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    return false;
+  return (edx & (1U << 26)) != 0;
+#endif
+}
+
+#elif defined(LIBAPNG_REDUCER_NEON)
+
+void scanNeon(const QRgb* pLine, int iWidth, Reducer::Stats& rStats)
+{
+  const uint32x4_t blue = vdupq_n_u32(0xFF);
+  uint32x4_t alpha      = vdupq_n_u32(0xFFFFFFFFU);
+  uint32x4_t chroma     = vdupq_n_u32(0);
+  uint32x4_t levels1    = vdupq_n_u32(0);
+  uint32x4_t levels2    = vdupq_n_u32(0);
+  uint32x4_t levels4    = vdupq_n_u32(0);
+  int x                 = 0;
+  for (; x + 4 <= iWidth; x += 4) {
+    uint32x4_t p = vld1q_u32(reinterpret_cast<const quint32*>(pLine + x));
+    uint32x4_t b = vandq_u32(p, blue);
+    alpha        = vandq_u32(alpha, p);
+    chroma       = vorrq_u32(chroma, veorq_u32(p, vshrq_n_u32(p, 8)));
+    // the masks are applied once to the accumulated bits
+    levels1 = vorrq_u32(levels1, veorq_u32(b, vshrq_n_u32(b, 1)));
+    levels2 = vorrq_u32(levels2, veorq_u32(b, vshrq_n_u32(b, 2)));
+    levels4 = vorrq_u32(levels4, veorq_u32(b, vshrq_n_u32(b, 4)));
+  }
+
+  quint32 auiAlpha[4], auiChroma[4], auiLevels1[4], auiLevels2[4], auiLevels4[4];
+  vst1q_u32(auiAlpha, alpha);
+  vst1q_u32(auiChroma, chroma);
+  vst1q_u32(auiLevels1, levels1);
+  vst1q_u32(auiLevels2, levels2);
+  vst1q_u32(auiLevels4, levels4);
+  for (int i = 0; i < 4; ++i) {
+    rStats.m_uiAlpha &= auiAlpha[i];
+    rStats.m_uiChroma |= auiChroma[i] & cuiChromaMask;
+    rStats.m_uiLevels |= (auiLevels1[i] & cuiLevels1) | ((auiLevels2[i] & cuiLevels2) << 8) |
+                         ((auiLevels4[i] & cuiLevels4) << 16);
+  }
+
+  scanScalar(pLine + x, iWidth - x, rStats);
+}
+
+#endif
+
+/**
+ * @brief gray16 Returns the gray level of the 16-bit color, which is exact for the gray colors
+ * @param rgb Color
+ * @return Gray level
+ */
+quint16 gray16(QRgba64 rgb)
+{
+  return quint16((quint32(rgb.red()) * 11U + quint32(rgb.green()) * 16U +
+                  quint32(rgb.blue()) * 5U) / 32U);
+}
+
+} // namespace
+
+Reducer::Reducer() : m_pfnScan(&scanScalar), m_bManyColors(false), m_bDeep(false), m_iImages(0)
+{
+#if defined(LIBAPNG_REDUCER_X86)
+  if (hasSse2() == true)
+    m_pfnScan = &scanSse2;
+#elif defined(LIBAPNG_REDUCER_NEON)
+  // NEON is a mandatory part of ARMv8
+  m_pfnScan = &scanNeon;
+#endif
+}
+
+void Reducer::add(const QImage& rImg)
+{
+  if (rImg.isNull() == true)
+    return;
+
+  ++m_iImages;
+  QImage img;
+  if ((rImg.depth() == 64) || (rImg.format() == QImage::Format_Grayscale16)) {
+    // the 16-bit samples, which repeat their high byte, are exact 8-bit values
+    auto img64        = rImg.convertToFormat(QImage::Format_RGBA64);
+    quint64 uiInexact = 0U;
+    for (int y = 0; y < img64.height(); ++y) {
+      auto pLine = reinterpret_cast<const quint64*>(img64.constScanLine(y));
+      for (int x = 0; x < img64.width(); ++x)
+        uiInexact |= (pLine[x] ^ (pLine[x] >> 8)) & 0x00FF00FF00FF00FFULL;
+    }
+
+    if (uiInexact != 0U) {
+      addDeep(img64);
+      return;
+    }
+    img = img64.convertToFormat(QImage::Format_ARGB32);
+  } else {
+    img = rImg.convertToFormat(QImage::Format_ARGB32);
+  }
+
+  for (int y = 0; y < img.height(); ++y) {
+    auto pLine = reinterpret_cast<const QRgb*>(img.constScanLine(y));
+    m_pfnScan(pLine, img.width(), m_stats);
+    if (m_bManyColors == false)
+      addColors(pLine, img.width());
+  }
+}
+
+void Reducer::addDeep(const QImage& rImg)
+{
+  // the palette entries only have 8 bits per channel
+  m_bDeep       = true;
+  m_bManyColors = true;
+  m_setColors.clear();
+
+  bool bOpaque = true;
+  bool bGray   = true;
+  for (int y = 0; y < rImg.height(); ++y) {
+    auto pLine = reinterpret_cast<const QRgba64*>(rImg.constScanLine(y));
+    for (int x = 0; x < rImg.width(); ++x) {
+      bOpaque = bOpaque && (pLine[x].alpha() == 65535U);
+      bGray   = bGray && (pLine[x].red() == pLine[x].green()) &&
+              (pLine[x].green() == pLine[x].blue());
+    }
+  }
+
+  if (bOpaque == false)
+    m_stats.m_uiAlpha &= 0x00FFFFFFU;
+  if (bGray == false)
+    m_stats.m_uiChroma |= 1U;
+}
+
+void Reducer::addColors(const QRgb* pLine, int iWidth)
+{
+  // the runs of the same color are looked up at once
+  for (int x = 0; x < iWidth;) {
+    QRgb rgb = pLine[x];
+    while ((x < iWidth) && (pLine[x] == rgb))
+      ++x;
+
+    m_setColors.insert(qAlpha(rgb) == 0 ? 0U : rgb);
+    if (m_setColors.count() > 256) {
+      m_bManyColors = true;
+      m_setColors.clear();
+      return;
+    }
+  }
+}
+
+void Reducer::clear()
+{
+  m_stats = Stats();
+  m_setColors.clear();
+  m_bManyColors = false;
+  m_bDeep       = false;
+  m_iImages     = 0;
+}
+
+quint8 Reducer::colorType() const
+{
+  if (isNull() == true)
+    return Header::ectRGBA;
+
+  bool bOpaque = ((m_stats.m_uiAlpha >> 24) == 0xFFU);
+  bool bGray   = (bOpaque == true) && (m_stats.m_uiChroma == 0U);
+  if (m_bDeep == true)
+    return (bGray == true ? Header::ectGray : (bOpaque == true ? Header::ectRGB : Header::ectRGBA));
+
+  // the gray levels win over the palette indices of the same size, since they need no PLTE chunk
+  if ((bGray == true) &&
+      ((m_bManyColors == true) || (grayBits() <= indexBits(m_setColors.count()))))
+    return Header::ectGray;
+  if (m_bManyColors == false)
+    return Header::ectPalette;
+
+  return (bOpaque == true ? Header::ectRGB : Header::ectRGBA);
+}
+
+quint8 Reducer::bitDepth() const
+{
+  switch (colorType()) {
+  case Header::ectGray:
+    return (m_bDeep == true ? 16U : grayBits());
+  case Header::ectPalette:
+    return indexBits(m_setColors.count());
+  default:
+    return (m_bDeep == true ? 16U : 8U);
+  }
+}
+
+QVector<QRgb> Reducer::palette() const
+{
+  if (colorType() != Header::ectPalette)
+    return {};
+
+  // the order of the set is not defined, but the palette has to be reproducible
+  QVector<QRgb> vPalette;
+  for (auto rgb : m_setColors)
+    vPalette << rgb;
+  std::sort(vPalette.begin(), vPalette.end(), [](QRgb rgbA, QRgb rgbB) {
+    return (qAlpha(rgbA) < qAlpha(rgbB)) || ((qAlpha(rgbA) == qAlpha(rgbB)) && (rgbA < rgbB));
+  });
+  return vPalette;
+}
+
+QImage Reducer::reduce(const QImage& rImg) const
+{
+  if ((rImg.isNull() == true) || (isNull() == true))
+    return rImg;
+
+  switch (colorType()) {
+  case Header::ectPalette:
+    return Quantizer().quantize(rImg, palette());
+  case Header::ectRGB:
+    return rImg.convertToFormat(m_bDeep == true ? QImage::Format_RGBX64 : QImage::Format_RGB32);
+  case Header::ectRGBA:
+    return rImg.convertToFormat(m_bDeep == true ? QImage::Format_RGBA64 : QImage::Format_ARGB32);
+  default:
+    break;
+  }
+
+  // the channels of the gray colors are the same, the other colors are converted to their luma
+  if (m_bDeep == true) {
+    auto imgSrc = rImg.convertToFormat(QImage::Format_RGBA64);
+    QImage img(imgSrc.size(), QImage::Format_Grayscale16);
+    for (int y = 0; y < img.height(); ++y) {
+      auto pSrc = reinterpret_cast<const QRgba64*>(imgSrc.constScanLine(y));
+      auto pDst = reinterpret_cast<quint16*>(img.scanLine(y));
+      for (int x = 0; x < img.width(); ++x)
+        pDst[x] = gray16(pSrc[x]);
+    }
+    return img;
+  }
+
+  auto imgSrc = rImg.convertToFormat(QImage::Format_ARGB32);
+  QImage img(imgSrc.size(), QImage::Format_Grayscale8);
+  for (int y = 0; y < img.height(); ++y) {
+    auto pSrc = reinterpret_cast<const QRgb*>(imgSrc.constScanLine(y));
+    auto pDst = img.scanLine(y);
+    for (int x = 0; x < img.width(); ++x)
+      pDst[x] = uchar(qGray(pSrc[x]));
+  }
+  return img;
+}
+
+bool Reducer::holds(const QImage& rImg) const
+{
+  if ((rImg.isNull() == true) || (isNull() == true))
+    return true;
+
+  Reducer reducer;
+  reducer.add(rImg);
+  bool bOpaque = ((reducer.m_stats.m_uiAlpha >> 24) == 0xFFU);
+  bool bGray   = (bOpaque == true) && (reducer.m_stats.m_uiChroma == 0U);
+  // the 16-bit samples only fit into the formats with 16-bit samples
+  bool bDepth = (m_bDeep == true) || (reducer.m_bDeep == false);
+  switch (colorType()) {
+  case Header::ectRGBA:
+    return bDepth;
+  case Header::ectRGB:
+    return (bDepth == true) && (bOpaque == true);
+  case Header::ectPalette:
+    if (reducer.m_bManyColors == true)
+      return false;
+    return std::all_of(reducer.m_setColors.begin(), reducer.m_setColors.end(),
+                       [this](QRgb rgb) { return m_setColors.contains(rgb); });
+  default:
+    break;
+  }
+
+  // the levels of the lower bit depths are also levels of the higher ones
+  return (bDepth == true) && (bGray == true) &&
+         ((m_bDeep == true) || (reducer.grayBits() <= grayBits()));
+}
+
+quint8 Reducer::indexBits(int iColors)
+{
+  if (iColors <= 2)
+    return 1U;
+  if (iColors <= 4)
+    return 2U;
+  return (iColors <= 16 ? 4U : 8U);
+}
+
+quint8 Reducer::grayBits() const
+{
+  if ((m_stats.m_uiLevels & cuiLevels1) == 0U)
+    return 1U;
+  if (((m_stats.m_uiLevels >> 8) & cuiLevels2) == 0U)
+    return 2U;
+  return (((m_stats.m_uiLevels >> 16) & cuiLevels4) == 0U ? 4U : 8U);
+}
+
+} // namespace png
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QImage>
+#include <QSet>
+#include <QVector>
+
+namespace png {
+
+/**
+ * @brief The Reducer class This class finds the smallest lossless format, in which all the frames
+ * of an animation can be stored, since they share one IHDR chunk. The frames are analyzed by the
+ * add method, in one pass over their pixels, and the format is chosen from the results: the alpha
+ * channel is dropped from the opaque frames, the gray frames are stored as grayscale, the frames
+ * with at most 256 colors are stored with a palette, and the gray levels, the palette indices and
+ * the 16-bit samples, which are exact 8-bit values, take the least bits possible. The fully
+ * transparent pixels are all treated as transparent black.
+ */
+class __declspec(dllexport) Reducer
+{
+public:
+  /**
+   * @brief Reducer Default constructor. Selects the implementation of the pixel analysis for the
+   * current CPU
+   */
+  Reducer();
+  /**
+   * @brief add Analyzes the pixels of the image
+   * @param rImg Reference to the image
+   */
+  void add(const QImage& rImg);
+  /**
+   * @brief clear Forgets all the analyzed images
+   */
+  void clear();
+  /**
+   * @brief isNull Indicates, whether no image was analyzed yet
+   * @return true, if no image was analyzed and false otherwise
+   */
+  bool isNull() const { return m_iImages == 0; }
+  /**
+   * @brief colorType Returns the PNG color type of the smallest format (see Header::ColorType)
+   * @return Color type or Header::ectRGBA, if no image was analyzed
+   */
+  quint8 colorType() const;
+  /**
+   * @brief bitDepth Returns the PNG bit depth of the smallest format
+   * @return Bit depth of 1, 2, 4, 8 or 16 bits
+   */
+  quint8 bitDepth() const;
+  /**
+   * @brief palette Returns the palette of the smallest format. The translucent entries come first,
+   * so that the tRNS chunk stays short
+   * @return Palette, which is empty unless the color type is Header::ectPalette
+   */
+  QVector<QRgb> palette() const;
+  /**
+   * @brief reduce Converts the image into the format, which the Encoder stores with the color
+   * type and the bit depth of the smallest format. The analyzed images are converted losslessly,
+   * the other ones lose the colors, which the format can not hold
+   * @param rImg Reference to the image to convert
+   * @return Converted image
+   */
+  QImage reduce(const QImage& rImg) const;
+  /**
+   * @brief holds Checks, whether the image can be stored in the smallest format without any loss,
+   * which is always the case for the analyzed images
+   * @param rImg Reference to the image to check
+   * @return true, if the reduce method converts the image losslessly and false otherwise
+   */
+  bool holds(const QImage& rImg) const;
+  /**
+   * @brief indexBits Returns the least bit depth, whose palette indices address all the entries
+   * @param iColors Number of palette entries
+   * @return Bit depth of 1, 2, 4 or 8 bits
+   */
+  static quint8 indexBits(int iColors);
+
+  /**
+   * @brief The Stats struct Holds the properties of the analyzed pixels, which are accumulated
+   * over all the pixels by the bitwise operations
+   */
+  struct Stats {
+    quint32 m_uiAlpha  = 0xFFFFFFFFU; ///< AND of the pixels, its alpha is 255 if all are opaque
+    quint32 m_uiChroma = 0U;          ///< differences of the channels, 0 if all are gray
+    quint32 m_uiLevels = 0U;          ///< mismatches of the gray levels with 1, 2 and 4 bits
+  };
+
+  /**
+   * @brief Scan Function, which accumulates the properties of a row of QImage::Format_ARGB32
+   * pixels. Its arguments are the row, the number of pixels and the properties
+   */
+  using Scan = void (*)(const QRgb*, int, Stats&);
+
+private:
+  /**
+   * @brief addDeep Analyzes the 16-bit image, whose samples are not all exact 8-bit values
+   * @param rImg Reference to the image in QImage::Format_RGBA64
+   */
+  void addDeep(const QImage& rImg);
+  /**
+   * @brief addColors Collects the colors of the row, until there are more than 256 of them
+   * @param pLine Pointer to the row of QImage::Format_ARGB32 pixels
+   * @param iWidth Number of pixels
+   */
+  void addColors(const QRgb* pLine, int iWidth);
+  /**
+   * @brief grayBits Returns the least bits, which hold all the gray levels
+   * @return Number of bits from 1 to 8
+   */
+  quint8 grayBits() const;
+
+private:
+  Scan m_pfnScan;
+  Stats m_stats;
+  QSet<QRgb> m_setColors;
+  bool m_bManyColors;
+  bool m_bDeep;
+  int m_iImages;
+};
+
+} // namespace png
@@ -0,0 +1,93 @@
+#include "taskrunner.h"
+
+#include <memory>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace png {
+
+namespace {
+
+/**
+ * @brief The RunState struct Holds the state shared by all the threads working on one call
+ */
+struct RunState {
+  std::function<void(int)> m_fnTask;
+  int m_iCount = 0;
+  QAtomicInt m_iNext;
+  int m_iDone = 0;
+  QMutex m_mutex;
+  QWaitCondition m_wcDone;
+
+  /**
+   * @brief work Takes the tasks one by one until there are no more left
+   */
+  void work()
+  {
+    int iDone = 0;
+    for (int i = m_iNext.fetchAndAddRelaxed(1); i < m_iCount; i = m_iNext.fetchAndAddRelaxed(1)) {
+      m_fnTask(i);
+      ++iDone;
+    }
+
+    if (iDone == 0)
+      return;
+
+    QMutexLocker locker(&m_mutex);
+    m_iDone += iDone;
+    if (m_iDone == m_iCount)
+      m_wcDone.wakeAll();
+  }
+};
+
+} // namespace
+
+TaskRunner::TaskRunner(QThreadPool* pPool) : m_pPool(pPool), m_iMaxConcurrency(0) {}
+
+void TaskRunner::setThreadPool(QThreadPool* pPool)
+{
+  m_pPool = pPool;
+}
+
+void TaskRunner::setMaxConcurrency(int iCount)
+{
+  m_iMaxConcurrency = qMax(0, iCount);
+}
+
+void TaskRunner::run(int iCount, const std::function<void(int)>& rfnTask) const
+{
+  int iHelpers = 0;
+  if (m_pPool != nullptr) {
+    iHelpers = m_pPool->maxThreadCount();
+    if (m_iMaxConcurrency > 0)
+      iHelpers = qMin(iHelpers, m_iMaxConcurrency - 1);
+    iHelpers = qMin(iHelpers, iCount - 1);
+  }
+
+  if (iHelpers <= 0) {
+    for (int i = 0; i < iCount; ++i)
+      rfnTask(i);
+    return;
+  }
+
+  // the helpers, which only get to run after all the tasks are taken, find nothing to do, but they
+  // may still be queued after this method returns, hence the shared state
+  auto pState      = std::make_shared<RunState>();
+  pState->m_fnTask = rfnTask;
+  pState->m_iCount = iCount;
+  for (int i = 0; i < iHelpers; ++i)
+    m_pPool->start(QRunnable::create([pState]() { pState->work(); }));
+
+  pState->work();
+
+  QMutexLocker locker(&pState->m_mutex);
+  while (pState->m_iDone < iCount)
+    pState->m_wcDone.wait(&pState->m_mutex);
+}
+
+} // namespace png
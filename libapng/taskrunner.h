@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+
+#include <QtGlobal>
+
+class QThreadPool;
+
+namespace png {
+
+/**
+ * @brief The TaskRunner class This class runs a number of independent tasks on a QThreadPool. The
+ * calling thread always takes part in the work, so the tasks finish even when the pool is busy
+ * with something else, and the number of threads working on one call can be bounded.
+ */
+class __declspec(dllexport) TaskRunner
+{
+public:
+  /**
+   * @brief TaskRunner Constructor
+   * @param pPool Pointer to the thread pool to use. If nullptr, all the tasks are run on the
+   * calling thread
+   */
+  explicit TaskRunner(QThreadPool* pPool = nullptr);
+  /**
+   * @brief setThreadPool Sets the thread pool to use
+   * @param pPool Pointer to the thread pool. If nullptr, all the tasks are run on the calling
+   * thread
+   */
+  void setThreadPool(QThreadPool* pPool);
+  /**
+   * @brief threadPool Returns the thread pool in use
+   * @return Pointer to the thread pool in use
+   */
+  QThreadPool* threadPool() const { return m_pPool; }
+  /**
+   * @brief setMaxConcurrency Limits the number of threads, which work on one call of the run
+   * method at the same time, including the calling thread
+   * @param iCount Maximal number of threads. If 0 or less, the limit is the maximal thread count of
+   * the pool plus the calling thread
+   */
+  void setMaxConcurrency(int iCount);
+  /**
+   * @brief maxConcurrency Returns the maximal number of threads working on one call
+   * @return Maximal number of threads or 0, if it is not limited
+   */
+  int maxConcurrency() const { return m_iMaxConcurrency; }
+  /**
+   * @brief run Calls rfnTask for every index from 0 to iCount - 1 and returns when all the calls
+   * are finished. The calls may run in any order and at the same time
+   * @param iCount Number of tasks
+   * @param rfnTask Reference to the task function, which takes the task index as parameter
+   */
+  void run(int iCount, const std::function<void(int)>& rfnTask) const;
+
+private:
+  QThreadPool* m_pPool;
+  int m_iMaxConcurrency;
+};
+
+} // namespace png
@@ -1,17 +1,233 @@
 #include "writer.h"
 
-#include <QBuffer>
-#include <QDateTime>
 #include <QFile>
 #include <QImage>
+#include <QLocale>
 #include <QPixmap>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 #include <QtEndian>
 
+#include <algorithm>
+#include <cstring>
+
+#include "blend.h"
+
 namespace png {
 
-Writer::Writer() {}
+namespace {
+
+quint32 alpha(QRgb c)
+{
+  return quint32(qAlpha(c));
+}
+
+quint32 alpha(QRgba64 c)
+{
+  return c.alpha();
+}
+
+/**
+ * @brief clearUnchanged Clears the pixels of the cropped frame, which are the same as on the
+ * canvas, so that the canvas shows through them when the frame is blended by the OVER operation
+ * @param rCanvas Reference to the canvas, which the frame is blended onto
+ * @param rImg Reference to the frame, cropped to the region
+ * @param rRect Reference to the region of the frame on the canvas
+ * @param uiOpaque Alpha value of the opaque pixels
+ * @return true, if the blended frame reproduces the image exactly and false otherwise
+ */
+template<typename T>
+bool clearUnchanged(const QImage& rCanvas, QImage& rImg, const QRect& rRect, quint32 uiOpaque)
+{
+  for (int iY = 0; iY < rRect.height(); ++iY) {
+    auto pCanvas = reinterpret_cast<const T*>(rCanvas.constScanLine(rRect.y() + iY)) + rRect.x();
+    auto pImg    = reinterpret_cast<T*>(rImg.scanLine(iY));
+    for (int iX = 0; iX < rRect.width(); ++iX) {
+      if (std::memcmp(pCanvas + iX, pImg + iX, sizeof(T)) == 0) {
+        std::memset(pImg + iX, 0, sizeof(T));
+        continue;
+      }
+
+      // a changed pixel only comes out unchanged, if it is opaque or the canvas under it is empty
+      quint32 uiAlpha = alpha(pImg[iX]);
+      if ((uiAlpha != uiOpaque) && ((uiAlpha == 0U) || (alpha(pCanvas[iX]) != 0U)))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief sameImage Compares two images byte by byte, in their own format
+ * @param rImg1 Reference to the first image
+ * @param rImg2 Reference to the second image
+ * @return true, if the images have the same size, format, color table and pixels
+ */
+bool sameImage(const QImage& rImg1, const QImage& rImg2)
+{
+  if ((rImg1.isNull() == true) || (rImg1.size() != rImg2.size()) ||
+      (rImg1.format() != rImg2.format()) || (rImg1.colorTable() != rImg2.colorTable()))
+    return false;
+
+  // the images, which share the data, are the same without looking at it
+  if (rImg1.cacheKey() == rImg2.cacheKey())
+    return true;
+
+  // the padding at the end of the rows is not compared, the first difference ends the comparison
+  const size_t uiRow = (size_t(rImg1.width()) * size_t(rImg1.depth()) + 7U) / 8U;
+  for (int iY = 0; iY < rImg1.height(); ++iY) {
+    if (std::memcmp(rImg1.constScanLine(iY), rImg2.constScanLine(iY), uiRow) != 0)
+      return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+Writer::Writer()
+  : m_iW(0), m_iH(0), m_encoder(EncoderOptions::preset(EncoderOptions::Preset::epArchive)),
+    m_pCache(nullptr), m_bDeterministic(false), m_qsSoftware("libapng v1.0"), m_bDigest(false),
+    m_eDigest(QCryptographicHash::Blake2b_256), m_bWriteFailed(false),
+    m_runner(QThreadPool::globalInstance()), m_eOptimization(Optimization::eoNone), m_bDelta(false),
+    m_bFoldDuplicates(false), m_iQueued(0), m_iStored(0),
+    m_iMaxPending(2 * qMax(1, QThread::idealThreadCount())), m_iACTLOffset(0), m_iStreamFPS(0),
+    m_iStreamed(0), m_bStreaming(false)
+{
+  m_encoder.setThreadPool(QThreadPool::globalInstance());
+  m_quantizer.setThreadPool(QThreadPool::globalInstance());
+  m_semPending.release(m_iMaxPending);
+}
+
+Writer::~Writer()
+{
+  waitForPending();
+}
+
+void Writer::setDeltaFrames(bool bDelta)
+{
+  m_bDelta = bDelta;
+}
+
+void Writer::setOptimization(Optimization eOptimization)
+{
+  m_eOptimization = eOptimization;
+}
+
+void Writer::setFoldDuplicates(bool bFold)
+{
+  m_bFoldDuplicates = bFold;
+}
+
+void Writer::setEncoderOptions(const EncoderOptions& rOptions)
+{
+  // the frames being compressed keep the options they were appended with
+  waitForPending();
+  m_encoder.setOptions(rOptions);
+}
+
+void Writer::setThreadPool(QThreadPool* pPool)
+{
+  waitForPending();
+  m_runner.setThreadPool(pPool);
+  m_encoder.setThreadPool(pPool);
+  m_quantizer.setThreadPool(pPool);
+}
+
+bool Writer::setPalette(const QVector<QRgb>& rvColors)
+{
+  // the IHDR and PLTE chunks of the first frame would no longer match the next frames
+  waitForPending();
+  if (count() > 0)
+    return false;
+
+  m_vPalette = rvColors.mid(0, 256);
+  return true;
+}
+
+bool Writer::setReduction(const Reducer& rReducer)
+{
+  waitForPending();
+  if (count() > 0)
+    return false;
+
+  m_reducer = rReducer;
+  return true;
+}
+
+void Writer::setFrameCache(FrameCache* pCache)
+{
+  waitForPending();
+  m_pCache = pCache;
+}
+
+void Writer::setDeterministic(bool bDeterministic)
+{
+  m_bDeterministic = bDeterministic;
+}
+
+void Writer::setCreationTime(const QDateTime& rTime)
+{
+  m_creationTime = rTime;
+}
+
+void Writer::setSoftware(const QString& rqsSoftware)
+{
+  m_qsSoftware = rqsSoftware;
+}
+
+void Writer::setDigest(bool bDigest, QCryptographicHash::Algorithm eAlgorithm)
+{
+  m_bDigest = bDigest;
+  m_eDigest = eAlgorithm;
+}
+
+bool Writer::convertsFrames() const
+{
+  return (m_vPalette.isEmpty() == false) || (m_reducer.isNull() == false);
+}
+
+bool Writer::keepsTransparency() const
+{
+  auto vPalette = m_vPalette;
+  if ((vPalette.isEmpty() == true) && (m_reducer.isNull() == false)) {
+    if (m_reducer.colorType() != Header::ectPalette)
+      return m_reducer.colorType() == Header::ectRGBA;
+    vPalette = m_reducer.palette();
+  }
+
+  return (vPalette.isEmpty() == true) ||
+         std::any_of(vPalette.begin(), vPalette.end(), [](QRgb rgb) { return qAlpha(rgb) == 0; });
+}
+
+bool Writer::accepts(const QImage& rImg) const
+{
+  if (rImg.isNull() == true)
+    return false;
 
-void Writer::append(const QByteArray& rba)
+  // the frames share the format, so the frame, which it can not hold, is refused rather than lost
+  return (m_vPalette.isEmpty() == false) || (m_reducer.isNull() == true) ||
+         (m_reducer.holds(rImg) == true);
+}
+
+bool Writer::append(const QByteArray& rba)
+{
+  // the asynchronously appended frames come first
+  waitForPending();
+  if ((m_bDelta == true) || (convertsFrames() == true)) {
+    // the image has to be decoded to be compared with the previous one or to be converted
+    auto img = QImage::fromData(rba, "PNG");
+    return append(&img);
+  }
+
+  if (foldDuplicate(rba) == false)
+    appendPNG(rba);
+  return true;
+}
+
+void Writer::appendPNG(const QByteArray& rba)
 {
   bool bFirst = (m_vIDAT.count() == 0);
 
@@ -19,11 +235,14 @@ void Writer::append(const QByteArray& rba)
 
   auto optChunk = readChunk(rba, uiOffset);
   std::optional<Chunk> chunkFrame;
+  quint32 uiFrameCRC = 0U;
+  quint32 uiNameCRC  = m_crc.calculate(m_cbaIDAT);
 
   while (optChunk.has_value() == true) {
     auto chunk = optChunk.value();
     if ((bFirst == true) && (chunk.m_baName == m_cbaIHDR)) {
-      m_chunkIHDR = chunk;
+      m_chunkIHDR                = chunk;
+      m_controlIDAT.m_uiDelayNum = 1U;
       m_iW        = convert(m_chunkIHDR.m_baContent.mid(0, 4));
       m_iH        = convert(m_chunkIHDR.m_baContent.mid(4, 4));
     } else if (chunk.m_baName == m_cbaIDAT) {
@@ -37,6 +256,10 @@ void Writer::append(const QByteArray& rba)
           chunkFrame->m_baContent.append(chunk.m_baContent);
           chunkFrame->m_uiLength += chunk.m_uiLength;
         }
+        // the CRC of the data alone is derived from the verified chunk CRC by stripping the name
+        auto uiDataCRC =
+          convert(chunk.m_baCRC) ^ m_crc.combine(uiNameCRC, 0U, chunk.m_baContent.size());
+        uiFrameCRC = m_crc.combine(uiFrameCRC, uiDataCRC, chunk.m_baContent.size());
       }
     } else if ((bFirst == true) && (chunk.m_baName != m_cbaIEND)) {
       m_vOtherChunks << chunk;
@@ -45,55 +268,517 @@ void Writer::append(const QByteArray& rba)
     optChunk = readChunk(rba, uiOffset);
   }
 
-  if (chunkFrame.has_value() == true) {
-    m_vfDAT << chunkFrame.value();
+  if (chunkFrame.has_value() == true)
+    storeFrame(chunkFrame.value(), uiFrameCRC, QRect(), FrameControl::eboSource);
+
+  // the last frame is held back, since the next frame may still change its dispose operation
+  if (m_bStreaming == true)
+    writeStream(1);
+}
+
+bool Writer::appendEncoded(const EncodedImage& rImage, const QRect& rRect, quint8 uiBlend)
+{
+  if (rImage.isNull() == true)
+    return false;
+
+  Chunk chunk = makeChunk(m_cbaIDAT, rImage.m_baData);
+  // the compressed data is stored as a single chunk, so its CRC is derived from the one of the data
+  chunk.m_baCRC = convert(m_crc.combine(m_crc.calculate(m_cbaIDAT), rImage.m_uiDataCRC,
+                                        rImage.m_baData.size()));
+
+  if (m_vIDAT.count() == 0) {
+    m_chunkIHDR                = makeChunk(m_cbaIHDR, rImage.m_header.toBytes());
+    m_iW                       = int(rImage.m_header.m_uiWidth);
+    m_iH                       = int(rImage.m_header.m_uiHeight);
+    m_controlIDAT.m_uiDelayNum = 1U;
+    if (rImage.m_baPLTE.isEmpty() == false)
+      m_vOtherChunks << makeChunk(m_cbaPLTE, rImage.m_baPLTE);
+    if (rImage.m_baTRNS.isEmpty() == false)
+      m_vOtherChunks << makeChunk(m_cbaTRNS, rImage.m_baTRNS);
+
+    m_vIDAT << chunk;
+  } else {
+    chunk.m_baName = m_cbaFDAT;
+    storeFrame(chunk, rImage.m_uiDataCRC, rRect, uiBlend);
   }
+
+  if (m_bStreaming == true)
+    writeStream(1);
+  return true;
 }
 
-void Writer::append(QImage* pImg)
+void Writer::storeFrame(const Chunk& rFrame, quint32 uiFrameCRC, const QRect& rRect,
+                        quint8 uiBlend)
 {
-  QByteArray ba;
-  QBuffer buf(&ba);
-  buf.open(QIODevice::WriteOnly);
-  pImg->save(&buf, "PNG", 0);
+  FrameControl control;
+  control.m_uiWidth  = quint32(rRect.isNull() == true ? m_iW : rRect.width());
+  control.m_uiHeight = quint32(rRect.isNull() == true ? m_iH : rRect.height());
+  control.m_uiX      = quint32(rRect.isNull() == true ? 0 : rRect.x());
+  control.m_uiY      = quint32(rRect.isNull() == true ? 0 : rRect.y());
+  control.m_uiBlend  = uiBlend;
+  // the delay is only known at the export, so the numerator counts the frame periods until then
+  control.m_uiDelayNum = 1U;
+
+  m_vfDAT << rFrame;
+  m_vfDATCRC << uiFrameCRC;
+  m_vfDATControl << control;
+}
+
+Chunk Writer::makeChunk(const QByteArray& rbaName, const QByteArray& rbaContent) const
+{
+  Chunk chunk;
+  chunk.m_baName    = rbaName;
+  chunk.m_baContent = rbaContent;
+  chunk.m_uiLength  = quint32(rbaContent.size());
+  chunk.m_baCRC     = convert(crc(chunk));
+  return chunk;
+}
+
+bool Writer::foldDuplicate(const QImage& rImg)
+{
+  if ((m_bFoldDuplicates == false) || (rImg.isNull() == true))
+    return false;
+
+  if ((sameImage(m_imgLast, rImg) == true) && (repeatLast() == true))
+    return true;
+
+  m_imgLast = rImg;
+  m_baLast.clear();
+  return false;
+}
+
+bool Writer::foldDuplicate(const QByteArray& rba)
+{
+  if (m_bFoldDuplicates == false)
+    return false;
+
+  if ((m_baLast.isEmpty() == false) && (m_baLast == rba) && (repeatLast() == true))
+    return true;
+
+  m_baLast = rba;
+  m_imgLast = QImage();
+  return false;
+}
+
+bool Writer::repeatLast()
+{
+  QMutexLocker locker(&m_mutex);
+  if (m_iStored == m_iQueued)
+    return addPeriods(1);
+
+  // the frame is still being compressed, so the period is added by the storeEncoded method
+  int& riPeriods = m_mapPeriods[m_iQueued - 1];
+  if (riPeriods + 2 > 0xFFFF)
+    return false;
+
+  ++riPeriods;
+  return true;
+}
+
+bool Writer::addPeriods(int iPeriods)
+{
+  if (m_vIDAT.count() == 0)
+    return false;
+
+  auto& rControl = (m_vfDAT.count() == 0 ? m_controlIDAT : m_vfDATControl.last());
+  if (int(rControl.m_uiDelayNum) + iPeriods > 0xFFFF)
+    return false;
+
+  rControl.m_uiDelayNum = quint16(rControl.m_uiDelayNum + iPeriods);
+  return true;
+}
+
+bool Writer::appendDelta(const QImage& rImg)
+{
+  if (rImg.isNull() == true)
+    return false;
+
+  // with a palette, the frames are compared the way they are stored, after the quantization
+  auto imgIn = (m_vPalette.isEmpty() == true ? rImg : m_quantizer.quantize(rImg, m_vPalette));
+
+  // all the frames share the IHDR chunk of the first one, so they are all saved in its format
+  auto eFormat = (imgIn.depth() == 64 ? QImage::Format_RGBA64 : QImage::Format_ARGB32);
+  if (count() > 0)
+    eFormat = m_imgPrevious.format();
+  auto img = imgIn.convertToFormat(eFormat);
+  // the canvas keeps the size of the first frame, so a frame of another size has no delta to it
+  if ((count() > 0) && (img.size() != m_imgPrevious.size()))
+    return false;
+
+  // the first frame is the default image, which always covers the whole animation
+  if (count() == 0) {
+    if (appendEncoded(compress(img)) == false)
+      return false;
+
+    m_imgBackground = QImage();
+    m_imgPrevious   = img;
+    m_rectPrevious  = img.rect();
+    return true;
+  }
+
+  // the candidates are listed from the simplest one, which wins when the sizes are the same
+  QVector<quint8> vuiDispose = {FrameControl::edoNone};
+  if (m_eOptimization == Optimization::eoSize) {
+    vuiDispose << FrameControl::edoBackground;
+    // there is nothing to go back to before the first frame, so PREVIOUS is the same as BACKGROUND
+    if ((count() > 1) && (m_imgBackground.isNull() == false))
+      vuiDispose << FrameControl::edoPrevious;
+  }
+
+  QVector<Candidate> vCandidates;
+  for (auto uiDispose : vuiDispose) {
+    vCandidates << Candidate(uiDispose, FrameControl::eboSource);
+    if (m_eOptimization != Optimization::eoNone)
+      vCandidates << Candidate(uiDispose, FrameControl::eboOver);
+  }
+
+  m_runner.run(vCandidates.count(), [&](int i) { evaluate(vCandidates[i], img); });
+
+  int iBest = 0;
+  for (int i = 1; i < vCandidates.count(); ++i) {
+    if ((vCandidates[i].m_bValid == true) &&
+        (vCandidates[i].m_encoded.m_baData.size() <
+         vCandidates[iBest].m_encoded.m_baData.size()))
+      iBest = i;
+  }
+
+  // the dispose operation of the previous frame is only decided, once the next frame is known
+  const auto& rBest = vCandidates[iBest];
+  if (rBest.m_bValid == false)
+    return false;
+
+  if (count() == 1)
+    m_controlIDAT.m_uiDispose = rBest.m_uiDispose;
+  else
+    m_vfDATControl.last().m_uiDispose = rBest.m_uiDispose;
+
+  if ((m_pCache != nullptr) && (rBest.m_bCached == false))
+    m_pCache->insert(rBest.m_baKey, rBest.m_encoded);
+
+  appendEncoded(rBest.m_encoded, rBest.m_rect, rBest.m_uiBlend);
+  m_imgBackground = rBest.m_imgCanvas;
+  m_imgPrevious   = img;
+  m_rectPrevious  = rBest.m_rect;
+  return true;
+}
+
+QRect Writer::changedRect(const QImage& rPrevious, const QImage& rImg) const
+{
+  const int iPixel    = rImg.depth() / 8;
+  const size_t uiRow  = size_t(rImg.width()) * iPixel;
+  auto rowsDiffer     = [&](int iY) {
+    return std::memcmp(rPrevious.constScanLine(iY), rImg.constScanLine(iY), uiRow) != 0;
+  };
+
+  int iTop = 0;
+  while ((iTop < rImg.height()) && (rowsDiffer(iTop) == false))
+    ++iTop;
+  if (iTop == rImg.height())
+    return {};
+
+  int iBottom = rImg.height() - 1;
+  while (rowsDiffer(iBottom) == false)
+    --iBottom;
+
+  // every row only has to be scanned up to the columns, which are already known to differ
+  int iLeft  = rImg.width() - 1;
+  int iRight = 0;
+  for (int iY = iTop; iY <= iBottom; ++iY) {
+    const uchar* pPrevious = rPrevious.constScanLine(iY);
+    const uchar* pImg      = rImg.constScanLine(iY);
+    int iX                 = 0;
+    while ((iX < iLeft) && (std::memcmp(pPrevious + iX * iPixel, pImg + iX * iPixel, iPixel) == 0))
+      ++iX;
+    iLeft = iX;
+
+    iX = rImg.width() - 1;
+    while ((iX > iRight) && (std::memcmp(pPrevious + iX * iPixel, pImg + iX * iPixel, iPixel) == 0))
+      --iX;
+    iRight = iX;
+  }
+
+  return QRect(QPoint(iLeft, iTop), QPoint(qMax(iLeft, iRight), iBottom));
+}
+
+QImage Writer::disposed(quint8 uiDispose) const
+{
+  auto img = m_imgPrevious;
+  if (uiDispose == FrameControl::edoBackground)
+    Blend::clear(img, m_rectPrevious);
+  else if (uiDispose == FrameControl::edoPrevious)
+    Blend::copy(m_imgBackground, img, m_rectPrevious);
+
+  return img;
+}
+
+void Writer::evaluate(Candidate& rCandidate, const QImage& rImg) const
+{
+  rCandidate.m_imgCanvas = disposed(rCandidate.m_uiDispose);
+  rCandidate.m_rect      = changedRect(rCandidate.m_imgCanvas, rImg);
+  // every frame covers at least one pixel, even if nothing changed
+  if (rCandidate.m_rect.isEmpty() == true)
+    rCandidate.m_rect = QRect(0, 0, 1, 1);
+
+  auto img = rImg.copy(rCandidate.m_rect);
+  if (rCandidate.m_uiBlend == FrameControl::eboOver) {
+    bool bExact = (img.depth() == 64 ? clearUnchanged<QRgba64>(rCandidate.m_imgCanvas, img,
+                                                                rCandidate.m_rect, 65535U)
+                                     : clearUnchanged<QRgb>(rCandidate.m_imgCanvas, img,
+                                                            rCandidate.m_rect, 255U));
+    if (bExact == false)
+      return;
+
+    // the unchanged pixels only stay transparent, if the stored format can hold them
+    if (keepsTransparency() == false)
+      return;
+  }
+
+  // only the chosen candidate is added to the frame cache, the others would evict the used frames
+  if (m_pCache != nullptr) {
+    rCandidate.m_baKey = FrameCache::key(img, cacheSettings());
+    if (m_pCache->contains(rCandidate.m_baKey) == true) {
+      auto optImage = m_pCache->find(rCandidate.m_baKey);
+      if (optImage.has_value() == true) {
+        rCandidate.m_encoded = optImage.value();
+        rCandidate.m_bCached = true;
+      }
+    }
+  }
+
+  if (rCandidate.m_bCached == false)
+    rCandidate.m_encoded = encode(img);
+  rCandidate.m_bValid = (rCandidate.m_encoded.isNull() == false);
+}
+
+bool Writer::append(QImage* pImg)
+{
+  waitForPending();
+  // the refused image is not kept for the comparison with the next one
+  if (accepts(*pImg) == false)
+    return false;
+  if (foldDuplicate(*pImg) == true)
+    return true;
+
+  if (m_bDelta == true)
+    return appendDelta(*pImg);
+
+  return appendEncoded(compress(*pImg));
+}
+
+bool Writer::append(const QVector<QImage>& rvImages)
+{
+  waitForPending();
+  // the format is shared by all the frames, so it can only be chosen before the first one, and
+  // the format set by the setReduction method is kept
+  if ((count() == 0) && (m_vPalette.isEmpty() == true) && (m_reducer.isNull() == true)) {
+    for (const auto& rImg : rvImages)
+      m_reducer.add(rImg);
+  }
+
+  bool bOk = true;
+  for (auto img : rvImages) {
+    if (append(&img) == false)
+      bOk = false;
+  }
+
+  return bOk;
+}
+
+bool Writer::append(QPixmap* pPix)
+{
+  auto img = pPix->toImage();
+  return append(&img);
+}
+
+bool Writer::append(const uchar* pBits, int iWidth, int iHeight, qsizetype iStride,
+                    QImage::Format eFormat, const QVector<QRgb>& rvColors)
+{
+  waitForPending();
+  // the image only wraps the buffer, its pixels are not copied
+  QImage img(pBits, iWidth, iHeight, iStride, eFormat);
+  img.setColorTable(rvColors);
+  if (accepts(img) == false)
+    return false;
+
+  if (m_bFoldDuplicates == true) {
+    if (foldDuplicate(img) == true)
+      return true;
+
+    // the buffer is the caller's, so a copy is kept for the comparison with the next frame
+    m_imgLast = img.copy();
+  }
+
+  // the delta mode keeps the previous frame, so the caller's buffer has to be copied
+  if (m_bDelta == true)
+    return appendDelta(img.copy());
+
+  // the key of the frame cache is calculated from the image, which wraps the buffer
+  if ((convertsFrames() == true) || (m_pCache != nullptr))
+    return appendEncoded(compress(img));
 
-  buf.close();
+  return appendEncoded(m_encoder.compress(pBits, iWidth, iHeight, iStride, eFormat, rvColors));
+}
+
+EncodedImage Writer::compress(const QImage& rImg) const
+{
+  if (m_pCache == nullptr)
+    return encode(rImg);
 
-  append(ba);
+  auto baKey    = FrameCache::key(rImg, cacheSettings());
+  auto optImage = m_pCache->find(baKey);
+  if (optImage.has_value() == true)
+    return optImage.value();
+
+  auto image = encode(rImg);
+  m_pCache->insert(baKey, image);
+  return image;
 }
 
-void Writer::append(QPixmap* pPix)
+EncodedImage Writer::encode(const QImage& rImg) const
+{
+  // the palette indices take the least bits, which address all the entries
+  if (m_vPalette.isEmpty() == false)
+    return m_encoder.compress(m_quantizer.quantize(rImg, m_vPalette),
+                              Reducer::indexBits(m_vPalette.count()));
+  if (m_reducer.isNull() == true)
+    return m_encoder.compress(rImg);
+
+  // the quantizer maps the pixels to the reduced palette on the thread pool
+  if (m_reducer.colorType() == Header::ectPalette)
+    return m_encoder.compress(m_quantizer.quantize(rImg, m_reducer.palette()),
+                              m_reducer.bitDepth());
+  return m_encoder.compress(m_reducer.reduce(rImg), m_reducer.bitDepth());
+}
+
+QByteArray Writer::cacheSettings() const
 {
   QByteArray ba;
-  QBuffer buf(&ba);
-  buf.open(QIODevice::WriteOnly);
-  pPix->save(&buf, "PNG", 0);
-  buf.close();
+  auto add = [&ba](quint32 ui) {
+    ui = qToBigEndian(ui);
+    ba.append(reinterpret_cast<const char*>(&ui), int(sizeof(ui)));
+  };
+
+  const auto& rOptions = m_encoder.options();
+  add(quint32(rOptions.m_iLevel));
+  add(quint32(rOptions.m_eStrategy));
+  add(quint32(rOptions.m_eFilterMode));
+  add(rOptions.m_uiFilter);
+  add(quint32(rOptions.m_iBlockSize));
+  add(quint32(Compression().backend()));
+
+  // the palette takes precedence over the reduction, as in the encode method
+  add(quint32(m_vPalette.count()));
+  for (auto rgb : m_vPalette)
+    add(rgb);
+  if (m_vPalette.isEmpty() == true) {
+    auto vReduced = m_reducer.palette();
+    add(m_reducer.colorType());
+    add(m_reducer.bitDepth());
+    add(quint32(vReduced.count()));
+    for (auto rgb : vReduced)
+      add(rgb);
+  }
 
-  append(ba);
+  return ba;
 }
 
-void Writer::append(const QString& rqsFile)
+bool Writer::append(const QString& rqsFile)
 {
   QFile f(rqsFile);
   if (f.open(QFile::ReadOnly) == false)
-    return;
+    return false;
 
   auto ba = f.readAll();
   f.close();
 
-  append(ba);
+  return append(ba);
+}
+
+bool Writer::appendAsync(const QImage& rImg)
+{
+  if ((m_bDelta == true) || (threadPool() == nullptr)) {
+    auto img = rImg;
+    return append(&img);
+  }
+
+  // the format is checked right away, so that the caller learns about the refused frame
+  if (accepts(rImg) == false)
+    return false;
+  if (foldDuplicate(rImg) == true)
+    return true;
+
+  // the caller waits here, while the maximal number of frames is being compressed
+  m_semPending.acquire();
+  QMutexLocker locker(&m_mutex);
+  int iIndex = m_iQueued++;
+  locker.unlock();
+
+  threadPool()->start(QRunnable::create([this, rImg, iIndex]() {
+    auto image = compress(rImg);
+
+    QMutexLocker locker(&m_mutex);
+    m_mapEncoded.insert(iIndex, image);
+    storeEncoded();
+  }));
+  return true;
+}
+
+bool Writer::appendAsync(const QPixmap& rPix)
+{
+  // pixmaps can only be used on the calling thread, so the image is taken out of it right away
+  return appendAsync(rPix.toImage());
+}
+
+void Writer::storeEncoded()
+{
+  // a frame can only be stored after all the frames appended before it
+  while (m_mapEncoded.contains(m_iStored) == true) {
+    appendEncoded(m_mapEncoded.take(m_iStored));
+    addPeriods(m_mapPeriods.take(m_iStored));
+    ++m_iStored;
+    m_semPending.release();
+  }
+
+  m_condStored.wakeAll();
+}
+
+void Writer::waitForPending()
+{
+  QMutexLocker locker(&m_mutex);
+  while (m_iStored < m_iQueued)
+    m_condStored.wait(&m_mutex);
+}
+
+void Writer::setMaxPending(int iCount)
+{
+  waitForPending();
+  iCount = qMax(1, iCount);
+  m_semPending.acquire(m_iMaxPending);
+  m_semPending.release(iCount);
+  m_iMaxPending = iCount;
 }
 
 bool Writer::exportAPNG(const QString& rqsFile, int iFPS)
 {
+  waitForPending();
+  // the data of the streamed frames is not kept
+  if (m_iStreamed > 0)
+    return false;
+
+  // the digest is calculated from the data as it is written, the file is not read back
+  m_baDigest.clear();
+  if (m_bDigest == true)
+    m_pHash.reset(new QCryptographicHash(m_eDigest));
+
   QFile f(rqsFile);
-  if (writeSignature(f) == false)
+  if (writeSignature(f) == false) {
+    m_pHash.reset();
     return false;
+  }
 
   writeIHDR(f);
   for (const auto& rOther : m_vOtherChunks)
-    writeChunk(f, rOther);
+    write(f, rOther);
 
   writeText(f);
   writeACTL(f);
@@ -105,20 +790,103 @@ bool Writer::exportAPNG(const QString& rqsFile, int iFPS)
   }
 
   writeIEnd(f);
+  // the buffered data is only written, when the file is closed
+  bool bOk = (m_bWriteFailed == false) && (f.error() == QFileDevice::NoError);
+  if ((m_pHash != nullptr) && (bOk == true))
+    m_baDigest = m_pHash->result();
+  m_pHash.reset();
+  return bOk;
+}
 
+bool Writer::begin(const QString& rqsFile, int iFPS)
+{
+  reset();
+  m_baDigest.clear();
+  m_fileStream.setFileName(rqsFile);
+  if (writeSignature(m_fileStream) == false)
+    return false;
+
+  m_iStreamFPS = iFPS;
+  m_bStreaming = true;
   return true;
 }
 
+bool Writer::finish()
+{
+  if (m_bStreaming == false)
+    return false;
+
+  waitForPending();
+  writeStream(0);
+  m_bStreaming = false;
+  if (m_iStreamed == 0) {
+    m_fileStream.close();
+    return false;
+  }
+
+  write(m_fileStream, iend());
+  // the acTL chunk has the same size, regardless of the number of frames
+  bool bOk = m_fileStream.seek(m_iACTLOffset);
+  if (bOk == true)
+    writeACTL(m_fileStream);
+  m_fileStream.close();
+  return (bOk == true) && (m_bWriteFailed == false) &&
+         (m_fileStream.error() == QFileDevice::NoError);
+}
+
+void Writer::writeStream(int iKeep)
+{
+  int iStored = (m_vIDAT.count() > 0 ? 1 : 0) + m_vfDAT.count();
+  for (; m_iStreamed < iStored - iKeep; ++m_iStreamed) {
+    if (m_iStreamed == 0) {
+      writeIHDR(m_fileStream);
+      for (const auto& rOther : m_vOtherChunks)
+        write(m_fileStream, rOther);
+
+      writeText(m_fileStream);
+      // the number of frames is not known yet, so the acTL chunk is rewritten by the finish method
+      m_iACTLOffset = m_fileStream.pos();
+      writeACTL(m_fileStream);
+      writeFCTL(m_fileStream, -1, m_iStreamFPS);
+      writeIDAT(m_fileStream);
+      for (auto& rIDAT : m_vIDAT)
+        rIDAT.m_baContent = QByteArray();
+    } else {
+      int i = m_iStreamed - 1;
+      writeFCTL(m_fileStream, i, m_iStreamFPS);
+      writeFDAT(m_fileStream, i);
+      m_vfDAT[i].m_baContent = QByteArray();
+    }
+  }
+}
+
 void Writer::reset()
 {
+  waitForPending();
+  // an unfinished stream is abandoned
+  if (m_bStreaming == true)
+    m_fileStream.close();
+  m_bStreaming = false;
+  m_iStreamed  = 0;
   Base::reset();
   m_vIDAT.clear();
   m_vfDAT.clear();
+  m_vfDATCRC.clear();
+  m_vfDATControl.clear();
+  m_mapPeriods.clear();
+  m_controlIDAT   = FrameControl();
+  m_imgPrevious   = QImage();
+  m_imgBackground = QImage();
+  m_imgLast       = QImage();
+  m_baLast.clear();
+  // the format was chosen for the frames of this animation
+  m_reducer.clear();
 }
 
 int Writer::count() const
 {
-  return (m_vIDAT.count() > 0 ? 1 : 0) + m_vfDAT.count();
+  QMutexLocker locker(&m_mutex);
+  return (m_vIDAT.count() > 0 ? 1 : 0) + m_vfDAT.count() + m_iQueued - m_iStored;
 }
 
 bool Writer::writeSignature(QFile& rF) const
@@ -126,64 +894,104 @@ bool Writer::writeSignature(QFile& rF) const
   if (rF.open(QFile::WriteOnly) == false)
     return false;
 
-  rF.write(m_cbaSig);
+  m_bWriteFailed = false;
+  write(rF, m_cbaSig);
   return true;
 }
 
 void Writer::writeIHDR(QFile& rF) const
 {
-  writeChunk(rF, m_chunkIHDR);
+  write(rF, m_chunkIHDR);
 }
 
 void Writer::writeText(QFile& rF) const
 {
   Chunk chunk;
+  chunk.m_baName = m_cbaTEXT;
+
+  // the deterministic files only carry the time, which was set explicitly
+  auto time = m_creationTime;
+  if ((time.isValid() == false) && (m_bDeterministic == false))
+    time = QDateTime::currentDateTime();
+  if (time.isValid() == true) {
+    chunk.m_baContent =
+    prepareText("Creation time", QLocale::c().toString(time, "ddd, dd MM yyyy HH:mm:ss"));
+    chunk.m_uiLength = chunk.m_baContent.size();
+    chunk.m_baCRC    = convert(crc(chunk));
+    write(rF, chunk);
+  }
 
-  chunk.m_baContent =
-  prepareText("Creation time", QDateTime::currentDateTime().toString("ddd, dd MM yyyy HH:mm:ss"));
-  chunk.m_baName   = m_cbaTEXT;
-  chunk.m_uiLength = chunk.m_baContent.size();
-  chunk.m_baCRC    = convert(crc(chunk));
-  writeChunk(rF, chunk);
-
-  chunk.m_baContent = prepareText("Software", "libapng v1.0");
-  chunk.m_baName    = m_cbaTEXT;
-  chunk.m_uiLength  = chunk.m_baContent.size();
-  chunk.m_baCRC     = convert(crc(chunk));
-  writeChunk(rF, chunk);
+  if (m_qsSoftware.isEmpty() == false) {
+    chunk.m_baContent = prepareText("Software", m_qsSoftware);
+    chunk.m_uiLength  = chunk.m_baContent.size();
+    chunk.m_baCRC     = convert(crc(chunk));
+    write(rF, chunk);
+  }
 }
 
 void Writer::writeACTL(QFile& rF) const
 {
-  writeChunk(rF, actl(1 + m_vfDAT.count(), 0));
+  write(rF, actl(1 + m_vfDAT.count(), 0));
 }
 
 void Writer::writeFCTL(QFile& rF, int i, int iFPS) const
 {
-  writeChunk(rF, fctl(i, m_iW, m_iH, iFPS, 0, 0));
+  if (i < 0) {
+    write(rF, fctl(i, m_iW, m_iH, iFPS, 0, 0, m_controlIDAT.m_uiDispose,
+                   FrameControl::eboSource, m_controlIDAT.m_uiDelayNum));
+    return;
+  }
+
+  const auto& rControl = m_vfDATControl[i];
+  write(rF, fctl(i, int(rControl.m_uiWidth), int(rControl.m_uiHeight), iFPS,
+                 int(rControl.m_uiX), int(rControl.m_uiY), rControl.m_uiDispose,
+                 rControl.m_uiBlend, rControl.m_uiDelayNum));
 }
 
 void Writer::writeIDAT(QFile& rF) const
 {
   for (const auto& rIDAT : m_vIDAT) {
-    writeChunk(rF, rIDAT);
+    write(rF, rIDAT);
   }
 }
 
 void Writer::writeFDAT(QFile& rF, int i) const
 {
-  Chunk chunk = m_vfDAT[i];
-  chunk.m_baContent.prepend(convert(2 * i + 2));
-  chunk.m_uiLength += 4;
-  writeChunk(rF, chunk, true);
+  const auto& rFrame = m_vfDAT[i];
+  auto baSequence    = convert(2 * i + 2);
+
+  // only the name and the sequence number are scanned, the frame data CRC is already known
+  auto uiCRC = m_crc.update(m_crc.calculate(m_cbaFDAT), baSequence);
+  uiCRC      = m_crc.combine(uiCRC, m_vfDATCRC[i], rFrame.m_baContent.size());
+
+  write(rF, convert(rFrame.m_uiLength + 4));
+  write(rF, m_cbaFDAT);
+  write(rF, baSequence);
+  write(rF, rFrame.m_baContent);
+  write(rF, convert(uiCRC));
 }
 
 void Writer::writeIEnd(QFile& rF) const
 {
-  writeChunk(rF, iend());
+  write(rF, iend());
   rF.close();
 }
 
+void Writer::write(QFile& rF, const QByteArray& rba) const
+{
+  if (rF.write(rba) != rba.size())
+    m_bWriteFailed = true;
+  if (m_pHash != nullptr)
+    m_pHash->addData(rba);
+}
+
+void Writer::write(QFile& rF, const Chunk& rChunk) const
+{
+  QByteArray ba;
+  writeChunk(ba, rChunk);
+  write(rF, ba);
+}
+
 QByteArray Writer::prepareText(const QString& rqsKey, const QString& rqsValue) const
 {
   auto ba           = rqsKey.toLatin1();
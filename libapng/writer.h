@@ -1,12 +1,28 @@
 #pragma once
 
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QRect>
+#include <QSemaphore>
 #include <QVector>
+#include <QWaitCondition>
+
+#include <memory>
 
 #include "base.h"
+#include "encoder.h"
+#include "framecache.h"
+#include "framecontrol.h"
+#include "quantizer.h"
+#include "reducer.h"
+#include "taskrunner.h"
 
-class QImage;
 class QPixmap;
-class QFile;
+class QThreadPool;
 
 namespace png {
 
@@ -15,54 +31,492 @@ namespace png {
  * animation. Typical usage of this class consists of several append calls, with which
  * the individual frames are stored in the object's internal container, and one final exportAPNG
  * call, which effectively creates the animated PNG from the stored frames and stores it in a file.
+ * Alternatively, the animation can be streamed: after the begin call, every appended frame is
+ * written to the file as soon as it is final, and the finish call completes the file.
  */
 class __declspec(dllexport) Writer : public Base
 {
 public:
+  /**
+   * @brief The Optimization enum Denotes how hard the delta frames are optimized for size
+   */
+  enum class Optimization {
+    eoNone,  ///< the frame is cropped to the changed region and blended by the SOURCE operation
+    eoSpeed, ///< the SOURCE and the OVER blend operations are tried for the cropped frame
+    eoSize   ///< additionally, every dispose operation of the previous frame is tried
+  };
+
   /**
    * @brief Writer Default constructor
    */
   Writer();
+  /**
+   * @brief ~Writer Destructor. Waits for the frames, which are still being compressed
+   */
+  ~Writer();
 
+  /**
+   * @brief setDeltaFrames Sets, whether the appended frames are stored as deltas. In the delta
+   * mode, every appended frame is compared to the previous one and only the bounding box of the
+   * changed pixels is stored, at its offset within the animation. The frames are converted into
+   * QImage::Format_ARGB32, or QImage::Format_RGBA64 if the first frame has 16-bit channels. The
+   * frames, whose size differs from the first one, are skipped. The mode should be set before the
+   * first frame is appended
+   * @param bDelta true to store the frames as deltas and false to store them whole
+   */
+  void setDeltaFrames(bool bDelta);
+  /**
+   * @brief deltaFrames Returns, whether the appended frames are stored as deltas
+   * @return true, if the appended frames are stored as deltas and false otherwise
+   */
+  bool deltaFrames() const { return m_bDelta; }
+  /**
+   * @brief setOptimization Sets how hard the delta frames are optimized. Every candidate
+   * combination of the dispose operation of the previous frame, the blend operation and the region
+   * of the frame is compressed on trial and the smallest one is kept. Has no effect, unless the
+   * delta mode is on
+   * @param eOptimization New optimization preset
+   */
+  void setOptimization(Optimization eOptimization);
+  /**
+   * @brief optimization Returns how hard the delta frames are optimized
+   * @return Current optimization preset
+   */
+  Optimization optimization() const { return m_eOptimization; }
+  /**
+   * @brief setFoldDuplicates Sets, whether the appended frames, which are the same as the frame
+   * appended right before them, are folded into it. Instead of being compressed and stored again,
+   * a duplicate frame only makes the previous one last for one more frame period, which saves a lot
+   * of time and space on screen recordings. The frames are compared byte by byte, in the format
+   * they were appended in, so only the exact duplicates are folded
+   * @param bFold true to fold the duplicate frames and false to store every frame
+   */
+  void setFoldDuplicates(bool bFold);
+  /**
+   * @brief foldDuplicates Returns, whether the duplicate frames are folded into the previous frame
+   * @return true, if the duplicate frames are folded and false otherwise
+   */
+  bool foldDuplicates() const { return m_bFoldDuplicates; }
+  /**
+   * @brief setPalette Sets the palette, which all the appended images are quantized to and stored
+   * with as indexed color frames, which are several times smaller than the truecolor ones. APNG
+   * only allows one PLTE chunk, so the palette is shared by all the frames. It can be built from
+   * all the frames beforehand by the Quantizer class. The palette can only be set before the first
+   * frame is appended, since all the frames are stored in the format of the first one. The frames
+   * appended as PNG data are decoded and quantized as well
+   * @param rvColors Reference to the palette with at most 256 entries. If empty, the images are
+   * stored in truecolor
+   * @return true on success and false, if some frames are already appended
+   */
+  bool setPalette(const QVector<QRgb>& rvColors);
+  /**
+   * @brief palette Returns the palette, which the appended images are quantized to
+   * @return Palette or an empty vector, if the images are stored in truecolor
+   */
+  const QVector<QRgb>& palette() const { return m_vPalette; }
+  /**
+   * @brief setReduction Sets the smallest lossless format, in which all the appended images are
+   * stored, as found by the analysis of all the frames beforehand. It can drop the alpha channel,
+   * store the images as grayscale or with a palette and lower their bit depth, which also makes
+   * them faster to decode. The images, which the format can not hold without any loss, are not
+   * appended. The format can only be set before the first frame is appended, it is dropped by the
+   * reset method and has no effect while a palette is set by the setPalette method
+   * @param rReducer Reference to the reducer, which analyzed all the frames. If it analyzed none,
+   * the images are stored in their own format
+   * @return true on success and false, if some frames are already appended
+   */
+  bool setReduction(const Reducer& rReducer);
+  /**
+   * @brief reduction Returns the reducer, whose format the appended images are stored in
+   * @return Reducer, which is null if the images are stored in their own format
+   */
+  const Reducer& reduction() const { return m_reducer; }
+  /**
+   * @brief setFrameCache Sets the cache of the compressed frames, which the writer looks the
+   * appended images up in, before it compresses them, and adds the newly compressed ones to. The
+   * frames shared by several exports, even by several processes with a disk cache, are then only
+   * compressed once. The frames appended as PNG data are not cached. Of the ways, in which a delta
+   * frame can be stored, only the chosen one is added to the cache, and the others, which are not
+   * in it, are compressed without counting as misses
+   * @param pCache Pointer to the cache, which has to outlive the writer, e.g.
+   * FrameCache::globalInstance(). If nullptr, every image is compressed
+   */
+  void setFrameCache(FrameCache* pCache);
+  /**
+   * @brief frameCache Returns the cache of the compressed frames
+   * @return Pointer to the cache or nullptr, if no cache is used
+   */
+  FrameCache* frameCache() const { return m_pCache; }
+  /**
+   * @brief setDeterministic Makes the exported file depend only on the appended frames, the
+   * settings and the build of the library, so that the same input always gives the same bytes, e.g.
+   * for content addressed storage. The creation time is then only written, if it is set by the
+   * setCreationTime method. The compressed data also depends on the deflate backend and its version
+   * (see Compression::backend), so the builds with another backend give other bytes and digests for
+   * the same input and the files to be shared between machines have to be written by the same build
+   * @param bDeterministic true to omit the current time and false to write it
+   */
+  void setDeterministic(bool bDeterministic);
+  /**
+   * @brief deterministic Indicates, whether the exported file only depends on its input
+   * @return true, if the current time is omitted and false otherwise
+   */
+  bool deterministic() const { return m_bDeterministic; }
+  /**
+   * @brief setCreationTime Sets the time, which is written into the "Creation time" text chunk
+   * @param rTime Reference to the creation time. If invalid, the current time is written, unless
+   * the export is deterministic
+   */
+  void setCreationTime(const QDateTime& rTime);
+  /**
+   * @brief creationTime Returns the time, which is written into the "Creation time" text chunk
+   * @return Creation time, which is invalid if the current time is written
+   */
+  const QDateTime& creationTime() const { return m_creationTime; }
+  /**
+   * @brief setSoftware Sets the text of the "Software" text chunk
+   * @param rqsSoftware Reference to the Latin-1 text. If empty, the chunk is omitted
+   */
+  void setSoftware(const QString& rqsSoftware);
+  /**
+   * @brief software Returns the text of the "Software" text chunk
+   * @return Text of the chunk or an empty string, if the chunk is omitted
+   */
+  const QString& software() const { return m_qsSoftware; }
+  /**
+   * @brief setDigest Enables the digest of the files exported by the exportAPNG method. It is
+   * calculated from the data, while it is written, so the file is not read back. The streamed
+   * files are not digested, since their acTL chunk is rewritten at the end
+   * @param bDigest true to calculate the digest and false otherwise
+   * @param eAlgorithm Hash algorithm of the digest. BLAKE2b is faster than SHA-2 in software
+   */
+  void setDigest(bool bDigest,
+                 QCryptographicHash::Algorithm eAlgorithm = QCryptographicHash::Blake2b_256);
+  /**
+   * @brief digest Returns the digest of the file last exported by the exportAPNG method
+   * @return Digest or an empty array, if it is disabled or no file was exported
+   */
+  const QByteArray& digest() const { return m_baDigest; }
+  /**
+   * @brief setEncoderOptions Sets the zlib level and strategy and the scanline filters, with which
+   * the appended images are compressed. The options apply to the frames appended from now on, so
+   * they can differ between the exports made by the same object. The frames appended as PNG data
+   * are stored as they are. By default, the archive preset is used
+   * @param rOptions Reference to the encoding options, e.g. one of the EncoderOptions presets
+   */
+  void setEncoderOptions(const EncoderOptions& rOptions);
+  /**
+   * @brief encoderOptions Returns the options, with which the appended images are compressed
+   * @return Encoding options
+   */
+  const EncoderOptions& encoderOptions() const { return m_encoder.options(); }
+  /**
+   * @brief setThreadPool Sets the thread pool, which compresses the candidates of one frame and
+   * the blocks of one large frame (see EncoderOptions::m_iBlockSize) and quantizes the rows of one
+   * frame in parallel. By default, the global thread pool is used
+   * @param pPool Pointer to the thread pool. If nullptr, the candidates and the blocks are
+   * compressed one after another on the calling thread
+   */
+  void setThreadPool(QThreadPool* pPool);
+  /**
+   * @brief threadPool Returns the thread pool, which compresses the candidates
+   * @return Pointer to the thread pool or nullptr, if the candidates are compressed on the calling
+   * thread
+   */
+  QThreadPool* threadPool() const { return m_runner.threadPool(); }
   /**
    * @brief append Adds the image, stored in the byte array, to include in the animation
    * @param rba Reference to the byte array, containing the image data. Image data should contain a valid PNG image
+   * @return true, if the image was appended and false, if it was refused
    */
-  void append(const QByteArray& rba);
+  bool append(const QByteArray& rba);
   /**
-   * @brief append Adds an image to include in the animation
+   * @brief append Adds an image to include in the animation. The image is refused, if it is null,
+   * could not be compressed, does not fit the reduced format shared by the frames or, in the delta
+   * mode, differs in size from the first frame
    * @param pImg Pointer to the image to include
+   * @return true, if the image was appended or folded into the previous frame and false, if it was
+   * refused
    */
-  void append(QImage* pImg);
+  bool append(QImage* pImg);
+  /**
+   * @brief append Adds the images to include in the animation. If no frame was appended yet and
+   * neither a palette nor a reduced format is set, all the images are analyzed first, in one pass,
+   * and stored in the smallest lossless format they share. The frames appended later share it as
+   * well, until the reset method is called, and the ones it can not hold are refused
+   * @param rvImages Reference to the images to include
+   * @return true, if all the images were appended and false, if any of them was refused
+   */
+  bool append(const QVector<QImage>& rvImages);
   /**
    * @brief append Adds a pixmap to include in the animation
    * @param pPix Pointer to the pixmap to include
+   * @return true, if the pixmap was appended and false, if it was refused
+   */
+  bool append(QPixmap* pPix);
+  /**
+   * @brief append Adds an image, given by the raw pixels in the caller's buffer, to include in the
+   * animation. The pixels are filtered and compressed straight from the buffer, unless its format
+   * has to be converted first, and the buffer is not used after this method returns
+   * @param pBits Pointer to the first pixel of the first row
+   * @param iWidth Image width in [pixels]
+   * @param iHeight Image height in [pixels]
+   * @param iStride Distance between the starts of two adjacent rows in [bytes]
+   * @param eFormat Pixel format of the buffer
+   * @param rvColors Reference to the color table of the QImage::Format_Indexed8 buffers
+   * @return true, if the image was appended and false, if it was refused
    */
-  void append(QPixmap* pPix);
+  bool append(const uchar* pBits, int iWidth, int iHeight, qsizetype iStride,
+              QImage::Format eFormat, const QVector<QRgb>& rvColors = QVector<QRgb>());
   /**
    * @brief append Adds an image, read from the given file, to include in the animation
    * @param rqsFile Path to a file to include
+   * @return true, if the image was appended and false, if the file could not be read or the image
+   * was refused
+   */
+  bool append(const QString& rqsFile);
+  /**
+   * @brief appendAsync Adds an image to include in the animation and returns right away, while the
+   * image is compressed on the thread pool. The frames are stored in the order, in which they were
+   * appended, regardless of the order, in which their compression finishes. If the maximal number
+   * of frames is already being compressed, this method waits for one of them to finish. In the
+   * delta mode or without a thread pool, the image is appended synchronously instead, since every
+   * delta frame depends on the previous one
+   * @param rImg Reference to the image to include. The image is shared, not copied
+   * @return true, if the image was queued and false, if it was refused. The image, which can not
+   * be compressed, is only dropped later, once its compression fails
+   */
+  bool appendAsync(const QImage& rImg);
+  /**
+   * @brief appendAsync Adds a pixmap to include in the animation and returns right away, while the
+   * pixmap is compressed on the thread pool
+   * @param rPix Reference to the pixmap to include
+   * @return true, if the pixmap was queued and false, if it was refused
    */
-  void append(const QString& rqsFile);
+  bool appendAsync(const QPixmap& rPix);
+  /**
+   * @brief waitForPending Waits, until all the asynchronously appended frames are stored. All the
+   * other methods, which use the stored frames, call this method themselves
+   */
+  void waitForPending();
+  /**
+   * @brief setMaxPending Limits the number of asynchronously appended frames, which are being
+   * compressed at the same time, and thus the memory taken by them
+   * @param iCount Maximal number of frames being compressed. Values smaller than 1 are treated as 1
+   */
+  void setMaxPending(int iCount);
+  /**
+   * @brief maxPending Returns the maximal number of frames, which are being compressed at the same
+   * time
+   * @return Maximal number of frames being compressed
+   */
+  int maxPending() const { return m_iMaxPending; }
   /**
    * @brief exportAPNG Exports the included images to APNG file
    * @param rqsFile Full path to the file to write the animation to
    * @param iFPS Frames per second value
-   * @return true on success and false on failure
+   * @return true on success and false, if the file could not be opened or written completely. The
+   * digest is left empty on failure
    */
   bool exportAPNG(const QString& rqsFile, int iFPS);
+  /**
+   * @brief begin Starts streaming the animation into the file. From now on, the appended frames are
+   * written into the file right after the next frame is appended, which may still change the way
+   * they are disposed of, and their compressed data is released. The exportAPNG method can not be
+   * used for the streamed frames
+   * @param rqsFile Full path to the file to write the animation to
+   * @param iFPS Frames per second value
+   * @return true, if the file was opened for writing and false otherwise
+   */
+  bool begin(const QString& rqsFile, int iFPS);
+  /**
+   * @brief finish Writes the remaining frames and completes the streamed animation. The number of
+   * frames is written into the acTL chunk at the beginning of the file only now
+   * @return true on success and false, if no animation is being streamed, it has no frames or the
+   * file could not be written completely
+   */
+  bool finish();
   /**
    * @brief reset This method removes all the stored images from the object's container, making it
    * possible to reuse objects of this class to create more than one animated PNG
    */
   void reset() override;
   /**
-   * @brief count Returns the number of frames stored in the object's container
+   * @brief count Returns the number of frames stored in the object's container, including the
+   * frames, which are still being compressed. The folded duplicate frames are not counted
    * @return number of frames stored in the object's container
    */
   int count() const;
 
 private:
+  /**
+   * @brief The Candidate struct This struct holds one way of storing a delta frame
+   */
+  struct Candidate {
+    Candidate() = default;
+    Candidate(quint8 uiDispose, quint8 uiBlend) : m_uiDispose(uiDispose), m_uiBlend(uiBlend) {}
+
+    quint8 m_uiDispose = FrameControl::edoNone;
+    quint8 m_uiBlend   = FrameControl::eboSource;
+    QImage m_imgCanvas;
+    QRect m_rect;
+    EncodedImage m_encoded;
+    QByteArray m_baKey;
+    bool m_bCached = false;
+    bool m_bValid  = false;
+  };
+
+  /**
+   * @brief compress Returns the compressed image from the frame cache, if there is one, or
+   * compresses it and adds it to the cache. This method does not modify the object, so it can be
+   * called from several threads at once
+   * @param rImg Reference to the image to compress
+   * @return Compressed image, which is null if the image could not be compressed
+   */
+  EncodedImage compress(const QImage& rImg) const;
+  /**
+   * @brief encode Compresses the image by the encoder, after quantizing it to the palette or
+   * converting it to the reduced format, if there is one
+   * @param rImg Reference to the image to compress
+   * @return Compressed image, which is null if the image could not be compressed
+   */
+  EncodedImage encode(const QImage& rImg) const;
+  /**
+   * @brief accepts Indicates, whether the image can be appended in the format shared by the frames.
+   * It is checked once per appended image, before it is compressed
+   * @param rImg Reference to the image to append
+   * @return true, if the image can be appended and false, if it has to be refused
+   */
+  bool accepts(const QImage& rImg) const;
+  /**
+   * @brief cacheSettings Serializes all the settings, besides the pixels, which the compressed
+   * image depends on, as a part of its key in the frame cache
+   * @return Serialized settings
+   */
+  QByteArray cacheSettings() const;
+  /**
+   * @brief convertsFrames Indicates, whether the images are converted to the palette or to the
+   * reduced format, before they are compressed
+   * @return true, if the images are converted and false, if they are stored in their own format
+   */
+  bool convertsFrames() const;
+  /**
+   * @brief keepsTransparency Indicates, whether the format, in which the images are stored, holds
+   * the fully transparent pixels, which the frames blended by the OVER operation rely on
+   * @return true, if the fully transparent pixels are stored and false otherwise
+   */
+  bool keepsTransparency() const;
+  /**
+   * @brief appendPNG Adds the frame, stored as PNG image in the byte array
+   * @param rba Reference to the byte array, containing a valid PNG image
+   */
+  void appendPNG(const QByteArray& rba);
+  /**
+   * @brief appendEncoded Adds the frame, compressed by the encoder, without wrapping it into a PNG
+   * image and parsing it back
+   * @param rImage Reference to the compressed image
+   * @param rRect Reference to the region of the animation, which the frame covers. If null, the
+   * frame covers the whole animation
+   * @param uiBlend Blend operation of the frame
+   * @return true, if the frame was stored and false, if the image is null
+   */
+  bool appendEncoded(const EncodedImage& rImage, const QRect& rRect = QRect(),
+                     quint8 uiBlend = FrameControl::eboSource);
+  /**
+   * @brief storeFrame Stores the fdAT chunk and the frame control of a frame after the first one
+   * @param rFrame Reference to the chunk, which holds the whole frame data
+   * @param uiFrameCRC CRC32 of the frame data alone
+   * @param rRect Reference to the region of the animation, which the frame covers. If null, the
+   * frame covers the whole animation
+   * @param uiBlend Blend operation of the frame
+   */
+  void storeFrame(const Chunk& rFrame, quint32 uiFrameCRC, const QRect& rRect, quint8 uiBlend);
+  /**
+   * @brief makeChunk Returns the chunk with the given content and its CRC
+   * @param rbaName Reference to the chunk name
+   * @param rbaContent Reference to the chunk content
+   * @return Chunk
+   */
+  Chunk makeChunk(const QByteArray& rbaName, const QByteArray& rbaContent) const;
+  /**
+   * @brief foldDuplicate Folds the image into the previous frame, if it is the same as the image
+   * appended before it. Otherwise, the image is kept for the comparison with the next one
+   * @param rImg Reference to the image to append
+   * @return true, if the image was folded and must not be appended and false otherwise
+   */
+  bool foldDuplicate(const QImage& rImg);
+  /**
+   * @brief foldDuplicate Folds the PNG image into the previous frame, if it is the same as the PNG
+   * image appended before it. Otherwise, the image is kept for the comparison with the next one
+   * @param rba Reference to the byte array, containing the PNG image to append
+   * @return true, if the image was folded and must not be appended and false otherwise
+   */
+  bool foldDuplicate(const QByteArray& rba);
+  /**
+   * @brief repeatLast Makes the last appended frame last for one more frame period. If the frame
+   * is still being compressed, the period is added once the frame is stored
+   * @return true on success and false, if there is no frame yet or the frame can not last longer
+   */
+  bool repeatLast();
+  /**
+   * @brief addPeriods Makes the last stored frame last for the given number of frame periods more.
+   * Has to be called with the mutex locked
+   * @param iPeriods Number of frame periods to add
+   * @return true on success and false, if there is no frame yet or the frame can not last longer
+   */
+  bool addPeriods(int iPeriods);
+  /**
+   * @brief appendDelta Adds the image in the delta mode, cropped to the region, which changed
+   * since the previous frame
+   * @param rImg Reference to the image to include
+   * @return true, if the frame was stored and false, if it differs in size from the first frame or
+   * could not be compressed
+   */
+  bool appendDelta(const QImage& rImg);
+  /**
+   * @brief changedRect Returns the bounding box of the pixels, which differ between two images of
+   * the same size and format
+   * @param rPrevious Reference to the previous image
+   * @param rImg Reference to the current image
+   * @return Bounding box of the changed pixels or an empty rectangle, if the images are the same
+   */
+  QRect changedRect(const QImage& rPrevious, const QImage& rImg) const;
+  /**
+   * @brief disposed Returns the canvas, which the next frame is composed onto, if the previous
+   * frame is disposed of by the given operation
+   * @param uiDispose Dispose operation of the previous frame
+   * @return Canvas after the dispose operation
+   */
+  QImage disposed(quint8 uiDispose) const;
+  /**
+   * @brief evaluate Crops and compresses the image for the candidate. The candidate is only marked
+   * valid, if it reproduces the image exactly
+   * @param rCandidate Reference to the candidate with its dispose and blend operations set
+   * @param rImg Reference to the image to store
+   */
+  void evaluate(Candidate& rCandidate, const QImage& rImg) const;
+  /**
+   * @brief writeStream Writes the stored frames, which have not been streamed yet, into the file
+   * @param iKeep Number of the last stored frames, which are held back
+   */
+  void writeStream(int iKeep);
+  /**
+   * @brief storeEncoded Stores the compressed frames, which are next in order. Has to be called with
+   * the mutex locked
+   */
+  void storeEncoded();
+  /**
+   * @brief write Writes the data into the file and adds it to the digest, if one is calculated
+   * @param rF Reference to the file to write into
+   * @param rba Reference to the data
+   */
+  void write(QFile& rF, const QByteArray& rba) const;
+  /**
+   * @brief write Writes the chunk into the file and adds it to the digest, if one is calculated
+   * @param rF Reference to the file to write into
+   * @param rChunk Reference to the chunk
+   */
+  void write(QFile& rF, const Chunk& rChunk) const;
   /**
    * @brief writeSignature Writes the PNG signature into given file
    * @param rF Reference to file to write into
@@ -118,11 +572,50 @@ private:
 private:
   QVector<Chunk> m_vIDAT;
   QVector<Chunk> m_vfDAT;
+  QVector<quint32> m_vfDATCRC;
+  QVector<FrameControl> m_vfDATControl;
+  FrameControl m_controlIDAT;
   QVector<Chunk> m_vOtherChunks;
   Chunk m_chunkIHDR;
   int m_iW;
   int m_iH;
+  Encoder m_encoder;
+  Quantizer m_quantizer;
+  QVector<QRgb> m_vPalette;
+  Reducer m_reducer;
+  FrameCache* m_pCache;
+  bool m_bDeterministic;
+  QDateTime m_creationTime;
+  QString m_qsSoftware;
+  bool m_bDigest;
+  QCryptographicHash::Algorithm m_eDigest;
+  std::unique_ptr<QCryptographicHash> m_pHash;
+  mutable bool m_bWriteFailed;
+  QByteArray m_baDigest;
+  QImage m_imgPrevious;
+  QImage m_imgBackground;
+  QRect m_rectPrevious;
+  TaskRunner m_runner;
+  Optimization m_eOptimization;
+  bool m_bDelta;
+  bool m_bFoldDuplicates;
+  QImage m_imgLast;
+  QByteArray m_baLast;
+
+  mutable QMutex m_mutex;
+  QWaitCondition m_condStored;
+  QSemaphore m_semPending;
+  QMap<int, EncodedImage> m_mapEncoded;
+  QMap<int, int> m_mapPeriods;
+  int m_iQueued;
+  int m_iStored;
+  int m_iMaxPending;
 
+  QFile m_fileStream;
+  qint64 m_iACTLOffset;
+  int m_iStreamFPS;
+  int m_iStreamed;
+  bool m_bStreaming;
 };
 
 }
@@ -1,11 +1,23 @@
+#include <QFileInfo>
 #include <QImage>
 #include <QPainter>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
+#include <QtEndian>
+#include <QThreadPool>
 #include <QtTest>
 
 // add necessary includes here
+#include "../libapng/blend.h"
+#include "../libapng/compression.h"
+#include "../libapng/compositor.h"
 #include "../libapng/crc.h"
+#include "../libapng/encoder.h"
+#include "../libapng/filter.h"
+#include "../libapng/framecache.h"
+#include "../libapng/quantizer.h"
 #include "../libapng/reader.h"
+#include "../libapng/reducer.h"
 #include "../libapng/writer.h"
 
 class TestLibApng : public QObject
@@ -25,9 +37,34 @@ private slots:
 
   void crcOutput_data();
   void crcOutput();
+  void crcIncremental();
+  void crcCombine();
+  void compressionBackend();
 
   void writerBinaryTest();
   void readerWriterTest();
+  void deltaWriterTest();
+  void optimizedWriterTest();
+  void asyncWriterTest();
+  void streamingWriterTest();
+  void duplicateFramesTest();
+  void paletteWriterTest();
+  void reductionTest();
+  void frameCacheTest();
+  void deterministicExportTest();
+  void encoderPresetTest();
+  void parallelDeflateTest();
+  void streamingReaderTest();
+  void mappedReaderTest();
+  void nativeDecoderTest();
+  void colorTypeTest_data();
+  void colorTypeTest();
+  void parallelDecodeTest();
+  void frameIndexTest();
+  void seekTest();
+  void compositorTest();
+  void blendKernels();
+  void filterKernels();
 
   void errorChecking_data();
   void errorChecking();
@@ -82,22 +119,87 @@ void TestLibApng::crcOutput()
   QCOMPARE(crc.calculate(bytes), value);
 }
 
+void TestLibApng::crcIncremental()
+{
+  using namespace png;
+  CRC crc;
+
+  QByteArray ba;
+  for (int i = 0; i < 100000; ++i)
+    ba.append(char((i * 7919) >> 3));
+
+  // odd lengths and offsets exercise the unaligned head and tail of the accelerated paths
+  for (int iLen : {0, 1, 15, 16, 63, 64, 65, 1000, 99999}) {
+    auto uiExpected = CRC::reference(0U, ba.constData() + 1, iLen);
+    QCOMPARE(crc.update(0U, ba.constData() + 1, iLen), uiExpected);
+    auto uiState = crc.update(0U, ba.constData() + 1, iLen / 3);
+    uiState      = crc.update(uiState, ba.constData() + 1 + iLen / 3, iLen - iLen / 3);
+    QCOMPARE(uiState, uiExpected);
+  }
+}
+
+void TestLibApng::crcCombine()
+{
+  using namespace png;
+  CRC crc;
+
+  QByteArray ba;
+  for (int i = 0; i < 20000; ++i)
+    ba.append(char((i * 104729) >> 5));
+
+  for (int iSplit : {0, 4, 8192, 19999, 20000}) {
+    auto uiFirst  = crc.update(0U, ba.constData(), iSplit);
+    auto uiSecond = crc.update(0U, ba.constData() + iSplit, ba.size() - iSplit);
+    QCOMPARE(crc.combine(uiFirst, uiSecond, ba.size() - iSplit), crc.calculate(ba));
+    // stripping the prefix gives back the CRC of the second block
+    QCOMPARE(crc.calculate(ba) ^ crc.combine(uiFirst, 0U, ba.size() - iSplit), uiSecond);
+  }
+}
+
+void TestLibApng::compressionBackend()
+{
+  using namespace png;
+  Compression compression;
+  QByteArray baRaw;
+  for (int i = 0; i < 100000; ++i)
+    baRaw.append(char((quint32(i) * quint32(i)) >> 7));
+
+  QByteArray baDeflated;
+  QVERIFY(compression.deflate(baRaw, baDeflated, 6, EncoderOptions::Strategy::esDefault));
+  QVERIFY(baDeflated.size() < baRaw.size());
+
+  QByteArray baInflated(baRaw.size(), Qt::Uninitialized);
+  QVERIFY(compression.inflate({baDeflated.left(100), baDeflated.mid(100)}, baInflated));
+  QCOMPARE(baInflated, baRaw);
+
+  // the stream ends with the Adler-32 of the data, which has to match the combined checksums
+  auto pRaw      = reinterpret_cast<const uchar*>(baRaw.constData());
+  quint32 uiHead = compression.adler32(1U, pRaw, 12345U);
+  quint32 uiTail = compression.adler32(1U, pRaw + 12345, quint32(baRaw.size()) - 12345U);
+  quint32 uiAll  = compression.adler32(1U, pRaw, quint32(baRaw.size()));
+  QCOMPARE(compression.adler32Combine(uiHead, uiTail, quint32(baRaw.size()) - 12345U), uiAll);
+  QCOMPARE(qFromBigEndian<quint32>(baDeflated.constData() + baDeflated.size() - 4), uiAll);
+}
+
 void TestLibApng::writerBinaryTest()
 {
   using namespace png;
   Writer writerImg;
   Writer writerPix;
   Writer writerFile;
+  Writer writerRaw;
 
   for (int i = 0; i < 10; ++i) {
     auto img = prepareImage(i);
     writerImg.append(&img);
+    writerRaw.append(img.constBits(), img.width(), img.height(), img.bytesPerLine(), img.format());
     auto pix = QPixmap::fromImage(img);
     writerPix.append(&pix);
+    // the file is compressed the same way, as the writer compresses the images by default
     QTemporaryFile tfFile;
     tfFile.open();
+    tfFile.write(Encoder(EncoderOptions::preset(EncoderOptions::Preset::epArchive)).encode(img));
     tfFile.close();
-    img.save(tfFile.fileName(), "PNG", 0);
     writerFile.append(tfFile.fileName());
   }
 
@@ -113,10 +215,15 @@ void TestLibApng::writerBinaryTest()
   tfFiles.open();
   tfFiles.close();
   writerFile.exportAPNG(tfFiles.fileName(), 30);
+  QTemporaryFile tfRaw;
+  tfRaw.open();
+  tfRaw.close();
+  writerRaw.exportAPNG(tfRaw.fileName(), 30);
 
   QFile fImg(tfImg.fileName());
   QFile fPix(tfPix.fileName());
   QFile fFile(tfFiles.fileName());
+  QFile fRaw(tfRaw.fileName());
 
   fImg.open(QFile::ReadOnly);
   auto baImg = fImg.readAll();
@@ -127,14 +234,19 @@ void TestLibApng::writerBinaryTest()
   fFile.open(QFile::ReadOnly);
   auto baFile = fFile.readAll();
   fFile.close();
+  fRaw.open(QFile::ReadOnly);
+  auto baRaw = fRaw.readAll();
+  fRaw.close();
 
   // these tests might occasionally fail, because the APNG files also store Creation time, which
   // can be different for two different files, created one after another. But this is a rare
   // occasion and should not be a reason for concern unless these tests start failing regularly.
   QCOMPARE(baImg.size(), baPix.size());
   QCOMPARE(baImg.size(), baFile.size());
+  QCOMPARE(baImg.size(), baRaw.size());
   QCOMPARE(baImg, baPix);
   QCOMPARE(baImg, baFile);
+  QCOMPARE(baImg, baRaw);
 }
 
 void TestLibApng::readerWriterTest()
@@ -166,6 +278,919 @@ void TestLibApng::readerWriterTest()
   }
 }
 
+void TestLibApng::deltaWriterTest()
+{
+  using namespace png;
+  Writer writer;
+  Reader reader;
+  writer.setDeltaFrames(true);
+
+  QVector<QImage> vImg1;
+  for (int i = 0; i < 10; ++i) {
+    vImg1 << prepareImage(i);
+    writer.append(&vImg1.last());
+  }
+  // an unchanged frame is stored as well
+  writer.append(&vImg1.last());
+  vImg1 << vImg1.last();
+
+  QTemporaryFile tf;
+  tf.open();
+  tf.close();
+  writer.exportAPNG(tf.fileName(), 30);
+
+  auto vImg2 = reader.importImages(tf.fileName());
+  QVERIFY(reader.info().isOk());
+  QCOMPARE(vImg1.count(), vImg2.count());
+  for (int i = 0; i < qMin(vImg1.count(), vImg2.count()); ++i) {
+    QVERIFY2(vImg1[i] == vImg2[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+
+  // only the squares, which moved between two frames, are stored
+  QCOMPARE(reader.frameControl(0).m_uiWidth, 100U);
+  for (int i = 1; i < 10; ++i) {
+    auto fc = reader.frameControl(i);
+    QRect rect(int(fc.m_uiX), int(fc.m_uiY), int(fc.m_uiWidth), int(fc.m_uiHeight));
+    QVERIFY(rect.contains(QRect(10 * i + 3, 10 * i + 3, 4, 4)));
+    QVERIFY((rect.width() <= 22) && (rect.height() <= 22));
+  }
+  QCOMPARE(reader.frameControl(10).m_uiWidth, 1U);
+
+  // the frame of another size is refused, the next ones are still stored against the canvas
+  writer.reset();
+  writer.setOptimization(Writer::Optimization::eoSize);
+  QImage imgSmall = prepareImage(0).copy(0, 0, 50, 50);
+  QVERIFY(writer.append(&vImg1[0]));
+  QVERIFY(writer.append(&imgSmall) == false);
+  QVERIFY(writer.append(&vImg1[1]));
+  QVERIFY(writer.append(&vImg1[2]));
+  QCOMPARE(writer.count(), 3);
+
+  QVERIFY(writer.exportAPNG(tf.fileName(), 30));
+  vImg2 = reader.importImages(tf.fileName());
+  QVERIFY(reader.info().isOk());
+  QCOMPARE(vImg2.count(), 3);
+  for (int i = 0; i < vImg2.count(); ++i)
+    QVERIFY2(vImg1[i] == vImg2[i], QString("Frame %1 differs").arg(i).toLatin1());
+}
+
+void TestLibApng::optimizedWriterTest()
+{
+  using namespace png;
+  QVector<QImage> vImg1;
+  for (int i = 0; i < 10; ++i) {
+    vImg1 << prepareImage(i);
+  }
+
+  QVector<qint64> viSize;
+  for (auto eOptimization : {Writer::Optimization::eoNone, Writer::Optimization::eoSpeed,
+                             Writer::Optimization::eoSize}) {
+    Writer writer;
+    Reader reader;
+    writer.setDeltaFrames(true);
+    writer.setOptimization(eOptimization);
+    for (auto img : vImg1) {
+      writer.append(&img);
+    }
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    writer.exportAPNG(tf.fileName(), 30);
+    viSize << QFileInfo(tf.fileName()).size();
+
+    auto vImg2 = reader.importImages(tf.fileName());
+    QVERIFY(reader.info().isOk());
+    QCOMPARE(vImg1.count(), vImg2.count());
+    for (int i = 0; i < qMin(vImg1.count(), vImg2.count()); ++i) {
+      QVERIFY2(vImg1[i] == vImg2[i], QString("Frame %1 differs").arg(i).toLatin1());
+    }
+  }
+
+  // the text chunk with the creation time may differ in length by a few bytes
+  QVERIFY(viSize[1] <= viSize[0] + 8);
+  QVERIFY(viSize[2] <= viSize[1] + 8);
+}
+
+void TestLibApng::asyncWriterTest()
+{
+  using namespace png;
+  QThreadPool pool;
+  pool.setMaxThreadCount(4);
+  Writer writer;
+  Reader reader;
+  writer.setThreadPool(&pool);
+  writer.setMaxPending(2);
+
+  QVector<QImage> vImg1;
+  for (int i = 0; i < 10; ++i) {
+    vImg1 << prepareImage(i);
+    // the synchronously appended frames keep their place among the asynchronous ones
+    if (i == 5)
+      writer.append(&vImg1.last());
+    else
+      writer.appendAsync(vImg1.last());
+  }
+  QCOMPARE(writer.count(), 10);
+
+  QTemporaryFile tf;
+  tf.open();
+  tf.close();
+  writer.exportAPNG(tf.fileName(), 30);
+
+  auto vImg2 = reader.importImages(tf.fileName());
+  QVERIFY(reader.info().isOk());
+  QCOMPARE(vImg1.count(), vImg2.count());
+  for (int i = 0; i < qMin(vImg1.count(), vImg2.count()); ++i) {
+    QVERIFY2(vImg1[i] == vImg2[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+}
+
+void TestLibApng::streamingWriterTest()
+{
+  using namespace png;
+  Writer writer;
+  Reader reader;
+  writer.setDeltaFrames(true);
+  writer.setOptimization(Writer::Optimization::eoSize);
+
+  QTemporaryFile tf;
+  tf.open();
+  tf.close();
+  QVERIFY(writer.begin(tf.fileName(), 30));
+
+  QVector<QImage> vImg1;
+  for (int i = 0; i < 10; ++i) {
+    vImg1 << prepareImage(i);
+    writer.append(&vImg1.last());
+  }
+  QVERIFY(writer.finish());
+  // the streamed frames are not kept in memory
+  QVERIFY(writer.exportAPNG(tf.fileName(), 30) == false);
+
+  auto vImg2 = reader.importImages(tf.fileName());
+  QVERIFY(reader.info().isOk());
+  QCOMPARE(reader.info().framesCount(), 10U);
+  QCOMPARE(vImg1.count(), vImg2.count());
+  for (int i = 0; i < qMin(vImg1.count(), vImg2.count()); ++i) {
+    QVERIFY2(vImg1[i] == vImg2[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+}
+
+void TestLibApng::duplicateFramesTest()
+{
+  using namespace png;
+  // the runs of 3, 2 and 1 identical frames
+  QVector<QImage> vImg = {prepareImage(0), prepareImage(0), prepareImage(0),
+                          prepareImage(1), prepareImage(1), prepareImage(2)};
+
+  for (bool bAsync : {false, true}) {
+    Writer writer;
+    writer.setFoldDuplicates(true);
+    for (auto& rImg : vImg) {
+      if (bAsync == true)
+        writer.appendAsync(rImg);
+      else
+        writer.append(&rImg);
+    }
+    QCOMPARE(writer.count(), 3);
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    QVERIFY(writer.exportAPNG(tf.fileName(), 10));
+
+    Reader reader;
+    QVERIFY(reader.open(tf.fileName()));
+    QCOMPARE(reader.frameCount(), 3);
+    for (int i = 0; i < 3; ++i) {
+      QCOMPARE(reader.frameControl(i).delay(), quint32(300 - 100 * i));
+      QVERIFY2(reader.frame(i) == prepareImage(i), QString("Frame %1 differs").arg(i).toLatin1());
+    }
+  }
+}
+
+void TestLibApng::paletteWriterTest()
+{
+  using namespace png;
+  QVector<QImage> vImg1;
+  Quantizer quantizer;
+  for (int i = 0; i < 10; ++i) {
+    vImg1 << prepareImage(i);
+    quantizer.add(vImg1.last());
+  }
+  // the few colors of the frames fit into the palette, so the quantization is lossless
+  auto vPalette = quantizer.palette();
+  QVERIFY(vPalette.isEmpty() == false);
+  QVERIFY(vPalette.count() <= 256);
+
+  for (bool bDelta : {false, true}) {
+    Writer writer;
+    QVERIFY(writer.setPalette(vPalette));
+    writer.setDeltaFrames(bDelta);
+    for (auto& rImg : vImg1)
+      writer.append(&rImg);
+
+    // the frames already stored keep the format, which they share with the next ones
+    QVERIFY(writer.setPalette(QVector<QRgb>()) == false);
+    QVERIFY(writer.setReduction(Reducer()) == false);
+    QCOMPARE(writer.palette(), vPalette);
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    QVERIFY(writer.exportAPNG(tf.fileName(), 30));
+
+    Reader reader;
+    QVERIFY(reader.open(tf.fileName()));
+    QCOMPARE(reader.frameCount(), vImg1.count());
+    QCOMPARE(reader.frame(0).format(), QImage::Format_Indexed8);
+    for (int i = 0; i < reader.frameCount(); ++i) {
+      auto img = reader.composedFrame(i).convertToFormat(QImage::Format_ARGB32);
+      QVERIFY2(img == vImg1[i], QString("Frame %1 differs").arg(i).toLatin1());
+    }
+  }
+}
+
+void TestLibApng::reductionTest()
+{
+  using namespace png;
+  // the opaque gray frames with 16 levels fit into 4 bits
+  QVector<QImage> vGray;
+  for (int i = 0; i < 4; ++i) {
+    QImage img(40, 30, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y) {
+      for (int x = 0; x < img.width(); ++x) {
+        int iLevel = ((x + y + i) % 16) * 17;
+        img.setPixel(x, y, qRgb(iLevel, iLevel, iLevel));
+      }
+    }
+    vGray << img;
+  }
+
+  Reducer reducer;
+  for (const auto& rImg : vGray)
+    reducer.add(rImg);
+  QCOMPARE(reducer.colorType(), quint8(Header::ectGray));
+  QCOMPARE(reducer.bitDepth(), quint8(4));
+
+  // the few colors of the antialiased frames make a palette
+  QVector<QImage> vColor;
+  for (int i = 0; i < 10; ++i)
+    vColor << prepareImage(i);
+
+  for (const auto& rvImg : {vGray, vColor}) {
+    reducer.clear();
+    for (const auto& rImg : rvImg)
+      reducer.add(rImg);
+
+    Writer writer;
+    writer.append(rvImg);
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    QVERIFY(writer.exportAPNG(tf.fileName(), 30));
+
+    // the bit depth and the color type follow the width and the height in the IHDR chunk
+    QFile f(tf.fileName());
+    QVERIFY(f.open(QFile::ReadOnly));
+    auto ba = f.read(26);
+    f.close();
+    QCOMPARE(quint8(ba.at(24)), reducer.bitDepth());
+    QCOMPARE(quint8(ba.at(25)), reducer.colorType());
+
+    Reader reader;
+    QVERIFY(reader.open(tf.fileName()));
+    QCOMPARE(reader.frameCount(), rvImg.count());
+    for (int i = 0; i < reader.frameCount(); ++i) {
+      auto img = reader.composedFrame(i).convertToFormat(QImage::Format_ARGB32);
+      QVERIFY2(img == rvImg[i].convertToFormat(QImage::Format_ARGB32),
+               QString("Frame %1 differs").arg(i).toLatin1());
+    }
+  }
+
+  // the color frame does not fit into the gray format of the frames appended before it
+  Writer writer;
+  QVERIFY(writer.append(vGray));
+  auto imgColor = prepareImage(0);
+  QVERIFY(writer.append(&imgColor) == false);
+  QVERIFY(writer.appendAsync(imgColor) == false);
+  QCOMPARE(writer.count(), vGray.count());
+
+  // the next animation chooses its own format
+  writer.reset();
+  QVERIFY(writer.reduction().isNull());
+  QVERIFY(writer.append(&imgColor));
+  QCOMPARE(writer.count(), 1);
+
+  QTemporaryFile tf;
+  tf.open();
+  tf.close();
+  QVERIFY(writer.exportAPNG(tf.fileName(), 30));
+
+  Reader reader;
+  QVERIFY(reader.open(tf.fileName()));
+  QCOMPARE(reader.composedFrame(0).convertToFormat(QImage::Format_ARGB32), imgColor);
+}
+
+void TestLibApng::frameCacheTest()
+{
+  using namespace png;
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  FrameCache cache;
+  QVERIFY(cache.setDiskCache(dir.path(), 1024 * 1024));
+
+  // the second export finds all the frames, compressed by the first one
+  QVector<QImage> vImg;
+  for (int i = 0; i < 5; ++i)
+    vImg << prepareImage(i);
+
+  for (int iExport = 0; iExport < 2; ++iExport) {
+    Writer writer;
+    writer.setFrameCache(&cache);
+    for (auto& rImg : vImg)
+      writer.append(&rImg);
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    QVERIFY(writer.exportAPNG(tf.fileName(), 10));
+    QCOMPARE(cache.hits(), quint64(iExport * vImg.count()));
+    QCOMPARE(cache.misses(), quint64(vImg.count()));
+
+    Reader reader;
+    QVERIFY(reader.open(tf.fileName()));
+    for (int i = 0; i < vImg.count(); ++i)
+      QVERIFY2(reader.frame(i) == vImg[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+
+  // of the delta candidates, only the chosen ones are cached and only the first frame is a miss
+  FrameCache delta;
+  qint64 iDeltaUsage = 0;
+  for (int iExport = 0; iExport < 2; ++iExport) {
+    Writer writer;
+    writer.setFrameCache(&delta);
+    writer.setDeltaFrames(true);
+    writer.setOptimization(Writer::Optimization::eoSize);
+    for (auto& rImg : vImg)
+      QVERIFY(writer.append(&rImg));
+    QCOMPARE(delta.misses(), quint64(1));
+    if (iExport == 0)
+      iDeltaUsage = delta.memoryUsage();
+    QCOMPARE(delta.memoryUsage(), iDeltaUsage);
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    QVERIFY(writer.exportAPNG(tf.fileName(), 10));
+
+    Reader reader;
+    auto vImgRead = reader.importImages(tf.fileName());
+    QCOMPARE(vImgRead.count(), vImg.count());
+    for (int i = 0; i < vImgRead.count(); ++i)
+      QVERIFY2(vImgRead[i] == vImg[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+  QVERIFY(delta.hits() >= quint64(vImg.count()));
+
+  // other encoder options make other frames
+  auto key = FrameCache::key(vImg[0], QByteArray("archive"));
+  QVERIFY(key != FrameCache::key(vImg[0], QByteArray("realtime")));
+  QVERIFY(key != FrameCache::key(vImg[1], QByteArray("archive")));
+  QCOMPARE(key, FrameCache::key(vImg[0].copy(), QByteArray("archive")));
+
+  // the next process takes the frames over from the disk
+  FrameCache next;
+  next.setMemoryBudget(0);
+  QVERIFY(next.setDiskCache(dir.path(), 1024 * 1024));
+  QCOMPARE(next.diskUsage(), cache.diskUsage());
+  {
+    Writer writer;
+    writer.setFrameCache(&next);
+    for (auto& rImg : vImg)
+      writer.append(&rImg);
+    QCOMPARE(next.hits(), quint64(vImg.count()));
+    QCOMPARE(next.misses(), quint64(0));
+  }
+
+  // the least recently used frames are evicted, until the rest fits into the budget
+  qint64 iUsage = cache.memoryUsage();
+  QVERIFY(iUsage > 0);
+  cache.setMemoryBudget(iUsage / 2);
+  QVERIFY(cache.memoryUsage() <= iUsage / 2);
+  QVERIFY(next.setDiskCache(dir.path(), next.diskUsage() / 2));
+  QVERIFY(next.diskUsage() <= cache.diskUsage() / 2);
+  QVERIFY(QDir(dir.path()).entryList(QDir::Files).count() < vImg.count());
+
+  cache.clear();
+  QCOMPARE(cache.memoryUsage(), qint64(0));
+  QCOMPARE(QDir(dir.path()).entryList(QDir::Files).count(), 0);
+}
+
+void TestLibApng::deterministicExportTest()
+{
+  using namespace png;
+  QVector<QByteArray> vbaFile;
+  for (bool bAsync : {false, true}) {
+    Writer writer;
+    writer.setDeterministic(true);
+    writer.setDigest(true, QCryptographicHash::Sha256);
+    for (int i = 0; i < 5; ++i) {
+      auto img = prepareImage(i);
+      if (bAsync == true)
+        writer.appendAsync(img);
+      else
+        writer.append(&img);
+    }
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    QVERIFY(writer.exportAPNG(tf.fileName(), 10));
+
+    QFile f(tf.fileName());
+    QVERIFY(f.open(QFile::ReadOnly));
+    vbaFile << f.readAll();
+    f.close();
+
+    // the digest is the hash of the whole file
+    auto baDigest = QCryptographicHash::hash(vbaFile.last(), QCryptographicHash::Sha256);
+    QCOMPARE(writer.digest(), baDigest);
+    QVERIFY(vbaFile.last().contains("Creation time") == false);
+  }
+
+  QCOMPARE(vbaFile[0], vbaFile[1]);
+
+  // the fixed creation time is written and the software is omitted
+  Writer writer;
+  writer.setDeterministic(true);
+  writer.setCreationTime(QDateTime(QDate(2024, 1, 2), QTime(3, 4, 5)));
+  writer.setSoftware(QString());
+  auto img = prepareImage(0);
+  writer.append(&img);
+
+  QTemporaryFile tf;
+  tf.open();
+  tf.close();
+  QVERIFY(writer.exportAPNG(tf.fileName(), 10));
+  QVERIFY(writer.digest().isEmpty());
+
+  QFile f(tf.fileName());
+  QVERIFY(f.open(QFile::ReadOnly));
+  auto ba = f.readAll();
+  QVERIFY(ba.contains("Tue, 02 01 2024 03:04:05"));
+  QVERIFY(ba.contains("Software") == false);
+
+  // the file, which could not be written completely, is reported and not digested
+  if (QFile::exists("/dev/full") == true) {
+    writer.setDigest(true);
+    QVERIFY(writer.exportAPNG("/dev/full", 10) == false);
+    QVERIFY(writer.digest().isEmpty());
+    QVERIFY(writer.exportAPNG(tf.fileName(), 10));
+    QVERIFY(writer.digest().isEmpty() == false);
+  }
+}
+
+void TestLibApng::encoderPresetTest()
+{
+  using namespace png;
+  QVERIFY(EncoderOptions::preset("unknown").has_value() == false);
+
+  QVector<qint64> viSize;
+  for (const auto& rqsPreset : {"realtime", "balanced", "archive"}) {
+    auto options = EncoderOptions::preset(rqsPreset);
+    QVERIFY(options.has_value());
+
+    Writer writer;
+    Reader reader;
+    writer.setEncoderOptions(*options);
+    QCOMPARE(writer.encoderOptions().m_iLevel, options->m_iLevel);
+
+    QVector<QImage> vImg1;
+    for (int i = 0; i < 10; ++i) {
+      vImg1 << prepareImage(i);
+      writer.append(&vImg1.last());
+    }
+
+    QTemporaryFile tf;
+    tf.open();
+    tf.close();
+    QVERIFY(writer.exportAPNG(tf.fileName(), 30));
+    viSize << QFileInfo(tf.fileName()).size();
+
+    auto vImg2 = reader.importImages(tf.fileName());
+    QCOMPARE(vImg1.count(), vImg2.count());
+    for (int i = 0; i < qMin(vImg1.count(), vImg2.count()); ++i) {
+      QVERIFY2(vImg1[i] == vImg2[i],
+               QString("%1: frame %2 differs").arg(rqsPreset).arg(i).toLatin1());
+    }
+  }
+
+  // the slower presets make the smaller files of the same frames
+  QVERIFY(viSize[1] < viSize[0]);
+  QVERIFY(viSize[2] < viSize[0]);
+  QVERIFY(viSize[2] <= viSize[1]);
+}
+
+void TestLibApng::parallelDeflateTest()
+{
+  using namespace png;
+  auto img = prepareImage(3).scaled(400, 400);
+
+  Encoder encoder;
+  QThreadPool pool;
+  encoder.setThreadPool(&pool);
+  auto baSingle = encoder.encode(img);
+
+  // the blocks have to give a valid zlib stream for any block count, including a single block
+  for (int iBlockSize : {32768, 100000, 1 << 20}) {
+    auto options         = encoder.options();
+    options.m_iBlockSize = iBlockSize;
+    encoder.setOptions(options);
+
+    auto ba = encoder.encode(img);
+    QVERIFY(ba.isEmpty() == false);
+    QCOMPARE(QImage::fromData(ba, "PNG").convertToFormat(QImage::Format_ARGB32), img);
+    if (iBlockSize >= img.sizeInBytes() + img.height())
+      QCOMPARE(ba, baSingle);
+  }
+}
+
+void TestLibApng::streamingReaderTest()
+{
+  using namespace png;
+  Reader reader;
+
+  auto vImgFile = reader.importImages(":/data/validApng2.png");
+  QVERIFY(reader.info().isOk());
+
+  QFile f(":/data/validApng2.png");
+  QVERIFY(f.open(QFile::ReadOnly));
+  QBuffer buf;
+  buf.setData(f.readAll());
+  f.close();
+  buf.open(QIODevice::ReadOnly);
+
+  auto vImgDevice = reader.importImages(&buf);
+  QVERIFY(reader.info().isOk());
+  QCOMPARE(reader.info().framesCount(), 50U);
+  QCOMPARE(vImgDevice.count(), vImgFile.count());
+  for (int i = 0; i < vImgFile.count(); ++i) {
+    QVERIFY2(vImgDevice[i] == vImgFile[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+}
+
+void TestLibApng::mappedReaderTest()
+{
+  using namespace png;
+
+  QFile f(":/data/validApng1.png");
+  QVERIFY(f.open(QFile::ReadOnly));
+  QTemporaryFile tf;
+  QVERIFY(tf.open());
+  tf.write(f.readAll());
+  tf.close();
+  f.close();
+
+  Reader readerStream;
+  auto vbaStream = readerStream.import(tf.fileName());
+
+  Reader readerMapped;
+  readerMapped.setReadMode(Reader::ReadMode::ermMapped);
+  auto vbaMapped = readerMapped.import(tf.fileName());
+
+  QVERIFY(readerMapped.info().isOk());
+  QCOMPARE(readerMapped.info().type(), readerStream.info().type());
+  QCOMPARE(readerMapped.info().fps(), readerStream.info().fps());
+  QCOMPARE(readerMapped.info().framesCount(), readerStream.info().framesCount());
+  QCOMPARE(vbaMapped, vbaStream);
+}
+
+void TestLibApng::nativeDecoderTest()
+{
+  using namespace png;
+  Reader reader;
+
+  // the natively decoded frames have to match the standalone PNG files loaded by Qt
+  auto vba  = reader.import(":/data/validApng1.png");
+  auto vImg = reader.importImages(":/data/validApng1.png");
+  QVERIFY(reader.info().isOk());
+  QCOMPARE(vImg.count(), vba.count());
+  for (int i = 0; i < vba.count(); ++i) {
+    QImage img;
+    QVERIFY(img.loadFromData(vba[i], "PNG"));
+    QVERIFY2(img.convertToFormat(vImg[i].format()) == vImg[i],
+             QString("Frame %1 differs").arg(i).toLatin1());
+  }
+}
+
+void TestLibApng::colorTypeTest_data()
+{
+  QTest::addColumn<QImage::Format>("format");
+
+  QTest::newRow("Indexed8") << QImage::Format_Indexed8;
+  QTest::newRow("Grayscale8") << QImage::Format_Grayscale8;
+  QTest::newRow("Grayscale16") << QImage::Format_Grayscale16;
+  QTest::newRow("RGB32") << QImage::Format_RGB32;
+  QTest::newRow("ARGB32") << QImage::Format_ARGB32;
+  QTest::newRow("RGBX64") << QImage::Format_RGBX64;
+  QTest::newRow("RGBA64") << QImage::Format_RGBA64;
+}
+
+void TestLibApng::colorTypeTest()
+{
+  using namespace png;
+  QFETCH(QImage::Format, format);
+  Writer writer;
+  Reader reader;
+
+  // every format is stored with its own color type and bit depth, so the frames, which are not
+  // composed onto the canvas yet, are decoded unchanged
+  QVector<QImage> vImg;
+  for (int i = 0; i < 3; ++i) {
+    vImg << prepareImage(i).convertToFormat(format);
+    writer.append(&vImg.last());
+  }
+
+  QTemporaryFile tf;
+  tf.open();
+  tf.close();
+  QVERIFY(writer.exportAPNG(tf.fileName(), 30));
+
+  QVERIFY(reader.open(tf.fileName()));
+  QCOMPARE(reader.info().framesCount(), quint32(vImg.count()));
+  for (int i = 0; i < vImg.count(); ++i) {
+    auto img = reader.frame(i);
+    QCOMPARE(img.format(), format);
+    QVERIFY2(img == vImg[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+}
+
+void TestLibApng::parallelDecodeTest()
+{
+  using namespace png;
+  Reader reader;
+
+  reader.setThreadPool(nullptr);
+  auto vImgSerial = reader.importImages(":/data/validApng2.png");
+  QVERIFY(reader.info().isOk());
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(4);
+  reader.setThreadPool(&pool);
+  reader.setMaxConcurrency(3);
+  auto vImgParallel = reader.importImages(":/data/validApng2.png");
+  QVERIFY(reader.info().isOk());
+
+  QCOMPARE(vImgParallel.count(), vImgSerial.count());
+  for (int i = 0; i < vImgSerial.count(); ++i) {
+    QVERIFY2(vImgParallel[i] == vImgSerial[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+}
+
+void TestLibApng::frameIndexTest()
+{
+  using namespace png;
+  Reader reader;
+
+  auto vImg = reader.importImages(":/data/validApng2.png");
+  QVERIFY(reader.open(":/data/validApng2.png"));
+  QCOMPARE(reader.frameCount(), 50);
+  QCOMPARE(reader.frameCount(), vImg.count());
+  for (int i : {49, 0, 17}) {
+    auto fc = reader.frameControl(i);
+    QCOMPARE(fc.m_uiSequence, i == 0 ? 0U : quint32(2 * i - 1));
+    QCOMPARE(QSize(int(fc.m_uiWidth), int(fc.m_uiHeight)), QSize(300, 300));
+    QCOMPARE(fc.delay(), 50U);
+    QVERIFY2(reader.frame(i) == vImg[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+  QVERIFY(reader.frame(50).isNull());
+
+  QVERIFY(reader.open(":/data/noIend.png") == false);
+}
+
+void TestLibApng::seekTest()
+{
+  using namespace png;
+  Reader reader;
+
+  auto vImg = reader.importImages(":/data/validApng2.png");
+  QVERIFY(reader.open(":/data/validApng2.png"));
+  // all the frames cover the whole image with the SOURCE blend operation
+  for (int i = 0; i < reader.frameCount(); ++i) {
+    QVERIFY2(reader.isKeyframe(i), QString("Frame %1 is not a keyframe").arg(i).toLatin1());
+  }
+  QVERIFY(reader.isKeyframe(50) == false);
+
+  reader.setSnapshotBudget(4 * vImg.first().sizeInBytes());
+  reader.setSnapshotInterval(4);
+  for (int i : {49, 0, 17, 18, 19, 3, 49}) {
+    QVERIFY2(reader.composedFrame(i) == vImg[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+  QVERIFY(reader.composedFrame(50).isNull());
+
+  // a sprite moves over the gradient and every second frame flashes a square, which is disposed to
+  // the previous content, so only the first frame is a keyframe
+  auto scene = [](int iPos, bool bFlash) {
+    QImage img(64, 64, QImage::Format_ARGB32);
+    for (int y = 0; y < img.height(); ++y) {
+      for (int x = 0; x < img.width(); ++x) {
+        bool bSprite = (x >= iPos * 5 % 56) && (x < iPos * 5 % 56 + 8) && (y >= iPos * 3 % 56) &&
+                       (y < iPos * 3 % 56 + 8);
+        bool bSquare = (bFlash == true) && (x >= 20) && (x < 44) && (y >= 20) && (y < 44) &&
+                       ((x + y) % 3 != 0);
+        img.setPixel(x, y, bSquare ? qRgb(255, 0, 0)
+                                   : (bSprite ? qRgb(255, 255, 0) : qRgb(x * 4, y * 4, 128)));
+      }
+    }
+    return img;
+  };
+
+  QVector<QImage> vScene;
+  Writer writer;
+  writer.setDeltaFrames(true);
+  writer.setOptimization(Writer::Optimization::eoSize);
+  for (int i = 0; i < 40; ++i) {
+    vScene << scene(i / 2, i % 2 == 1);
+    QVERIFY(writer.append(&vScene.last()));
+  }
+
+  QTemporaryFile tf;
+  tf.open();
+  tf.close();
+  QVERIFY(writer.exportAPNG(tf.fileName(), 10));
+
+  Reader delta;
+  QVERIFY(delta.open(tf.fileName()));
+  QCOMPARE(delta.frameCount(), vScene.count());
+  int iPrevious = 0;
+  int iOver     = 0;
+  for (int i = 1; i < delta.frameCount(); ++i) {
+    auto fc = delta.frameControl(i);
+    QVERIFY(delta.isKeyframe(i) == false);
+    QVERIFY((fc.m_uiWidth < 64U) || (fc.m_uiHeight < 64U));
+    iPrevious += (fc.m_uiDispose == FrameControl::edoPrevious ? 1 : 0);
+    iOver += (fc.m_uiBlend == FrameControl::eboOver ? 1 : 0);
+  }
+  QVERIFY(iPrevious > 0);
+  QVERIFY(iOver > 0);
+
+  // the seeks go back and forth across the snapshots, which only three of fit into the budget
+  const qint64 ciCanvas = vScene.first().sizeInBytes();
+  delta.setSnapshotInterval(4);
+  delta.setSnapshotBudget(3 * ciCanvas);
+  for (int i : {39, 2, 21, 13, 5, 38, 0, 17}) {
+    QVERIFY2(delta.composedFrame(i) == vScene[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+  QCOMPARE(delta.snapshotUsage(), 3 * ciCanvas);
+
+  // the smaller budget evicts the snapshots, the seeks replay from the ones left
+  delta.setSnapshotBudget(ciCanvas);
+  QCOMPARE(delta.snapshotUsage(), ciCanvas);
+  for (int i : {30, 9, 3, 39, 8}) {
+    QVERIFY2(delta.composedFrame(i) == vScene[i], QString("Frame %1 differs").arg(i).toLatin1());
+  }
+
+  delta.setSnapshotBudget(0);
+  QCOMPARE(delta.snapshotUsage(), qint64(0));
+  QVERIFY(delta.composedFrame(25) == vScene[25]);
+}
+
+void TestLibApng::compositorTest()
+{
+  using namespace png;
+  Compositor compositor;
+  QVERIFY(compositor.reset(QSize(4, 4)));
+  QCOMPARE(compositor.canvas().pixel(2, 2), qRgba(0, 0, 0, 0));
+
+  FrameControl fc;
+  fc.m_uiWidth  = 4;
+  fc.m_uiHeight = 4;
+  QImage imgBlue(4, 4, QImage::Format_ARGB32);
+  imgBlue.fill(qRgba(0, 0, 255, 255));
+  QVERIFY(compositor.compose(imgBlue, fc));
+
+  // half transparent red over blue, restored afterwards
+  fc.m_uiX       = 1;
+  fc.m_uiY       = 1;
+  fc.m_uiWidth   = 2;
+  fc.m_uiHeight  = 2;
+  fc.m_uiBlend   = FrameControl::eboOver;
+  fc.m_uiDispose = FrameControl::edoPrevious;
+  QImage imgRed(2, 2, QImage::Format_ARGB32);
+  imgRed.fill(qRgba(255, 0, 0, 128));
+  QVERIFY(compositor.compose(imgRed, fc));
+  QCOMPARE(compositor.canvas().pixel(0, 0), qRgba(0, 0, 255, 255));
+  QCOMPARE(compositor.canvas().pixel(1, 1), qRgba(128, 0, 127, 255));
+
+  // transparent pixel replacing the canvas, cleared afterwards
+  fc.m_uiX       = 3;
+  fc.m_uiY       = 3;
+  fc.m_uiWidth   = 1;
+  fc.m_uiHeight  = 1;
+  fc.m_uiBlend   = FrameControl::eboSource;
+  fc.m_uiDispose = FrameControl::edoBackground;
+  QImage imgClear(1, 1, QImage::Format_ARGB32);
+  imgClear.fill(qRgba(10, 20, 30, 0));
+  QVERIFY(compositor.compose(imgClear, fc));
+  QCOMPARE(compositor.canvas().pixel(1, 1), qRgba(0, 0, 255, 255));
+  QCOMPARE(compositor.canvas().pixel(3, 3), qRgba(10, 20, 30, 0));
+
+  fc.m_uiX       = 0;
+  fc.m_uiY       = 0;
+  fc.m_uiDispose = FrameControl::edoNone;
+  QImage imgGreen(1, 1, QImage::Format_ARGB32);
+  imgGreen.fill(qRgba(0, 255, 0, 255));
+  QVERIFY(compositor.compose(imgGreen, fc));
+  QCOMPARE(compositor.canvas().pixel(0, 0), qRgba(0, 255, 0, 255));
+  QCOMPARE(compositor.canvas().pixel(3, 3), qRgba(0, 0, 0, 0));
+  QCOMPARE(compositor.canvas().pixel(2, 3), qRgba(0, 0, 255, 255));
+}
+
+void TestLibApng::blendKernels()
+{
+  using namespace png;
+  Blend blend;
+
+  // every pair of 8-bit alpha values, with the extreme channel values mixed in
+  QVector<QRgb> vSrc;
+  QVector<QRgb> vDst;
+  for (int iSA = 0; iSA < 256; ++iSA) {
+    for (int iDA = 0; iDA < 256; ++iDA) {
+      int iC = (iSA * 31 + iDA * 17) & 255;
+      vSrc << qRgba(iC, 255 - iC, iSA & 1 ? 255 : 0, iSA);
+      vDst << qRgba(255 - iC, iDA & 1 ? 0 : 255, iC, iDA);
+    }
+  }
+
+  // odd lengths and offsets exercise the tails of the accelerated paths
+  for (int iOffset : {0, 1, 3}) {
+    auto vExpected = vDst;
+    auto vActual   = vDst;
+    int iCount     = vSrc.count() - 2 * iOffset - 1;
+    Blend::reference(vSrc.constData() + iOffset, vExpected.data() + iOffset, iCount);
+    blend.over(vSrc.constData() + iOffset, vActual.data() + iOffset, iCount);
+    QCOMPARE(vActual, vExpected);
+  }
+
+  QVector<QRgba64> vSrc64;
+  QVector<QRgba64> vDst64;
+  for (int i = 0; i < 100000; ++i) {
+    quint16 uiA = quint16(i * 7919);
+    quint16 uiB = quint16(quint32(i) * 104729U >> 3);
+    vSrc64 << QRgba64::fromRgba64(uiA, uiB, 65535, i % 3 == 0 ? 65535 - uiB : uiA);
+    vDst64 << QRgba64::fromRgba64(uiB, 0, uiA, i % 5 == 0 ? 0 : uiB);
+  }
+
+  auto vExpected64 = vDst64;
+  auto vActual64   = vDst64;
+  Blend::reference(vSrc64.constData(), vExpected64.data(), vSrc64.count());
+  blend.over(vSrc64.constData(), vActual64.data(), vSrc64.count());
+  for (int i = 0; i < vSrc64.count(); ++i)
+    QVERIFY2(quint64(vActual64[i]) == quint64(vExpected64[i]), QString::number(i).toLatin1());
+}
+
+void TestLibApng::filterKernels()
+{
+  using namespace png;
+  Filter filter;
+
+  // the rows of random, flat and saturated bytes exercise every branch of the Paeth predictor
+  QByteArray baRow(1027, Qt::Uninitialized);
+  QByteArray baPrior(1027, Qt::Uninitialized);
+  for (int i = 0; i < baRow.size(); ++i) {
+    baRow[i]   = char(i < 400 ? (i * 7919) >> 3 : (i < 700 ? 255 * (i & 1) : 128));
+    baPrior[i] = char(i % 5 == 0 ? 0 : (i * 104729) >> 5);
+  }
+
+  auto pRow   = reinterpret_cast<const uchar*>(baRow.constData());
+  auto pPrior = reinterpret_cast<const uchar*>(baPrior.constData());
+  // odd lengths exercise the tails of the accelerated paths
+  for (int iBpp : {1, 2, 3, 4, 6, 8}) {
+    for (quint32 uiBytes : {5U, 16U, 1027U - quint32(1027 % iBpp)}) {
+      for (quint8 uiType = Filter::eftNone; uiType <= Filter::eftPaeth; ++uiType) {
+        QByteArray baExpected(int(uiBytes), char(0));
+        QByteArray baActual(int(uiBytes), char(0));
+        auto pExpected = reinterpret_cast<uchar*>(baExpected.data());
+        auto pActual   = reinterpret_cast<uchar*>(baActual.data());
+        QVERIFY(Filter::referenceFilter(uiType, pExpected, pRow, pPrior, uiBytes, iBpp));
+        QVERIFY(filter.filter(uiType, pActual, pRow, pPrior, uiBytes, iBpp));
+        QCOMPARE(baActual, baExpected);
+        QCOMPARE(filter.cost(pActual, uiBytes), Filter::referenceCost(pExpected, uiBytes));
+
+        QVERIFY(filter.unfilter(uiType, pActual, pPrior, uiBytes, iBpp));
+        QCOMPARE(baActual, baRow.left(int(uiBytes)));
+      }
+    }
+  }
+
+  QByteArray baDst(16, char(0));
+  QVERIFY(filter.filter(5, reinterpret_cast<uchar*>(baDst.data()), pRow, pPrior, 16, 1) == false);
+  QVERIFY(filter.unfilter(5, reinterpret_cast<uchar*>(baDst.data()), pPrior, 16, 1) == false);
+}
+
 void TestLibApng::errorChecking_data()
 {
   using namespace png;
@@ -198,6 +1223,10 @@ void TestLibApng::errorChecking_data()
                                    << Info::ParseError::epeNone;
   QTest::addRow("APNG file without ACTL") << ":/data/noActlApng.png" << Info::Type::etAPNG << 20U << 50U
                                            << Info::ParseError::epeNoACTL;
+  QTest::addRow("Reordered frames") << ":/data/wrongSequence.png" << Info::Type::etAPNG << 30U
+                                    << 10U << Info::ParseError::epeSequence;
+  QTest::addRow("Invalid fcTL chunk") << ":/data/invalidFctl.png" << Info::Type::etAPNG << 30U
+                                      << 10U << Info::ParseError::epeFrameControl;
 }
 
 void TestLibApng::errorChecking()